@@ -323,6 +323,20 @@ bool BamReader::Rewind()
     return d->Rewind();
 }
 
+/*! \fn void BamReader::SetCache(BamReaderCache* cache)
+    \brief Shares the BGZF blocks & index data with the other readers of a cache.
+
+    \note Only affects the BAM file & index opened after the call. The cache
+    must outlive the reader.
+
+    \param[in] cache data shared by a group of readers (0 = none)
+    \sa BamReaderCache
+*/
+void BamReader::SetCache(BamReaderCache* cache)
+{
+    d->SetCache(cache);
+}
+
 /*! \fn void BamReader::SetIndex(BamIndex* index)
     \brief Sets a custom BamIndex on this reader.
 
@@ -18,6 +18,8 @@
 
 namespace BamTools {
 
+class BamReaderCache;
+
 namespace Internal {
 class BamReaderPrivate;
 }  // namespace Internal
@@ -107,6 +109,13 @@ public:
     // returns a human-readable description of the last error that occurred
     std::string GetErrorString() const;
 
+    // ----------------------
+    // shared data
+    // ----------------------
+
+    // shares the BGZF blocks & index data with the other readers of a cache
+    void SetCache(BamReaderCache* cache);
+
     // private implementation
 private:
     Internal::BamReaderPrivate* d;
@@ -0,0 +1,87 @@
+// ***************************************************************************
+// BamReaderCache.cpp
+// ---------------------------------------------------------------------------
+// Provides the data shared by a group of BamReaders: the inflated BGZF blocks
+// and the standard (.bai) indexes loaded in memory.
+// ***************************************************************************
+
+#include "api/BamReaderCache.h"
+#include "api/internal/index/BamStandardIndex_p.h"
+#include "api/internal/io/BgzfBlockCache_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+/*! \class BamTools::BamReaderCache
+    \brief Provides the data shared by a group of BamReaders.
+
+    Decompressed BGZF blocks are kept in a cache shared by the readers of the
+    group, so that readers of the same file (e.g. on different threads)
+    decompress each block only once. Least recently used blocks are evicted.
+
+    With shared indexes, the first reader opening a standard (.bai) index file
+    loads all of its bins & linear offsets and closes the file. The other readers
+    of the group then use that data, so region lookups do not touch the disk.
+    The data is released when the last reader using it closes its index.
+
+    The cache must outlive the readers using it.
+
+    \sa BamReader::SetCache()
+*/
+
+/*! \fn BamReaderCache::BamReaderCache(std::size_t blockCacheBytes, bool sharedIndexes)
+    \brief constructor
+
+    \param[in] blockCacheBytes maximum size of the decompressed blocks held (0 disables the cache)
+    \param[in] sharedIndexes   load the standard indexes once in memory for the whole group
+*/
+BamReaderCache::BamReaderCache(std::size_t blockCacheBytes, bool sharedIndexes)
+    : m_blockCache(0)
+    , m_indexRegistry(0)
+{
+    if (blockCacheBytes > 0) m_blockCache = new BgzfBlockCache(blockCacheBytes);
+    if (sharedIndexes) m_indexRegistry = new BaiIndexRegistry;
+}
+
+/*! \fn BamReaderCache::~BamReaderCache()
+    \brief destructor
+*/
+BamReaderCache::~BamReaderCache()
+{
+    delete m_blockCache;
+    m_blockCache = 0;
+    delete m_indexRegistry;
+    m_indexRegistry = 0;
+}
+
+/*! \fn Internal::BgzfBlockCache* BamReaderCache::BlockCache() const
+    \internal
+    \returns the BGZF block cache (0 if disabled)
+*/
+BgzfBlockCache* BamReaderCache::BlockCache() const
+{
+    return m_blockCache;
+}
+
+/*! \fn void BamReaderCache::GetBlockCacheStats(uint64_t& hits, uint64_t& misses) const
+    \brief Retrieves the BGZF block cache statistics.
+
+    The counters cover all readers of the group.
+
+    \param[out] hits   number of blocks found in the cache
+    \param[out] misses number of blocks read & decompressed from file
+*/
+void BamReaderCache::GetBlockCacheStats(uint64_t& hits, uint64_t& misses) const
+{
+    hits = 0;
+    misses = 0;
+    if (m_blockCache) m_blockCache->GetStats(hits, misses);
+}
+
+/*! \fn Internal::BaiIndexRegistry* BamReaderCache::IndexRegistry() const
+    \internal
+    \returns the index data loaded by the readers of the group (0 if indexes are not shared)
+*/
+BaiIndexRegistry* BamReaderCache::IndexRegistry() const
+{
+    return m_indexRegistry;
+}
@@ -0,0 +1,55 @@
+// ***************************************************************************
+// BamReaderCache.h
+// ---------------------------------------------------------------------------
+// Provides the data shared by a group of BamReaders: the inflated BGZF blocks
+// and the standard (.bai) indexes loaded in memory.
+// ***************************************************************************
+
+#ifndef BAMREADERCACHE_H
+#define BAMREADERCACHE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include "api/api_global.h"
+
+namespace BamTools {
+
+namespace Internal {
+class BgzfBlockCache;
+struct BaiIndexRegistry;
+}  // namespace Internal
+
+class API_EXPORT BamReaderCache
+{
+
+    // constructor / destructor
+public:
+    BamReaderCache(std::size_t blockCacheBytes, bool sharedIndexes);
+    ~BamReaderCache();
+
+    // public interface
+public:
+    // retrieves the lookups found/not found in the BGZF block cache
+    void GetBlockCacheStats(uint64_t& hits, uint64_t& misses) const;
+
+    // internal methods (used by the readers of the group)
+public:
+    // returns the BGZF block cache (0 = disabled)
+    Internal::BgzfBlockCache* BlockCache() const;
+    // returns the index data already loaded (0 = indexes not shared)
+    Internal::BaiIndexRegistry* IndexRegistry() const;
+
+    // not copyable
+private:
+    BamReaderCache(const BamReaderCache&);
+    BamReaderCache& operator=(const BamReaderCache&);
+
+    // data members
+private:
+    Internal::BgzfBlockCache* m_blockCache;
+    Internal::BaiIndexRegistry* m_indexRegistry;
+};
+
+}  // namespace BamTools
+
+#endif  // BAMREADERCACHE_H
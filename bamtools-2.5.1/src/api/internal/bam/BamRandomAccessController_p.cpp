@@ -240,6 +240,7 @@ bool BamRandomAccessController::OpenIndex(const std::string& indexFilename,
         const std::string message = std::string("could not load index data from file: ") +
                                     indexFilename + "\n\t" + indexError;
         SetErrorString("BamRandomAccessController::OpenIndex", message);
+        delete index;
         return false;
     }
 
@@ -10,6 +10,7 @@
 #include "api/internal/bam/BamReader_p.h"
 #include "api/BamConstants.h"
 #include "api/BamReader.h"
+#include "api/BamReaderCache.h"
 #include "api/IBamIODevice.h"
 #include "api/internal/bam/BamHeader_p.h"
 #include "api/internal/bam/BamRandomAccessController_p.h"
@@ -30,6 +31,7 @@ using namespace BamTools::Internal;
 BamReaderPrivate::BamReaderPrivate(BamReader* parent)
     : m_alignmentsBeginOffset(0)
     , m_parent(parent)
+    , m_cache(0)
 {
     m_isBigEndian = BamTools::SystemIsBigEndian();
 }
@@ -486,6 +488,7 @@ bool BamReaderPrivate::Open(const std::string& filename)
         Close();
 
         // open BgzfStream
+        m_stream.SetBlockCache(m_cache ? m_cache->BlockCache() : 0);
         m_stream.Open(filename, IBamIODevice::ReadOnly);
 
         // load BAM metadata
@@ -565,6 +568,12 @@ void BamReaderPrivate::SetErrorString(const std::string& where, const std::strin
     m_errorString = where + SEPARATOR + what;
 }
 
+// sets the data shared with other readers (used by the next Open/OpenIndex)
+void BamReaderPrivate::SetCache(BamReaderCache* cache)
+{
+    m_cache = cache;
+}
+
 void BamReaderPrivate::SetIndex(BamIndex* index)
 {
     m_randomAccessController.SetIndex(index);
@@ -70,6 +70,9 @@ public:
     bool OpenIndex(const std::string& indexFilename);
     void SetIndex(BamIndex* index);
 
+    // data shared with other readers
+    void SetCache(BamReaderCache* cache);
+
     // error handling
     std::string GetErrorString() const;
     void SetErrorString(const std::string& where, const std::string& what);
@@ -104,6 +107,9 @@ public:
     // parent BamReader
     BamReader* m_parent;
 
+    // data shared with other readers (0 = none, not owned)
+    BamReaderCache* m_cache;
+
     // BamReaderPrivate components
     BamHeader m_header;
     BamRandomAccessController m_randomAccessController;
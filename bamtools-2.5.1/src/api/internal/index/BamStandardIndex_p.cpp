@@ -9,17 +9,22 @@
 
 #include "api/internal/index/BamStandardIndex_p.h"
 #include "api/BamAlignment.h"
+#include "api/BamReaderCache.h"
 #include "api/internal/bam/BamReader_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
+#include <sys/stat.h>
 #include <algorithm>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
 // -----------------------------------
@@ -184,6 +189,30 @@ void BamStandardIndex::CalculateCandidateOffsets(const BaiReferenceSummary& refS
     }
 }
 
+void BamStandardIndex::CalculateCandidateOffsets(const BaiReferenceEntry& refEntry,
+                                                 const uint64_t& minOffset,
+                                                 std::set<uint16_t>& candidateBins,
+                                                 std::vector<int64_t>& offsets)
+{
+    // look up each candidate bin in the reference's bins
+    std::set<uint16_t>::const_iterator candidateBinIter = candidateBins.begin();
+    std::set<uint16_t>::const_iterator candidateBinEnd = candidateBins.end();
+    for (; candidateBinIter != candidateBinEnd; ++candidateBinIter) {
+
+        const BaiBinMap::const_iterator binIter = refEntry.Bins.find(*candidateBinIter);
+        if (binIter == refEntry.Bins.end()) continue;
+
+        // store alignment chunk's start offset
+        // if its stop offset is larger than our 'minOffset'
+        const BaiAlignmentChunkVector& chunks = binIter->second;
+        BaiAlignmentChunkVector::const_iterator chunkIter = chunks.begin();
+        BaiAlignmentChunkVector::const_iterator chunkEnd = chunks.end();
+        for (; chunkIter != chunkEnd; ++chunkIter) {
+            if (chunkIter->Stop >= minOffset) offsets.push_back(chunkIter->Start);
+        }
+    }
+}
+
 uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceSummary& refSummary,
                                               const uint32_t& begin)
 {
@@ -199,6 +228,22 @@ uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceSummary& refSumm
         return LookupLinearOffset(refSummary, shiftedBegin);
 }
 
+uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceEntry& refEntry,
+                                              const uint32_t& begin)
+{
+    // if no linear offsets exist, return 0
+    const BaiLinearOffsetVector& linearOffsets = refEntry.LinearOffsets;
+    if (linearOffsets.empty()) return 0;
+
+    // if 'begin' starts beyond last linear offset, use the last linear offset as minimum
+    // else use the offset corresponding to the requested start position
+    const std::size_t shiftedBegin = begin >> BamStandardIndex::BAM_LIDX_SHIFT;
+    if (shiftedBegin >= linearOffsets.size())
+        return linearOffsets.back();
+    else
+        return linearOffsets[shiftedBegin];
+}
+
 void BamStandardIndex::CheckBufferSize(char*& buffer, unsigned int& bufferLength,
                                        const unsigned int& requestedBytes)
 {
@@ -457,13 +502,19 @@ void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset,
     CalculateCandidateBins(begin, end, candidateBins);
 
     // use reference's linear offsets to calculate the minimum offset
-    // that must be considered to find overlap
-    const uint64_t& minOffset = CalculateMinOffset(refSummary, begin);
+    // that must be considered to find overlap, then use it & candidateBins
+    // to calculate offsets (from memory in shared mode, from the index file otherwise)
+    std::vector<int64_t> offsets;
+    if (m_indexData) {
+        const BaiReferenceEntry& refEntry = m_indexData->at(region.LeftRefID);
+        const uint64_t minOffset = CalculateMinOffset(refEntry, begin);
+        CalculateCandidateOffsets(refEntry, minOffset, candidateBins, offsets);
+    } else {
+        const uint64_t minOffset = CalculateMinOffset(refSummary, begin);
+        CalculateCandidateOffsets(refSummary, minOffset, candidateBins, offsets);
+    }
 
-    // attempt to use reference summary, minOffset, & candidateBins to calculate offsets
     // no data should not be error, just bail
-    std::vector<int64_t> offsets;
-    CalculateCandidateOffsets(refSummary, minOffset, candidateBins, offsets);
     if (offsets.empty()) return;
 
     // ensure that offsets are sorted before processing
@@ -560,6 +611,13 @@ bool BamStandardIndex::Load(const std::string& filename)
 
     try {
 
+        // use (or load) the index data shared with the other readers
+        BamReaderCache* cache = m_reader->m_cache;
+        if (cache && cache->IndexRegistry()) {
+            LoadShared(filename, *cache->IndexRegistry());
+            return true;
+        }
+
         // attempt to open file (read-only)
         OpenFile(filename, IBamIODevice::ReadOnly);
 
@@ -578,6 +636,125 @@ bool BamStandardIndex::Load(const std::string& filename)
     }
 }
 
+// loads full index data from file into memory
+void BamStandardIndex::LoadIndexData(BaiIndexData& indexData)
+{
+    // load number of reference sequences
+    int numReferences;
+    ReadNumReferences(numReferences);
+
+    // load each reference's bins & linear offsets
+    indexData.assign(numReferences, BaiReferenceEntry());
+    for (int i = 0; i < numReferences; ++i) {
+        indexData[i].ID = i;
+        LoadReferenceEntry(indexData[i]);
+    }
+}
+
+void BamStandardIndex::LoadReferenceEntry(BaiReferenceEntry& refEntry)
+{
+    // load bins
+    int numBins;
+    ReadNumBins(numBins);
+
+    uint32_t binId;
+    int32_t numAlignmentChunks;
+    for (int i = 0; i < numBins; ++i) {
+
+        // read bin contents (if successful, alignment chunks are now in m_buffer)
+        ReadBinIntoBuffer(binId, numAlignmentChunks);
+
+        // as when reading the index file, only the first entry of a bin is used
+        if (refEntry.Bins.find(binId) != refEntry.Bins.end()) continue;
+        BaiAlignmentChunkVector& chunks = refEntry.Bins[binId];
+        chunks.reserve(numAlignmentChunks);
+
+        std::size_t offset = 0;
+        uint64_t chunkStart;
+        uint64_t chunkStop;
+        for (int j = 0; j < numAlignmentChunks; ++j) {
+
+            // read chunk start & stop from buffer
+            memcpy((char*)&chunkStart, m_resources.Buffer + offset, sizeof(uint64_t));
+            offset += sizeof(uint64_t);
+            memcpy((char*)&chunkStop, m_resources.Buffer + offset, sizeof(uint64_t));
+            offset += sizeof(uint64_t);
+
+            // swap endian-ness if necessary
+            if (m_isBigEndian) {
+                SwapEndian_64(chunkStart);
+                SwapEndian_64(chunkStop);
+            }
+
+            chunks.push_back(BaiAlignmentChunk(chunkStart, chunkStop));
+        }
+    }
+
+    // load linear offsets
+    int numLinearOffsets;
+    ReadNumLinearOffsets(numLinearOffsets);
+    if (numLinearOffsets <= 0) return;
+
+    ReadIntoBuffer(numLinearOffsets * BamStandardIndex::SIZEOF_LINEAROFFSET);
+    refEntry.LinearOffsets.resize(numLinearOffsets);
+    memcpy((char*)&refEntry.LinearOffsets[0], m_resources.Buffer,
+           numLinearOffsets * BamStandardIndex::SIZEOF_LINEAROFFSET);
+
+    // swap endian-ness if necessary
+    if (m_isBigEndian) {
+        for (int i = 0; i < numLinearOffsets; ++i)
+            SwapEndian_64(refEntry.LinearOffsets[i]);
+    }
+}
+
+// uses the index data of a file already loaded by another reader,
+// or loads it (the index file is closed afterwards)
+void BamStandardIndex::LoadShared(const std::string& filename, BaiIndexRegistry& registry)
+{
+    // the data is shared by file identity, not by name
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        const std::string message = std::string("could not open file: ") + filename;
+        throw BamException("BamStandardIndex::LoadShared", message);
+    }
+    BaiFileKey key;
+    key.Device = static_cast<uint64_t>(st.st_dev);
+    key.Inode = static_cast<uint64_t>(st.st_ino);
+    key.Size = static_cast<int64_t>(st.st_size);
+    key.ModTime = static_cast<int64_t>(st.st_mtime);
+
+    std::lock_guard<std::mutex> guard(registry.Lock);
+
+    // drop the entries of the files no longer used by any reader
+    std::map<BaiFileKey, std::weak_ptr<const BaiIndexData> >::iterator it =
+        registry.Indexes.begin();
+    while (it != registry.Indexes.end()) {
+        if (it->second.expired())
+            registry.Indexes.erase(it++);
+        else
+            ++it;
+    }
+
+    std::shared_ptr<const BaiIndexData> indexData = registry.Indexes[key].lock();
+    if (!indexData) {
+
+        // attempt to open file (read-only) & validate format
+        OpenFile(filename, IBamIODevice::ReadOnly);
+        CheckMagicNumber();
+
+        // load all index data
+        std::shared_ptr<BaiIndexData> loadedData(new BaiIndexData);
+        LoadIndexData(*loadedData);
+        CloseFile();
+
+        indexData = loadedData;
+        registry.Indexes[key] = indexData;
+    }
+
+    m_indexData = indexData;
+    SummarizeIndexData();
+}
+
 uint64_t BamStandardIndex::LookupLinearOffset(const BaiReferenceSummary& refSummary,
                                               const int& index)
 {
@@ -841,6 +1018,17 @@ void BamStandardIndex::SummarizeBins(BaiReferenceSummary& refSummary)
     SkipBins(numBins);
 }
 
+// builds the index summary (bin & linear offset counts) from in-memory index data
+void BamStandardIndex::SummarizeIndexData()
+{
+    ReserveForSummary(m_indexData->size());
+    for (std::size_t i = 0; i < m_indexData->size(); ++i) {
+        const BaiReferenceEntry& refEntry = m_indexData->at(i);
+        m_indexFileSummary[i].NumBins = refEntry.Bins.size();
+        m_indexFileSummary[i].NumLinearOffsets = refEntry.LinearOffsets.size();
+    }
+}
+
 void BamStandardIndex::SummarizeIndexFile()
 {
 
@@ -21,6 +21,8 @@
 // We mean it.
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -102,6 +104,36 @@ struct BaiReferenceSummary
 // convenience typedef for describing a full BAI index file summary
 typedef std::vector<BaiReferenceSummary> BaiFileSummary;
 
+// full BAI index data (one entry per reference), kept in memory & never modified
+// after loading, so that it can be shared by all readers of the same BAM file
+typedef std::vector<BaiReferenceEntry> BaiIndexData;
+
+// identity of a BAI file: a file replaced or rewritten under the same name
+// is loaded again instead of using the data of the old file
+struct BaiFileKey
+{
+    uint64_t Device;
+    uint64_t Inode;
+    int64_t Size;
+    int64_t ModTime;
+
+    bool operator<(const BaiFileKey& other) const
+    {
+        if (Device != other.Device) return Device < other.Device;
+        if (Inode != other.Inode) return Inode < other.Inode;
+        if (Size != other.Size) return Size < other.Size;
+        return ModTime < other.ModTime;
+    }
+};
+
+// index data of the files loaded by a group of readers (shared mode), each
+// entry released when the last reader using it closes its index
+struct BaiIndexRegistry
+{
+    std::mutex Lock;
+    std::map<BaiFileKey, std::weak_ptr<const BaiIndexData> > Indexes;
+};
+
 // end BamStandardIndex data structures
 // -----------------------------------------------------------------------------
 
@@ -163,6 +195,18 @@ private:
     void GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion);
     uint64_t LookupLinearOffset(const BaiReferenceSummary& refSummary, const int& index);
 
+    // in-memory random-access methods
+    void CalculateCandidateOffsets(const BaiReferenceEntry& refEntry, const uint64_t& minOffset,
+                                   std::set<uint16_t>& candidateBins,
+                                   std::vector<int64_t>& offsets);
+    uint64_t CalculateMinOffset(const BaiReferenceEntry& refEntry, const uint32_t& begin);
+
+    // BAI full index (shared mode) loading methods
+    void LoadIndexData(BaiIndexData& indexData);
+    void LoadReferenceEntry(BaiReferenceEntry& refEntry);
+    void LoadShared(const std::string& filename, BaiIndexRegistry& registry);
+    void SummarizeIndexData();
+
     // BAI summary (create/load) methods
     void ReserveForSummary(const int& numReferences);
     void SaveBinsSummary(const int& refId, const int& numBins);
@@ -199,6 +243,7 @@ private:
 private:
     bool m_isBigEndian;
     BaiFileSummary m_indexFileSummary;
+    std::shared_ptr<const BaiIndexData> m_indexData;  // full index (shared mode only)
 
     // our input buffer
     unsigned int m_bufferLength;
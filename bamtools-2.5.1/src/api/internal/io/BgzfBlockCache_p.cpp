@@ -0,0 +1,147 @@
+// ***************************************************************************
+// BgzfBlockCache_p.cpp
+// ---------------------------------------------------------------------------
+// Provides a cache of inflated BGZF blocks, shared by the BgzfStreams of a
+// group of readers (keyed by file identity & compressed offset).
+//
+// implementation note: bounded LRU split in shards, each with its own lock,
+// so that readers running on different threads seldom contend
+// ***************************************************************************
+
+#include "api/internal/io/BgzfBlockCache_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <sys/stat.h>
+#include <cstring>
+
+// -------------------------------
+// BgzfBlockCache implementation
+// -------------------------------
+
+// constructor (holds at most bytes of inflated blocks)
+BgzfBlockCache::BgzfBlockCache(const std::size_t bytes)
+    : m_capacity(bytes)
+    , m_hits(0)
+    , m_misses(0)
+    , m_nextFileId(0)
+{}
+
+// evicts the least recently used blocks of a (locked) shard above its capacity
+void BgzfBlockCache::Evict(Shard& shard, const std::size_t shardCapacity)
+{
+    while (shard.Size > shardCapacity && !shard.Blocks.empty()) {
+        const CachedBlock& last = shard.Blocks.back();
+        shard.Size -= last.Data.size();
+        shard.Index.erase(last.Key);
+        shard.Blocks.pop_back();
+    }
+}
+
+// returns the identifier of the file currently at filename (-1 if it cannot be stat'ed)
+// ids are never reused: the blocks of a forgotten or modified file are no longer
+// found and age out of the LRU lists
+int BgzfBlockCache::FileId(const std::string& filename)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return -1;
+
+    FileKey key;
+    key.Device = static_cast<uint64_t>(st.st_dev);
+    key.Inode = static_cast<uint64_t>(st.st_ino);
+    key.Size = static_cast<int64_t>(st.st_size);
+    key.ModTime = static_cast<int64_t>(st.st_mtime);
+
+    std::lock_guard<std::mutex> guard(m_filesLock);
+    std::map<FileKey, int>::iterator it = m_fileIds.find(key);
+    if (it != m_fileIds.end()) return it->second;
+
+    // forget the oldest files
+    while (m_fileIds.size() >= MAX_FILES) {
+        std::map<int, FileKey>::iterator oldest = m_fileKeys.begin();
+        m_fileIds.erase(oldest->second);
+        m_fileKeys.erase(oldest);
+    }
+
+    const int id = m_nextFileId++;
+    m_fileIds.insert(std::make_pair(key, id));
+    m_fileKeys.insert(std::make_pair(id, key));
+    return id;
+}
+
+// orders the file identities
+bool BgzfBlockCache::FileKey::operator<(const FileKey& other) const
+{
+    if (Device != other.Device) return Device < other.Device;
+    if (Inode != other.Inode) return Inode < other.Inode;
+    if (Size != other.Size) return Size < other.Size;
+    return ModTime < other.ModTime;
+}
+
+// copies a cached block into data (false if not cached)
+bool BgzfBlockCache::Get(const int fileId, const int64_t& address, char* data,
+                         std::size_t& dataLength, std::size_t& compressedLength)
+{
+    Shard& shard = ShardOf(fileId, address);
+    std::lock_guard<std::mutex> guard(shard.Lock);
+
+    std::map<BlockKey, std::list<CachedBlock>::iterator>::iterator it =
+        shard.Index.find(BlockKey(fileId, address));
+    if (it == shard.Index.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    // move block to front of LRU list
+    shard.Blocks.splice(shard.Blocks.begin(), shard.Blocks, it->second);
+
+    const CachedBlock& block = *it->second;
+    dataLength = block.Data.size();
+    compressedLength = block.CompressedLength;
+    if (dataLength > 0) memcpy(data, &block.Data[0], dataLength);
+
+    ++m_hits;
+    return true;
+}
+
+// retrieves the number of lookups found/not found in the cache
+void BgzfBlockCache::GetStats(uint64_t& hits, uint64_t& misses) const
+{
+    hits = m_hits.load();
+    misses = m_misses.load();
+}
+
+// stores an inflated block
+void BgzfBlockCache::Put(const int fileId, const int64_t& address, const char* data,
+                         const std::size_t dataLength, const std::size_t compressedLength)
+{
+    const std::size_t shardCapacity = m_capacity / NUM_SHARDS;
+    if (dataLength == 0 || dataLength > shardCapacity) return;
+
+    Shard& shard = ShardOf(fileId, address);
+    std::lock_guard<std::mutex> guard(shard.Lock);
+
+    // another reader may have stored the same block meanwhile
+    const BlockKey key(fileId, address);
+    if (shard.Index.find(key) != shard.Index.end()) return;
+
+    shard.Blocks.push_front(CachedBlock());
+    CachedBlock& block = shard.Blocks.front();
+    block.Key = key;
+    block.Data.assign(data, data + dataLength);
+    block.CompressedLength = compressedLength;
+
+    shard.Index.insert(std::make_pair(key, shard.Blocks.begin()));
+    shard.Size += dataLength;
+
+    Evict(shard, shardCapacity);
+}
+
+// returns the shard holding a block
+BgzfBlockCache::Shard& BgzfBlockCache::ShardOf(const int fileId, const int64_t& address)
+{
+    // neighbouring blocks (same file) land in different shards
+    const uint64_t h =
+        (static_cast<uint64_t>(address) + static_cast<uint64_t>(fileId)) * 0x9E3779B97F4A7C15ULL;
+    return m_shards[(h >> 32) % NUM_SHARDS];
+}
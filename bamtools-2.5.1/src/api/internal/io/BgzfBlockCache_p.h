@@ -0,0 +1,120 @@
+// ***************************************************************************
+// BgzfBlockCache_p.h
+// ---------------------------------------------------------------------------
+// Provides a cache of inflated BGZF blocks, shared by the BgzfStreams of a
+// group of readers (keyed by file identity & compressed offset).
+//
+// implementation note: bounded LRU split in shards, each with its own lock,
+// so that readers running on different threads seldom contend
+// ***************************************************************************
+
+#ifndef BGZFBLOCKCACHE_P_H
+#define BGZFBLOCKCACHE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "api/api_global.h"
+
+namespace BamTools {
+namespace Internal {
+
+class BgzfBlockCache
+{
+
+    // ctor
+public:
+    explicit BgzfBlockCache(const std::size_t bytes);
+
+    // cache interface
+public:
+    // returns the identifier of the file currently at filename (-1 if it cannot be stat'ed)
+    int FileId(const std::string& filename);
+    // copies a cached block into data (false if not cached)
+    bool Get(const int fileId, const int64_t& address, char* data, std::size_t& dataLength,
+             std::size_t& compressedLength);
+    // retrieves the number of lookups found/not found in the cache
+    void GetStats(uint64_t& hits, uint64_t& misses) const;
+    // stores an inflated block
+    void Put(const int fileId, const int64_t& address, const char* data,
+             const std::size_t dataLength, const std::size_t compressedLength);
+
+    // internal types
+private:
+    typedef std::pair<int, int64_t> BlockKey;
+
+    // identity of a file: a file replaced or rewritten under the same name gets a new id
+    struct FileKey
+    {
+        uint64_t Device;
+        uint64_t Inode;
+        int64_t Size;
+        int64_t ModTime;
+
+        bool operator<(const FileKey& other) const;
+    };
+
+    struct CachedBlock
+    {
+        BlockKey Key;
+        std::vector<char> Data;
+        std::size_t CompressedLength;
+    };
+
+    struct Shard
+    {
+        std::mutex Lock;
+        std::list<CachedBlock> Blocks;  // most recently used first
+        std::map<BlockKey, std::list<CachedBlock>::iterator> Index;
+        std::size_t Size;
+
+        Shard()
+            : Size(0)
+        {}
+    };
+
+    static const int NUM_SHARDS = 32;
+    static const std::size_t MAX_FILES = 1024;  // files remembered (the oldest are forgotten)
+
+    // internal methods
+private:
+    BgzfBlockCache(const BgzfBlockCache&);
+    BgzfBlockCache& operator=(const BgzfBlockCache&);
+
+    // evicts the least recently used blocks of a (locked) shard above its capacity
+    void Evict(Shard& shard, const std::size_t shardCapacity);
+    // returns the shard holding a block
+    Shard& ShardOf(const int fileId, const int64_t& address);
+
+    // data members
+private:
+    Shard m_shards[NUM_SHARDS];
+    const std::size_t m_capacity;  // maximum number of inflated bytes held
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+
+    std::mutex m_filesLock;
+    std::map<FileKey, int> m_fileIds;
+    std::map<int, FileKey> m_fileKeys;  // same files by id (oldest first)
+    int m_nextFileId;
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BGZFBLOCKCACHE_P_H
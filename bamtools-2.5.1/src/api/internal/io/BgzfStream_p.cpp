@@ -13,6 +13,7 @@
 #include "api/BamAux.h"
 #include "api/BamConstants.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
+#include "api/internal/io/BgzfBlockCache_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
@@ -36,6 +37,8 @@ BgzfStream::BgzfStream()
     , m_blockAddress(0)
     , m_isWriteCompressed(true)
     , m_device(0)
+    , m_blockCache(0)
+    , m_cacheFileId(-1)
     , m_uncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
     , m_compressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
 {}
@@ -85,6 +88,7 @@ void BgzfStream::Close()
     m_blockOffset = 0;
     m_blockAddress = 0;
     m_isWriteCompressed = true;
+    m_cacheFileId = -1;
 }
 
 // compresses the current block
@@ -282,6 +286,11 @@ void BgzfStream::Open(const std::string& filename, const IBamIODevice::OpenMode
         const std::string message = std::string("could not open BGZF stream: \n\t") + deviceError;
         throw BamException("BgzfStream::Open", message);
     }
+
+    // blocks of random-access input files can be shared with other readers
+    // (keyed by the identity of the file when it is opened, not by its name)
+    if (m_blockCache && mode == IBamIODevice::ReadOnly && m_device->IsRandomAccess())
+        m_cacheFileId = m_blockCache->FileId(filename);
 }
 
 // reads BGZF data into a byte buffer
@@ -340,6 +349,22 @@ void BgzfStream::ReadBlock()
     // store block's starting address
     const int64_t blockAddress = m_device->Tell();
 
+    // use the block inflated by any reader of this file, if cached
+    const bool useCache = (m_cacheFileId >= 0);
+    if (useCache) {
+        std::size_t cachedLength = 0;
+        std::size_t compressedLength = 0;
+        if (m_blockCache->Get(m_cacheFileId, blockAddress, m_uncompressedBlock.Buffer,
+                              cachedLength, compressedLength)) {
+            if (!m_device->Seek(blockAddress + compressedLength))
+                throw BamException("BgzfStream::ReadBlock", "could not skip cached block");
+            if (m_blockLength != 0) m_blockOffset = 0;
+            m_blockAddress = blockAddress;
+            m_blockLength = cachedLength;
+            return;
+        }
+    }
+
     // read block header from file
     char header[Constants::BGZF_BLOCK_HEADER_LENGTH];
     int64_t numBytesRead = m_device->Read(header, Constants::BGZF_BLOCK_HEADER_LENGTH);
@@ -385,6 +410,9 @@ void BgzfStream::ReadBlock()
 
     // decompress block data
     const std::size_t newBlockLength = InflateBlock(blockLength);
+    if (useCache)
+        m_blockCache->Put(m_cacheFileId, blockAddress, m_uncompressedBlock.Buffer,
+                          newBlockLength, blockLength);
 
     // update block data
     if (m_blockLength != 0) m_blockOffset = 0;
@@ -419,6 +447,12 @@ void BgzfStream::Seek(const int64_t& position)
     }
 }
 
+// sets the cache of inflated blocks shared with other readers (0 = none, before Open)
+void BgzfStream::SetBlockCache(BgzfBlockCache* cache)
+{
+    m_blockCache = cache;
+}
+
 void BgzfStream::SetWriteCompressed(bool ok)
 {
     m_isWriteCompressed = ok;
@@ -31,6 +31,8 @@
 namespace BamTools {
 namespace Internal {
 
+class BgzfBlockCache;
+
 class BgzfStream
 {
 
@@ -53,6 +55,8 @@ public:
     void Seek(const int64_t& position);
     // sets IO device (closes previous, if any, but does not attempt to open)
     void SetIODevice(IBamIODevice* device);
+    // sets the cache of inflated blocks shared with other readers (0 = none, before Open)
+    void SetBlockCache(BgzfBlockCache* cache);
     // enable/disable compressed output
     void SetWriteCompressed(bool ok);
     // get file position in BGZF file
@@ -84,6 +88,8 @@ public:
 
     bool m_isWriteCompressed;
     IBamIODevice* m_device;
+    BgzfBlockCache* m_blockCache;  // inflated blocks shared with other readers (0 = none)
+    int m_cacheFileId;  // key of this file in the shared block cache (-1 = not cached)
 
     RaiiBuffer m_uncompressedBlock;
     RaiiBuffer m_compressedBlock;
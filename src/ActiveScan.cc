@@ -0,0 +1,293 @@
+#include "ActiveScan.hh"
+
+/****************************************************************************
+** ActiveScan.cc
+**
+** Active-region pre-scan. Each region of the queue is streamed once from
+** the tumor and normal BAMs (in parallel across regions) and the loci with
+** enough evidence of mutation (mismatches, indels, soft-clips) are recorded.
+** Windows without any such locus cannot be active and are skipped by the
+** assembly stage without touching the BAM files
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// scan all regions of the queue and mark the windows that can be active
+// returns the number of windows to assemble (-1 on error)
+//////////////////////////////////////////////////////////////
+int ActiveScan_t::run(WindowQueue_t & q, int num_threads) {
+
+	queue = &q;
+	results.assign(queue->blocks.size(), ScanResult_t());
+	next_block = 0;
+
+	int num_cached = loadCache();
+	if(num_cached > 0) { cerr << "Active-region pre-scan: " << num_cached << " regions loaded from " << CACHE_FILE << endl; }
+
+	if(num_threads < 1) { num_threads = 1; }
+	pthread_t threads[num_threads];
+	int rc;
+
+	int num_started = 0;
+	for (int i = 0; i < num_threads; ++i) {
+		rc = pthread_create(&threads[i], NULL, execute, (void *)this);
+		if (rc){
+			cerr << "Error:unable to create thread," << rc << endl;
+			failed = true;
+			next_block = results.size(); // the threads already started stop after their current region
+			break;
+		}
+		++num_started;
+	}
+	for (int i = 0; i < num_started; ++i) {
+		rc = pthread_join(threads[i], NULL);
+		if (rc){
+			cerr << "Error:unable to join," << rc << endl;
+			failed = true;
+		}
+	}
+	if(failed) { return -1; }
+
+	if( (CACHE_FILE != "") && (num_cached < (int)results.size()) ) { saveCache(); }
+
+	int num_active = 0;
+	for (unsigned int b = 0; b < results.size(); ++b) {
+		num_active += queue->markActive(b, results[b].hot, results[b].overhang, results[b].all);
+	}
+
+	return num_active;
+}
+
+void* ActiveScan_t::execute(void* ptr) {
+
+	ActiveScan_t * scan = (ActiveScan_t *)ptr;
+	if(!scan->scanBlocks()) {
+		scan->failed = true;
+		scan->next_block = scan->results.size(); // the other threads stop after their current region
+	}
+
+	return NULL;
+}
+
+// open a BAM file with its index
+//////////////////////////////////////////////////////////////
+static bool openBam(AlignmentReader_t & reader, const string & filename, const ReaderOptions_t * opts) {
+
+	if ( !reader.open(filename, opts) ) {
+		cerr << "Could not open BAM file " << filename << endl;
+		return false;
+	}
+
+	if ( !reader.openIndex() ) { // .bam.bai, .bai (or .crai with htslib)
+		cerr << "ERROR: index not found for BAM file " << filename << endl;
+		return false;
+	}
+	return true;
+}
+
+// claim and scan regions until all of them are done (one call per thread)
+// false if the BAM files could not be opened
+//////////////////////////////////////////////////////////////
+bool ActiveScan_t::scanBlocks() {
+
+	AlignmentReader_t readerT;
+	AlignmentReader_t readerN;
+	if ( !openBam(readerT, TUMOR, reader_opts) || !openBam(readerN, NORMAL, reader_opts) ) { return false; }
+
+	int N = results.size();
+	int b;
+	while ( (b = next_block.fetch_add(1)) < N ) {
+
+		ScanResult_t & res = results[b];
+		if(res.done) { continue; } // loaded from cache
+
+		// more sensitive in normal (all reads)
+		scanBlock(readerT, queue->blocks[b], MIN_MAP_QUAL, res);
+		scanBlock(readerN, queue->blocks[b], 0, res);
+
+		sort(res.hot.begin(), res.hot.end());
+		res.hot.erase(unique(res.hot.begin(), res.hot.end()), res.hot.end());
+		res.done = true;
+
+		if(verbose) { cerr << "Active-region pre-scan: " << queue->blocks[b].chr << ":" << queue->blocks[b].start << " " << res.hot.size() << " loci with evidence" << endl; }
+	}
+
+	readerT.close();
+	readerN.close();
+	return true;
+}
+
+// stream the alignments of the region once and count the evidence by locus
+// (same signals and read filters used by Microassembler::isActiveRegion)
+// read groups are not checked, so the evidence is never lower than in the windows
+//////////////////////////////////////////////////////////////
+void ActiveScan_t::scanBlock(AlignmentReader_t & reader, const Block_t & block, int MQ, ScanResult_t & res) {
+
+	if(res.all) { return; }
+
+	BamRegion region(block.refid, block.start, block.refid, block.start + block.len + 1);
+	if( (block.refid < 0) || !reader.setRegion(region) ) { res.all = true; return; }
+
+	map<int,int> mapX; // table with counts of all mismatches at a given locus
+	map<int,int> mapI; // table with counts of all insertions at a given locus
+	map<int,int> mapD; // table with counts of all deletion at a given locus
+	map<int,int> mapSC; // table with counts of all softclipped sequences starting at a given locus
+
+	BamAlignment al;
+	while ( reader.getNextAlignmentCore(al) ) {
+
+		// loci before the start of the alignment cannot receive more evidence
+		int alstart = al.Position;
+		flush(mapX, alstart, res.hot);
+		flush(mapI, alstart, res.hot);
+		flush(mapD, alstart, res.hot);
+		flush(mapSC, alstart, res.hot);
+
+		if ( (al.MapQuality < MQ) || al.IsDuplicate() ) { continue; } // skip reads with low map quality and PCR duplicates
+
+		al.BuildCharData(); // Populates alignment string fields (read name, bases, qualities, tag data)
+		if( (al.QueryBases).empty() || (al.Qualities).empty() ) { continue; } // skip alignments with undefined sequence or qualities
+
+		collectEvidence(al, mapX, mapI, mapD, mapSC, MIN_QUAL_CALL);
+
+		// clipped bases move the CIGAR loci past the end of the alignment
+		int clipped = 0;
+		for (vector<CigarOp>::iterator it = (al.CigarData).begin() ; it != (al.CigarData).end(); ++it) {
+			char T = (*it).Type;
+			if(T=='S' || T=='H' || T=='P') { clipped += (*it).Length; }
+		}
+		if(clipped > res.overhang) { res.overhang = clipped; }
+	}
+
+	flush(mapX, INT_MAX, res.hot);
+	flush(mapI, INT_MAX, res.hot);
+	flush(mapD, INT_MAX, res.hot);
+	flush(mapSC, INT_MAX, res.hot);
+}
+
+// move the loci before pos with enough evidence to the list of hot loci
+//////////////////////////////////////////////////////////////
+void ActiveScan_t::flush(map<int,int> & M, int pos, vector<int> & hot) {
+
+	map<int,int>::iterator it = M.begin();
+	while ( (it != M.end()) && ((*it).first < pos) ) {
+		if((*it).second >= MIN_EVIDENCE) { hot.push_back((*it).first); }
+		M.erase(it++);
+	}
+}
+
+// key identifying the input files and parameters of the pre-scan
+//////////////////////////////////////////////////////////////
+string ActiveScan_t::cacheKey() {
+
+	stringstream key;
+	struct stat st;
+
+	const string samples[2] = { TUMOR, NORMAL };
+	for (int s = 0; s < 2; ++s) {
+		vector<string> files = AlignmentReader_t::splitFiles(samples[s]);
+		for (unsigned int i = 0; i < files.size(); ++i) {
+			key << (i > 0 ? "," : (s > 0 ? "\t" : "")) << files[i];
+			if(stat(files[i].c_str(), &st) == 0) { key << ":" << st.st_size << ":" << st.st_mtime; }
+		}
+	}
+	key << "\t" << MIN_MAP_QUAL << "\t" << MIN_QUAL_CALL << "\t" << MIN_EVIDENCE;
+
+	return key.str();
+}
+
+// load the results of a previous pre-scan with the same inputs
+// returns the number of regions loaded
+//////////////////////////////////////////////////////////////
+int ActiveScan_t::loadCache() {
+
+	if(CACHE_FILE == "") { return 0; }
+
+	ifstream cfile(CACHE_FILE);
+	if (!cfile.is_open()) { return 0; }
+
+	string line;
+	if( !getline(cfile, line) || (line != "#lancet-active-scan\t" + cacheKey()) ) {
+		cerr << "Active-region pre-scan: cache " << CACHE_FILE << " does not match the input, ignored" << endl;
+		return 0;
+	}
+
+	// index regions by coordinates
+	map<string,int> index;
+	for (unsigned int b = 0; b < queue->blocks.size(); ++b) {
+		Block_t & block = queue->blocks[b];
+		index[block.chr + ":" + itos(block.start) + ":" + itos(block.len)] = b;
+	}
+
+	int num_loaded = 0;
+	while ( getline(cfile, line) ) {
+
+		istringstream iss(line);
+		string chr, start, len, overhang, loci;
+		getline(iss, chr, '\t');
+		getline(iss, start, '\t');
+		getline(iss, len, '\t');
+		getline(iss, overhang, '\t');
+		getline(iss, loci, '\t');
+
+		map<string,int>::iterator it = index.find(chr + ":" + start + ":" + len);
+		if( (it == index.end()) || overhang.empty() ) { continue; }
+
+		ScanResult_t & res = results[(*it).second];
+		if(res.done) { continue; }
+
+		res.overhang = atoi(overhang.c_str());
+		res.all = (res.overhang < 0);
+		if(res.all) { res.overhang = 0; }
+
+		istringstream lss(loci);
+		string pos;
+		while ( getline(lss, pos, ',') ) {
+			if(!pos.empty()) { res.hot.push_back(atoi(pos.c_str())); }
+		}
+		res.done = true;
+		++num_loaded;
+	}
+	cfile.close();
+
+	return num_loaded;
+}
+
+// save the results of the pre-scan
+//////////////////////////////////////////////////////////////
+void ActiveScan_t::saveCache() {
+
+	ofstream cfile(CACHE_FILE);
+	if (!cfile.is_open()) {
+		cerr << "Couldn't open " << CACHE_FILE << endl;
+		return;
+	}
+
+	cfile << "#lancet-active-scan\t" << cacheKey() << endl;
+	for (unsigned int b = 0; b < results.size(); ++b) {
+		Block_t & block = queue->blocks[b];
+		ScanResult_t & res = results[b];
+
+		cfile << block.chr << "\t" << block.start << "\t" << block.len << "\t" << (res.all ? -1 : res.overhang) << "\t";
+		for (unsigned int i = 0; i < res.hot.size(); ++i) {
+			if(i > 0) { cfile << ","; }
+			cfile << res.hot[i];
+		}
+		cfile << endl;
+	}
+	cfile.close();
+}
@@ -0,0 +1,102 @@
+#ifndef ACTIVESCAN_HH
+#define ACTIVESCAN_HH 1
+
+/****************************************************************************
+** ActiveScan.hh
+**
+** Active-region pre-scan. Each region of the queue is streamed once from
+** the tumor and normal BAMs (in parallel across regions) and the loci with
+** enough evidence of mutation (mismatches, indels, soft-clips) are recorded.
+** Windows without any such locus cannot be active and are skipped by the
+** assembly stage without touching the BAM files
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "api/BamReader.h"
+
+#include "AlignmentReader.hh"
+
+#include "util.hh"
+#include "Ref.hh"
+#include "WindowQueue.hh"
+
+using namespace std;
+using namespace BamTools;
+
+// ScanResult_t
+// loci with evidence of mutation in a region
+//////////////////////////////////////////////////////////////////////////
+class ScanResult_t
+{
+public:
+	vector<int> hot; // sorted positions with enough evidence (tumor or normal)
+	int overhang; // max distance of an evidence locus past the end of its alignment
+	bool all; // the region could not be scanned: treat all windows as active
+	bool done;
+
+	ScanResult_t() : overhang(0), all(false), done(false) { }
+};
+
+class ActiveScan_t
+{
+public:
+
+	string TUMOR;
+	string NORMAL;
+	string CACHE_FILE; // results are loaded from/saved to this file (if set)
+	int MIN_MAP_QUAL;
+	int MIN_QUAL_CALL;
+	int MIN_EVIDENCE; // min evidence at a locus to consider the region active
+	bool verbose;
+	ReaderOptions_t * reader_opts; // backend of the alignment readers (NULL = bamtools)
+
+	vector<ScanResult_t> results; // one entry for each region of the queue
+
+	ActiveScan_t() : MIN_MAP_QUAL(15), MIN_QUAL_CALL(17+'!'), MIN_EVIDENCE(3), verbose(false), reader_opts(NULL), queue(NULL), next_block(0), failed(false) { }
+
+	int run(WindowQueue_t & queue, int num_threads);
+
+private:
+
+	WindowQueue_t * queue;
+	atomic<int> next_block; // index of the next region to scan
+	atomic<bool> failed; // a thread could not open the BAM files
+
+	static void* execute(void* ptr);
+	bool scanBlocks();
+	void scanBlock(AlignmentReader_t & reader, const Block_t & block, int MQ, ScanResult_t & res);
+	void flush(map<int,int> & M, int pos, vector<int> & hot);
+
+	string cacheKey();
+	int loadCache();
+	void saveCache();
+};
+
+#endif
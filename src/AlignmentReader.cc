@@ -0,0 +1,308 @@
+#include "AlignmentReader.hh"
+
+/****************************************************************************
+** AlignmentReader.cc
+**
+** Reader of an indexed alignment file with two backends: bamtools (BAM)
+** and htslib (BAM and CRAM), or of several files of a sample merged by position
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <climits>
+
+#include "util.hh"
+
+// CRAM files can only be read with htslib
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::isCram(const string & filename) {
+
+	size_t n = filename.length();
+	return (n > 5) && (filename.compare(n-5, 5, ".cram") == 0);
+}
+
+// files of a sample: comma separated list
+//////////////////////////////////////////////////////////////
+vector<string> AlignmentReader_t::splitFiles(const string & filenames) {
+
+	vector<string> files;
+	size_t start = 0;
+	while (start <= filenames.length()) {
+		size_t end = filenames.find(',', start);
+		if (end == string::npos) { end = filenames.length(); }
+		if (end > start) { files.push_back(filenames.substr(start, end - start)); }
+		start = end + 1;
+	}
+	return files;
+}
+
+// open the alignment file (without index): htslib is used for CRAM files
+// and if requested in the options, bamtools otherwise
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::open(const string & filename_, const ReaderOptions_t * opts) {
+
+	close();
+	filename = filename_;
+
+	vector<string> files = splitFiles(filename);
+	if (files.size() > 1) { return openParts(files, opts); }
+	if (files.size() == 1) { filename = files[0]; }
+
+	bool htslib = isCram(filename) || ( (opts != NULL) && opts->htslib );
+	if (!htslib) {
+		reader.SetCache( (opts != NULL) ? opts->cache : NULL );
+		return reader.Open(filename);
+	}
+
+	hts_fp = hts_open(filename.c_str(), "r");
+	if (hts_fp == NULL) { return false; }
+
+	// the MD tags (needed by the active regions) are not stored in CRAM files
+	if (hts_get_format(hts_fp)->format == cram) { hts_set_opt(hts_fp, CRAM_OPT_DECODE_MD, 1); }
+
+	if (opts != NULL) {
+		// CRAM slices are decoded against the reference of the run
+		if ( (opts->reffile != "") && (hts_get_format(hts_fp)->format == cram) ) {
+			if (hts_set_fai_filename(hts_fp, opts->reffile.c_str()) != 0) { close(); return false; }
+		}
+		if (opts->pool != NULL) {
+			hts_set_thread_pool(hts_fp, opts->pool);
+			threaded_cram = (hts_get_format(hts_fp)->format == cram);
+		}
+	}
+
+	hts_hdr = sam_hdr_read(hts_fp);
+	if (hts_hdr == NULL) { close(); return false; }
+
+	hts_rec = bam_init1();
+	return true;
+}
+
+// open the files of a sample: they must be aligned to the same reference
+// (the header of the first file is used for the sample name)
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::openParts(const vector<string> & filenames, const ReaderOptions_t * opts) {
+
+	for (unsigned int i = 0; i < filenames.size(); ++i) {
+		AlignmentReader_t * part = new AlignmentReader_t();
+		parts.push_back(part);
+		if ( !part->open(filenames[i], opts) ) { close(); return false; }
+	}
+
+	RefVector refs = parts[0]->getReferenceData();
+	for (unsigned int i = 1; i < parts.size(); ++i) {
+		RefVector refsX = parts[i]->getReferenceData();
+		bool same = (refsX.size() == refs.size());
+		for (unsigned int r = 0; same && r < refsX.size(); ++r) {
+			same = (refsX[r].RefName == refs[r].RefName) && (refsX[r].RefLength == refs[r].RefLength);
+		}
+		if (!same) {
+			cerr << "ERROR: the reference sequences of " << filenames[i] << " do not match those of " << filenames[0] << endl;
+			close();
+			return false;
+		}
+	}
+
+	heads.assign(parts.size(), BamAlignment());
+	has_head.assign(parts.size(), false);
+	primed = false;
+	return true;
+}
+
+// load the index (.bam.bai, .bai, .crai or .csi)
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::openIndex() {
+
+	if (!parts.empty()) {
+		for (unsigned int i = 0; i < parts.size(); ++i) {
+			if ( !parts[i]->openIndex() ) { return false; }
+		}
+		return true;
+	}
+
+	string index_filename = GetBaseFilename(filename.c_str())+".bai";
+
+	if (hts_fp == NULL) {
+		if (reader.LocateIndex()) { return true; } // .bam.bai
+		return reader.OpenIndex(index_filename); // try with different extension .bai
+	}
+
+	hts_idx = sam_index_load(hts_fp, filename.c_str());
+	if ( (hts_idx == NULL) && !isCram(filename) ) { hts_idx = sam_index_load2(hts_fp, filename.c_str(), index_filename.c_str()); }
+	return (hts_idx != NULL);
+}
+
+void AlignmentReader_t::close() {
+
+	reader.Close();
+	if (hts_iter != NULL) { hts_itr_destroy(hts_iter); hts_iter = NULL; }
+	if (hts_idx != NULL) { hts_idx_destroy(hts_idx); hts_idx = NULL; }
+	if (hts_rec != NULL) { bam_destroy1(hts_rec); hts_rec = NULL; }
+	if (hts_hdr != NULL) { bam_hdr_destroy(hts_hdr); hts_hdr = NULL; }
+	if (hts_fp != NULL) { hts_close(hts_fp); hts_fp = NULL; }
+	threaded_cram = false;
+
+	for (unsigned int i = 0; i < parts.size(); ++i) { delete parts[i]; }
+	parts.clear();
+	heads.clear();
+	has_head.clear();
+	primed = false;
+}
+
+bool AlignmentReader_t::isOpen() {
+	return !parts.empty() || (hts_fp != NULL) || reader.IsOpen();
+}
+
+// set the region to read: the alignments overlapping [left,right) or,
+// without a right bound, the alignments from left to the end of the reference
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::setRegion(const BamRegion & region) {
+
+	if (!parts.empty()) {
+		primed = false;
+		for (unsigned int i = 0; i < parts.size(); ++i) {
+			if ( !parts[i]->setRegion(region) ) { return false; }
+		}
+		return true;
+	}
+
+	if (hts_fp == NULL) { return reader.SetRegion(region); }
+
+	if (hts_iter != NULL) { hts_itr_destroy(hts_iter); hts_iter = NULL; }
+	if ( (hts_idx == NULL) || (region.LeftRefID < 0) || (region.LeftRefID >= hts_hdr->n_targets) ) { return false; }
+
+	int end = INT_MAX;
+	if ( (region.RightRefID == region.LeftRefID) && (region.RightPosition >= 0) ) { end = region.RightPosition; }
+
+	hts_iter = sam_itr_queryi(hts_idx, region.LeftRefID, region.LeftPosition, end);
+	return (hts_iter != NULL);
+}
+
+// next alignment of the region (or of the file if no region was set)
+// the htslib backend always decodes the character data
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::getNextAlignmentCore(BamAlignment & al) {
+
+	if (!parts.empty()) { return getNextMerged(al, true); }
+	if (hts_fp == NULL) { return reader.GetNextAlignmentCore(al); }
+
+	int ret = (hts_iter != NULL) ? sam_itr_next(hts_fp, hts_iter, hts_rec) : sam_read1(hts_fp, hts_hdr, hts_rec);
+	if ( (ret < -1) && !threaded_cram ) { cerr << "Error: truncated or corrupted alignments in " << filename << endl; }
+	if (ret < 0) { return false; }
+
+	convert(hts_rec, al);
+	return true;
+}
+
+bool AlignmentReader_t::getNextAlignment(BamAlignment & al) {
+
+	if (!parts.empty()) { return getNextMerged(al, false); }
+	if (hts_fp == NULL) { return reader.GetNextAlignment(al); }
+	return getNextAlignmentCore(al);
+}
+
+// next alignment of the files of a sample: the one with the lowest position
+// among the next alignments of the files (the first file wins the ties).
+// A sample has a few files, so the heads are scanned instead of kept in a heap
+//////////////////////////////////////////////////////////////
+bool AlignmentReader_t::getNextMerged(BamAlignment & al, bool core) {
+
+	if (!primed) {
+		for (unsigned int i = 0; i < parts.size(); ++i) {
+			has_head[i] = core ? parts[i]->getNextAlignmentCore(heads[i]) : parts[i]->getNextAlignment(heads[i]);
+		}
+		primed = true;
+	}
+
+	int best = -1;
+	for (unsigned int i = 0; i < parts.size(); ++i) {
+		if (!has_head[i]) { continue; }
+		if (best < 0) { best = i; continue; }
+
+		// the unmapped reads (RefID -1) are at the end of the files
+		const BamAlignment & a = heads[i];
+		const BamAlignment & b = heads[best];
+		if ( ((uint32_t)a.RefID < (uint32_t)b.RefID) || ((a.RefID == b.RefID) && (a.Position < b.Position)) ) { best = i; }
+	}
+	if (best < 0) { return false; }
+
+	al = heads[best];
+	has_head[best] = core ? parts[best]->getNextAlignmentCore(heads[best]) : parts[best]->getNextAlignment(heads[best]);
+	return true;
+}
+
+SamHeader AlignmentReader_t::getHeader() {
+
+	if (!parts.empty()) { return parts[0]->getHeader(); }
+	if (hts_fp == NULL) { return reader.GetHeader(); }
+	return SamHeader(string(hts_hdr->text, hts_hdr->l_text));
+}
+
+RefVector AlignmentReader_t::getReferenceData() {
+
+	if (!parts.empty()) { return parts[0]->getReferenceData(); }
+	if (hts_fp == NULL) { return reader.GetReferenceData(); }
+
+	RefVector refs;
+	for (int i = 0; i < hts_hdr->n_targets; ++i) {
+		refs.push_back(RefData(hts_hdr->target_name[i], hts_hdr->target_len[i]));
+	}
+	return refs;
+}
+
+// fill a bamtools alignment with an htslib record (as BamAlignment::BuildCharData
+// does, except for AlignedBases that the assembler does not use)
+//////////////////////////////////////////////////////////////
+void AlignmentReader_t::convert(const bam1_t * b, BamAlignment & al) {
+
+	const bam1_core_t & c = b->core;
+
+	al.Name = bam_get_qname(b);
+	al.Length = c.l_qseq;
+
+	const uint8_t * seq = bam_get_seq(b);
+	al.QueryBases.resize(c.l_qseq);
+	for (int i = 0; i < c.l_qseq; ++i) { al.QueryBases[i] = seq_nt16_str[bam_seqi(seq, i)]; }
+
+	// unstored qualities are kept as 0xFF
+	const uint8_t * qual = bam_get_qual(b);
+	al.Qualities.resize(c.l_qseq);
+	if ( (c.l_qseq > 0) && (qual[0] == 0xFF) ) { al.Qualities.assign(c.l_qseq, (char)0xFF); }
+	else {
+		for (int i = 0; i < c.l_qseq; ++i) { al.Qualities[i] = qual[i] + 33; }
+	}
+
+	al.AlignedBases.clear();
+	al.TagData.assign((const char *)bam_get_aux(b), bam_get_l_aux(b));
+
+	al.RefID = c.tid;
+	al.Position = c.pos;
+	al.Bin = c.bin;
+	al.MapQuality = c.qual;
+	al.AlignmentFlag = c.flag;
+	al.MateRefID = c.mtid;
+	al.MatePosition = c.mpos;
+	al.InsertSize = c.isize;
+	al.Filename = filename;
+
+	const uint32_t * cigar = bam_get_cigar(b);
+	al.CigarData.clear();
+	al.CigarData.reserve(c.n_cigar);
+	for (unsigned int k = 0; k < c.n_cigar; ++k) {
+		al.CigarData.push_back(CigarOp(bam_cigar_opchr(cigar[k]), bam_cigar_oplen(cigar[k])));
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef ALIGNMENTREADER_HH
+#define ALIGNMENTREADER_HH 1
+
+/****************************************************************************
+** AlignmentReader.hh
+**
+** Reader of an indexed alignment file with two backends: bamtools (BAM)
+** and htslib (BAM and CRAM, with the BGZF blocks decoded by a thread pool
+** shared by all the readers). Both return bamtools alignments, so the rest
+** of the pipeline does not depend on the backend.
+** A sample sequenced on several lanes or libraries can be given as a comma
+** separated list of files: their alignments are merged by position while
+** reading, as if they were one coordinate-sorted file
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "api/BamReader.h"
+#include "api/BamReaderCache.h"
+#include "htslib/sam.h"
+#include "htslib/thread_pool.h"
+
+using namespace std;
+using namespace BamTools;
+
+// ReaderOptions_t
+// how the alignment files are read (shared by all the readers of a run)
+//////////////////////////////////////////////////////////////////////////
+class ReaderOptions_t
+{
+public:
+
+	bool htslib; // read the BAM files with htslib (CRAM files always are)
+	string reffile; // reference of the CRAM files
+	htsThreadPool * pool; // BGZF/CRAM decoding threads shared by the readers (NULL = none)
+	BamReaderCache * cache; // BGZF blocks and .bai indexes shared by the bamtools readers (NULL = none)
+
+	ReaderOptions_t() : htslib(false), pool(NULL), cache(NULL) { }
+};
+
+class AlignmentReader_t
+{
+public:
+
+	AlignmentReader_t() : hts_fp(NULL), hts_hdr(NULL), hts_idx(NULL), hts_iter(NULL), hts_rec(NULL), threaded_cram(false), primed(false) { }
+	~AlignmentReader_t() { close(); }
+
+	static bool isCram(const string & filename);
+	static vector<string> splitFiles(const string & filenames);
+
+	bool open(const string & filename, const ReaderOptions_t * opts = NULL);
+	bool openIndex();
+	void close();
+	bool isOpen();
+	bool isHtslib() { return parts.empty() ? (hts_fp != NULL) : parts[0]->isHtslib(); }
+
+	bool setRegion(const BamRegion & region);
+	bool getNextAlignmentCore(BamAlignment & al);
+	bool getNextAlignment(BamAlignment & al);
+
+	SamHeader getHeader();
+	RefVector getReferenceData();
+
+private:
+
+	string filename;
+	BamReader reader; // bamtools backend
+
+	// htslib backend
+	htsFile * hts_fp;
+	bam_hdr_t * hts_hdr;
+	hts_idx_t * hts_idx;
+	hts_itr_t * hts_iter; // current region (NULL = sequential reading)
+	bam1_t * hts_rec;
+	bool threaded_cram; // the end of a region is reported as an error by htslib (1.8)
+
+	// files of the same sample (empty = single file)
+	vector<AlignmentReader_t *> parts;
+	vector<BamAlignment> heads; // next alignment of each part
+	vector<bool> has_head;
+	bool primed; // heads read since the last open/setRegion
+
+	void convert(const bam1_t * b, BamAlignment & al);
+	bool openParts(const vector<string> & filenames, const ReaderOptions_t * opts);
+	bool getNextMerged(BamAlignment & al, bool core);
+};
+
+#endif
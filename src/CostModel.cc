@@ -0,0 +1,286 @@
+#include "CostModel.hh"
+
+/****************************************************************************
+** CostModel.cc
+**
+** Estimate of the cost of assembling a window, computed before any read is
+** decoded. The BAM indexes (BAI) give the compressed bytes of the
+** alignments in each 16kb bin (from the virtual offsets of the bin chunks)
+** and the soft-masked fraction of the reference gives its repeat content
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// add the alignment bytes of a BAM file (or of the files of a sample) to the model
+// (the index is looked up with the same names used to open the BAM)
+// returns false if an index cannot be read
+//////////////////////////////////////////////////////////////
+bool CostModel_t::loadIndex(const string & bamfile) {
+
+	vector<string> files = AlignmentReader_t::splitFiles(bamfile);
+	for (unsigned int i = 0; i < files.size(); ++i) {
+		if(readIndex(files[i] + ".bai")) { continue; }
+		if(!readIndex(GetBaseFilename(files[i].c_str()) + ".bai")) { return false; }
+	}
+	return !files.empty();
+}
+
+// compressed position of a virtual file offset
+static double filePosition(uint64_t voffset) {
+	return (double)(voffset >> 16) + (double)(voffset & 0xffff) / BGZF_RATIO;
+}
+
+// parse the bins of a BAI file
+// the chunks of a bin are the file ranges of the alignments assigned to it:
+// the bytes of a leaf bin go to its 16kb tile, the bytes of the larger bins
+// (alignments crossing tile boundaries) are spread over the tiles they cover.
+// The tiles with alignments are tracked apart (see markParentBin), since the
+// spread bytes make most of the tiles of a reference non-zero
+//////////////////////////////////////////////////////////////
+bool CostModel_t::readIndex(const string & filename) {
+
+	ifstream bai(filename.c_str(), ios::binary);
+	if (!bai.is_open()) { return false; }
+
+	char magic[4];
+	int32_t n_ref = 0;
+	bai.read(magic, 4);
+	bai.read((char*)&n_ref, 4);
+	if( !bai || (magic[0]!='B' || magic[1]!='A' || magic[2]!='I' || magic[3]!=1) || (n_ref < 0) ) {
+		cerr << "Warning: " << filename << " is not a valid BAI file" << endl;
+		return false;
+	}
+
+	if((int)bytes.size() < n_ref) { bytes.resize(n_ref); occupied.resize(n_ref); }
+
+	// first bin of each level of the binning scheme
+	const int level_offset[7] = { 0, 1, 9, 73, 585, 4681, 37449 };
+
+	for (int r = 0; r < n_ref; ++r) {
+
+		int32_t n_bin = 0;
+		bai.read((char*)&n_bin, 4);
+
+		vector< pair<uint32_t,double> > bins;
+		vector< vector< pair<uint64_t,uint64_t> > > chunks; // virtual offsets of the chunks of each bin
+		int num_tiles = 0;
+		for (int b = 0; b < n_bin && bai; ++b) {
+			uint32_t bin = 0;
+			int32_t n_chunk = 0;
+			bai.read((char*)&bin, 4);
+			bai.read((char*)&n_chunk, 4);
+
+			double size = 0;
+			vector< pair<uint64_t,uint64_t> > bin_chunks;
+			for (int c = 0; c < n_chunk && bai; ++c) {
+				uint64_t beg = 0, end = 0;
+				bai.read((char*)&beg, 8);
+				bai.read((char*)&end, 8);
+				size += filePosition(end) - filePosition(beg);
+				bin_chunks.push_back(make_pair(beg, end));
+			}
+			if(bin >= (uint32_t)level_offset[6]) { continue; } // metadata pseudo-bin
+
+			bins.push_back(make_pair(bin, size));
+			chunks.push_back(bin_chunks);
+			if( (bin >= (uint32_t)level_offset[5]) && ((int)(bin - level_offset[5]) >= num_tiles) ) { num_tiles = bin - level_offset[5] + 1; }
+		}
+
+		// the linear index has one entry per tile with alignments
+		int32_t n_intv = 0;
+		bai.read((char*)&n_intv, 4);
+		bai.seekg(8*(long)n_intv, ios::cur);
+		if(!bai) {
+			cerr << "Warning: " << filename << " is truncated" << endl;
+			return false;
+		}
+		if(n_intv > num_tiles) { num_tiles = n_intv; }
+
+		vector<double> & tiles = bytes[r];
+		if((int)tiles.size() < num_tiles) { tiles.resize(num_tiles, 0); }
+		vector<char> & used = occupied[r];
+		if((int)used.size() < num_tiles) { used.resize(num_tiles, 0); }
+
+		// file range of the alignments of each leaf bin (tile) with chunks,
+		// in tile order (that is also the file order of a sorted BAM)
+		map<int, pair<uint64_t,uint64_t> > leaf_range;
+		for (unsigned int i = 0; i < bins.size(); ++i) {
+			int bin = bins[i].first;
+			if( (bin < level_offset[5]) || chunks[i].empty() ) { continue; }
+			int t = bin - level_offset[5];
+			used[t] = 1;
+			pair<uint64_t,uint64_t> range(chunks[i][0].first, chunks[i][0].second);
+			for (unsigned int c = 1; c < chunks[i].size(); ++c) {
+				range.first = min(range.first, chunks[i][c].first);
+				range.second = max(range.second, chunks[i][c].second);
+			}
+			leaf_range[t] = range;
+		}
+		vector<int> leaf_tile;
+		vector<uint64_t> leaf_beg, leaf_end;
+		for (map<int, pair<uint64_t,uint64_t> >::iterator it = leaf_range.begin(); it != leaf_range.end(); ++it) {
+			leaf_tile.push_back((*it).first);
+			leaf_beg.push_back((*it).second.first);
+			leaf_end.push_back((*it).second.second);
+		}
+
+		for (unsigned int i = 0; i < bins.size(); ++i) {
+			int bin = bins[i].first;
+			int level = 5;
+			while (bin < level_offset[level]) { --level; }
+
+			int span = 1 << (3*(5-level)); // tiles covered by a bin of this level
+			int first = (bin - level_offset[level]) * span;
+			int last = first + span;
+			if(last > num_tiles) { last = num_tiles; }
+			if(first >= last) { continue; }
+
+			double share = bins[i].second / span;
+			for (int t = first; t < last; ++t) { tiles[t] += share; }
+
+			if(level < 5) {
+				for (unsigned int c = 0; c < chunks[i].size(); ++c) {
+					markParentBin(used, first, last, span / 8, chunks[i][c], leaf_tile, leaf_beg, leaf_end);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+// mark the tiles with the alignments of a chunk of a parent bin [first,last)
+// (with children of child_span tiles). These alignments start after the
+// leaf tiles that come before the chunk in the file and before the leaf tiles
+// that come after it, and cross a boundary between two children: the tiles
+// on both sides of the boundaries in that range are marked (the alignments
+// are assumed shorter than a tile, as short reads are)
+//////////////////////////////////////////////////////////////
+void CostModel_t::markParentBin(vector<char> & used, int first, int last, int child_span, const pair<uint64_t,uint64_t> & chunk,
+                                const vector<int> & leaf_tile, const vector<uint64_t> & leaf_beg, const vector<uint64_t> & leaf_end) {
+
+	// tiles where the alignments can start: [a,b]
+	int a = first;
+	int b = last - 1;
+	size_t i = upper_bound(leaf_beg.begin(), leaf_beg.end(), chunk.first) - leaf_beg.begin();
+	if( (i > 0) && (leaf_tile[i-1] > a) ) { a = min(leaf_tile[i-1], b); }
+	size_t j = lower_bound(leaf_end.begin(), leaf_end.end(), chunk.second) - leaf_end.begin();
+	if( (j < leaf_tile.size()) && (leaf_tile[j] < b) ) { b = max(leaf_tile[j], a); }
+
+	bool found = false;
+	for (int boundary = first + child_span; boundary < last; boundary += child_span) {
+		if( (boundary < a + 1) || (boundary > b + 1) ) { continue; }
+		used[boundary - 1] = 1;
+		used[boundary] = 1;
+		found = true;
+	}
+
+	// no boundary in the range (unsorted BAM): all the tiles of the range
+	if(!found) {
+		for (int t = a; t <= b && t < (int)used.size(); ++t) { used[t] = 1; }
+	}
+}
+
+// soft-masked (lower case) fraction of the reference in a tile
+//////////////////////////////////////////////////////////////
+double CostModel_t::maskedFraction(const string & chr, int refid, int tile) {
+
+	pair<int,int> key(refid, tile);
+	map< pair<int,int>, double >::iterator it = masked.find(key);
+	if(it != masked.end()) { return (*it).second; }
+
+	double frac = 0;
+	int beg = tile << COST_TILE_SHIFT;
+	int end = beg + (1 << COST_TILE_SHIFT) - 1;
+	string seq;
+	if( reference->fetch(chr, beg, end, seq, false) && (seq.length() > 0) ) {
+		int num_masked = 0;
+		for (unsigned int i = 0; i < seq.length(); ++i) {
+			if(islower(seq[i])) { ++num_masked; }
+		}
+		frac = (double)num_masked / seq.length();
+	}
+
+	masked[key] = frac;
+	return frac;
+}
+
+// true if the BAM indexes have alignments in the tiles spanned by the
+// window [start, start+len) (1-based)
+//////////////////////////////////////////////////////////////
+bool CostModel_t::windowHasAlignments(int refid, int start, int len) {
+
+	if( (refid < 0) || (refid >= (int)occupied.size()) || (len <= 0) ) { return false; }
+
+	int first = (start - 1) >> COST_TILE_SHIFT;
+	int last = (start - 1 + len - 1) >> COST_TILE_SHIFT;
+	for (int t = first; t <= last && t < (int)occupied[refid].size(); ++t) {
+		if(occupied[refid][t]) { return true; }
+	}
+	return false;
+}
+
+// estimated compressed bytes of the alignments (in all the indexes loaded)
+// overlapping the window [start, start+len) (1-based)
+// the resolution is one tile: 0 means that no index has alignments in the
+// tiles spanned by the window
+//////////////////////////////////////////////////////////////
+double CostModel_t::windowBytes(int refid, int start, int len) {
+
+	double size = 0;
+	if( (refid < 0) || (refid >= (int)bytes.size()) || (len <= 0) ) { return size; }
+
+	int beg = start - 1; // 0-based
+	int end = beg + len;
+	int first = beg >> COST_TILE_SHIFT;
+	int last = (end - 1) >> COST_TILE_SHIFT;
+
+	for (int t = first; t <= last && t < (int)bytes[refid].size(); ++t) {
+		int tbeg = t << COST_TILE_SHIFT;
+		int tend = tbeg + (1 << COST_TILE_SHIFT);
+		int overlap = min(end, tend) - max(beg, tbeg);
+		size += bytes[refid][t] * overlap / (1 << COST_TILE_SHIFT);
+	}
+
+	return size;
+}
+
+// estimated cost of the window [start, start+len) (1-based)
+// (arbitrary units: 1 per window plus 1 per KB of alignments, weighted by
+// the repeat content of the reference)
+//////////////////////////////////////////////////////////////
+double CostModel_t::windowCost(const string & chr, int refid, int start, int len) {
+
+	double kb = windowBytes(refid, start, len) / 1024.0;
+	double weight = 1;
+
+	if( (reference != NULL) && (refid >= 0) && (len > 0) ) {
+		int beg = start - 1; // 0-based
+		int end = beg + len;
+		int first = beg >> COST_TILE_SHIFT;
+		int last = (end - 1) >> COST_TILE_SHIFT;
+
+		for (int t = first; t <= last; ++t) {
+			int tbeg = t << COST_TILE_SHIFT;
+			int tend = tbeg + (1 << COST_TILE_SHIFT);
+			int overlap = min(end, tend) - max(beg, tbeg);
+			weight += REPEAT_WEIGHT * maskedFraction(chr, refid, t) * overlap / len;
+		}
+	}
+
+	return 1 + kb * weight;
+}
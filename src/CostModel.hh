@@ -0,0 +1,72 @@
+#ifndef COSTMODEL_HH
+#define COSTMODEL_HH 1
+
+/****************************************************************************
+** CostModel.hh
+**
+** Estimate of the cost of assembling a window, computed before any read is
+** decoded. The BAM indexes (BAI) give the compressed bytes of the
+** alignments in each 16kb bin (from the virtual offsets of the bin chunks)
+** and the soft-masked fraction of the reference gives its repeat content
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cctype>
+#include <algorithm>
+#include <stdint.h>
+
+#include "util.hh"
+#include "RefProvider.hh"
+
+using namespace std;
+
+#define COST_TILE_SHIFT 14 // size of the tiles of the cost model: 16kb (leaf bins of the BAI)
+#define BGZF_RATIO 3.0 // assumed compression ratio of the BGZF blocks
+#define REPEAT_WEIGHT 4.0 // cost multiplier of a fully repeat-masked window
+
+class CostModel_t
+{
+public:
+
+	CostModel_t() : reference(NULL) { }
+
+	bool loadIndex(const string & bamfile);
+	void setReference(RefProvider_t * reference_) { reference = reference_; }
+	bool windowHasAlignments(int refid, int start, int len);
+	double windowBytes(int refid, int start, int len);
+	double windowCost(const string & chr, int refid, int start, int len);
+
+private:
+
+	RefProvider_t * reference; // reference (repeat content), NULL to ignore
+	vector< vector<double> > bytes; // estimated compressed bytes by reference id and tile
+	vector< vector<char> > occupied; // tiles with alignments by reference id
+	map< pair<int,int>, double > masked; // soft-masked fraction by reference id and tile
+
+	bool readIndex(const string & filename);
+	void markParentBin(vector<char> & used, int first, int last, int child_span, const pair<uint64_t,uint64_t> & chunk,
+	                   const vector<int> & leaf_tile, const vector<uint64_t> & leaf_beg, const vector<uint64_t> & leaf_end);
+	double maskedFraction(const string & chr, int refid, int tile);
+};
+
+#endif
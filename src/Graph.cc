@@ -31,6 +31,7 @@ void Graph_t::clear(bool flag)
 	if(flag) {
 		//readid2info.clear();
 		vector<ReadInfo_t>().swap(readid2info); 
+		reads.clear(); // release the bases and names of all the reads at once
 		is_ref_added = false; // reference reads was in readid2info and removed
 	}
 	totalreadbp_m = 0;
@@ -51,12 +52,8 @@ void Graph_t::clear(bool flag)
 	source_m = NULL;
 	sink_m = NULL;
 
-	if (ref_m && flag == true)
-	{
-		ref_m->clear();
-		delete ref_m;
-		ref_m = NULL;
-	}	
+	// the reference window is owned (and freed) by the caller
+	if (flag == true) { ref_m = NULL; }
 }
 
 
@@ -116,15 +113,22 @@ string Graph_t::getBXsetAt(int start, int end, string & seq, int sample) {
 // loadSequence
 //////////////////////////////////////////////////////////////
 
-void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bool isRef, int trim5, unsigned int strand)
+void Graph_t::loadSequence(int readid, bool isRef)
 {	
+	ReadInfo_t & info = readid2info[readid];
+	int len = info.len_m;
+	int trim5 = info.trm5;
+	unsigned int strand = info.strand;
+	const char * qv = reads.quals(info);
+
 	if (!isRef)
 	{
-		totalreadbp_m += seq.length();
+		totalreadbp_m += len;
 	}
 		
 	CanonicalMer_t uc;
 	CanonicalMer_t vc;
+	string mer; // k-mers are extracted from the packed bases of the read
 	string uc_qv;
 	string vc_qv;
 	
@@ -136,25 +140,31 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 
 	unordered_set<Mer_t> readmers;
 
-	int sample = readid2info[readid].label_m; // TMR or NML
+	int sample = info.label_m; // TMR or NML
+	int colour = 0; // own colour of the tumor in multi-tumor mode (0 otherwise)
+	if (sample >= SMP) { colour = sample; sample = TMR; }
+	const string & bx = *(info.BX);
 
-	int end = seq.length() - K;
+	int end = len - K;
 	int offset = 0;
 	for (; offset < end; ++offset)
 	{			
 		if (offset == 0) {
-			uc.set(seq.substr(offset,   K));
-			vc.set(seq.substr(offset+1, K));	
-			uc_qv = qv.substr(offset,   K);
-			vc_qv = qv.substr(offset+1, K);
+			reads.kmer(info, offset, K, mer);
+			uc.set(mer);
+			reads.kmer(info, offset+1, K, mer);
+			vc.set(mer);
+			uc_qv.assign(qv + offset,   K);
+			vc_qv.assign(qv + offset+1, K);
 			if (uc.ori_m == R) { reverse(uc_qv); }
 			if (vc.ori_m == R) { reverse(vc_qv); }
 		}
 		else {
 			uc = vc; 
 			uc_qv = vc_qv; 
-			vc.set(seq.substr(offset+1, K));
-			vc_qv = qv.substr(offset+1, K);
+			reads.kmer(info, offset+1, K, mer);
+			vc.set(mer);
+			vc_qv.assign(qv + offset+1, K);
 			if (vc.ori_m == R) { reverse(vc_qv); }
 		}
 
@@ -229,8 +239,8 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 				
 		// add mate name info to the nodes
 		// (used to check for overlapping mates)
-		unode->addMateName(readid2info[readid].readname_m, readid2info[readid].mate_order_m);
-		vnode->addMateName(readid2info[readid].readname_m, readid2info[readid].mate_order_m);
+		unode->addMateName(info.readname_m, info.mate_order_m);
+		vnode->addMateName(info.readname_m, info.mate_order_m);
 		
 		bool isOvlMate = false;
 		//bool bxovl_u = false;
@@ -240,25 +250,25 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 										
 			if (offset == 0) {
 								
-				if (readid2info[readid].BX != "null") { // skip over null barcodes
-					addBX(readid2info[readid].BX, uc.mer_m, sample);
-					ref_m->addBX(readid2info[readid].BX, uc.mer_m, sample);
+				if (bx != "null") { // skip over null barcodes
+					addBX(bx, uc.mer_m, sample);
+					ref_m->addBX(bx, uc.mer_m, sample);
 				}
 				
-				if(!(unode->hasBX(readid2info[readid].BX, sample))) { // update only if BX not already present in this node
-					unode->addBX(readid2info[readid].BX, strand, sample);
-					unode->addHP(readid2info[readid].HP, sample);
+				if(!(unode->hasBX(bx, sample))) { // update only if BX not already present in this node
+					unode->addBX(bx, strand, sample);
+					unode->addHP(info.HP, sample);
 				}
 			}	
 			
-			if (readid2info[readid].BX != "null") { // skip over null barcodes
-				addBX(readid2info[readid].BX, vc.mer_m, sample);
-				ref_m->addBX(readid2info[readid].BX, vc.mer_m, sample);
+			if (bx != "null") { // skip over null barcodes
+				addBX(bx, vc.mer_m, sample);
+				ref_m->addBX(bx, vc.mer_m, sample);
 			}
 			
-			if(!(vnode->hasBX(readid2info[readid].BX, sample))) { // update only if BX not already present in this node
-				vnode->addBX(readid2info[readid].BX, strand, sample);
-				vnode->addHP(readid2info[readid].HP, sample);
+			if(!(vnode->hasBX(bx, sample))) { // update only if BX not already present in this node
+				vnode->addBX(bx, strand, sample);
+				vnode->addHP(info.HP, sample);
 			}
 		}
 		
@@ -266,9 +276,9 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 		{		
 			if (offset == 0) 
 			{ 
-				isOvlMate = (unode->hasOverlappingMate(readid2info[readid].readname_m, readid2info[readid].mate_order_m)); //kmer from overlapping mates
+				isOvlMate = (unode->hasOverlappingMate(info.readname_m, info.mate_order_m)); //kmer from overlapping mates
 				
-				//if(isOvlMate) { cerr << "Overlapping mates for fragment:" << readid2info[readid].readname_m << endl; }
+				//if(isOvlMate) { cerr << "Overlapping mates for fragment:" << *(info.readname_m) << endl; }
 									
 				if( !isOvlMate) { // do not update coverage for overlapping mates
 										
@@ -284,6 +294,11 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 						unode->updateCovDistr((int)(unode->getCov(strand,sample)), uc_qv, strand, sample); 
 						ref_m->updateCoverage(uc.mer_m, (int)(unode->getCov(strand,sample)), strand, sample); // update reference k-mer coverage
 					}
+					if(colour) { // coverage of the tumor on its own
+						unode->incCov(strand, colour);
+						unode->updateCovDistr((int)(unode->getCov(strand,colour)), uc_qv, strand, colour); 
+						ref_m->updateCoverage(uc.mer_m, (int)(unode->getCov(strand,colour)), strand, colour);
+					}
 
 					if (uc.ori_m == F)
 					{
@@ -296,9 +311,9 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 				}
 			}
 			
-			isOvlMate = (vnode->hasOverlappingMate(readid2info[readid].readname_m, readid2info[readid].mate_order_m));
+			isOvlMate = (vnode->hasOverlappingMate(info.readname_m, info.mate_order_m));
 
-			//if(isOvlMate) { cerr << "Overlapping mates for fragment:" << readid2info[readid].readname_m << endl; }
+			//if(isOvlMate) { cerr << "Overlapping mates for fragment:" << *(info.readname_m) << endl; }
 
 			if( !isOvlMate ) { // do not update coverage for overlapping mates
 								
@@ -314,6 +329,11 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 						vnode->updateCovDistr((int)(vnode->getCov(strand,sample)), vc_qv, strand, sample); 
 						ref_m->updateCoverage(vc.mer_m, (int)(vnode->getCov(strand,sample)), strand, sample); // update reference k-mer coverage
 					}
+					if(colour) { // coverage of the tumor on its own
+						vnode->incCov(strand, colour);
+						vnode->updateCovDistr((int)(vnode->getCov(strand,colour)), vc_qv, strand, colour); 
+						ref_m->updateCoverage(vc.mer_m, (int)(vnode->getCov(strand,colour)), strand, colour);
+					}
 			}
 		}
 		
@@ -329,7 +349,7 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 
 		if (readmers.find(vc.mer_m) != readmers.end())
 		{
-			if (VERBOSE) { cerr << "cycle detected in read " << readid << " offset: " << offset << " : " << seq << endl; }
+			if (VERBOSE) { string seq; reads.sequence(info, seq); cerr << "cycle detected in read " << readid << " offset: " << offset << " : " << seq << endl; }
 
 			if (readid > -1)
 			{
@@ -352,73 +372,32 @@ void Graph_t::loadSequence(int readid, const string & seq, const string & qv, bo
 // trim
 //////////////////////////////////////////////////////////////
 
-void Graph_t::trim(int readid, const string & seq, const string & qv, bool isRef)
+void Graph_t::trim(ReadInfo_t & info, const string & seq, const string & qv)
 {
 	int trim3 = 0;
 	int trim5 = 0;
 	int len = seq.length();
-	string cseq = seq;
-
-	for (int i = 0; i < len; ++i) { cseq[i] = toupper(cseq[i]); }
 
 	while ((!isDNA(seq[trim5]) || (qv[trim5] < MIN_QUAL_TRIM)) && (trim5 < len)) { ++trim5; }
 
 	if (trim5 < len) {
 		while ((!isDNA(seq[len-1-trim3]) || (qv[len-1-trim3] < MIN_QUAL_TRIM)) && (trim3 < len)) { ++trim3; }
 
-		readid2info[readid].isjunk = false;
+		info.isjunk = false;
 		
 		for (int i = trim5; i < len-trim3; ++i)
 		{
 			if (!isDNA(seq[i])) {
 				// skip the junk
-				readid2info[readid].isjunk = true;
+				info.isjunk = true;
 				break;
 			}
 		}
 	}
-	else { readid2info[readid].isjunk = true; }
+	else { info.isjunk = true; }
 	
-	readid2info[readid].trm5 = trim5;
-	readid2info[readid].trm3 = trim3;
-}
-
-// trimAndLoad
-//////////////////////////////////////////////////////////////
-
-void Graph_t::trimAndLoad(int readid, const string & seq, const string & qv, bool isRef, unsigned int strand)
-{
-	int len = seq.length();
-	string cseq = seq;
-
-	for (int i = 0; i < len; ++i) { cseq[i] = toupper(cseq[i]); }
-
-	int trim5 = 0;
-	while ((!isDNA(seq[trim5]) || (qv[trim5] < MIN_QUAL_TRIM)) && (trim5 < len)) { ++trim5; }
-
-	if (trim5 < len)
-	{
-		int trim3 = 0;
-		while ((!isDNA(seq[len-1-trim3]) || (qv[len-1-trim3] < MIN_QUAL_TRIM)) && (trim3 < len)) { ++trim3; }
-
-		bool cleanRead = true;
-
-		for (int i = trim5; i < len-trim3; ++i)
-		{
-			if (!isDNA(seq[i]))
-			{
-				// skip the junk
-				cleanRead = false;
-				break;
-			}
-		}
-
-		if (cleanRead)
-		{
-			if (trim5 || trim3) { cseq = seq.substr(trim5, len-trim5-trim3); }
-			loadSequence(readid, cseq, qv, isRef, trim5, strand);
-		}
-	}
+	info.trm5 = trim5;
+	info.trm3 = trim3;
 }
 
 int Graph_t::countBastardReads()
@@ -452,12 +431,18 @@ int Graph_t::countMappedReads()
 }
 
 // addRead
+// store the read (trimmed if requested) in the arena of the window
 ////////////////////////////////////////////////////////////////
 
-ReadId_t Graph_t::addRead(const string & set, const string & readname, const string & seq, const string & qv, char code, int label, unsigned int strand, int mate_order, const string & bx, const int hp)
+ReadId_t Graph_t::addRead(const string & set, const string & readname, const string & seq, const string & qv, char code, int label, unsigned int strand, int mate_order, const string & bx, const int hp, bool trimRead)
 {
 	ReadId_t retval = readid2info.size();
-	readid2info.push_back(ReadInfo_t(label, set, readname, seq, qv, code, strand, mate_order, bx, hp));
+	readid2info.push_back(ReadInfo_t(label, reads.intern(set), reads.intern(readname), code, strand, mate_order, reads.intern(bx), hp));
+
+	ReadInfo_t & info = readid2info.back();
+	if (trimRead) { trim(info, seq, qv); }
+	reads.store(info, seq, qv);
+
 	return retval;
 }
 
@@ -477,7 +462,7 @@ void Graph_t::printReads()
 {
 	for (unsigned int i = 0; i < readid2info.size(); ++i)
 	{
-		cout << i << "\t" << readid2info[i].readname_m << "\t" << readid2info[i].set_m << endl;
+		cout << i << "\t" << *(readid2info[i].readname_m) << "\t" << *(readid2info[i].set_m) << endl;
 	}
 }
 
@@ -496,8 +481,7 @@ void Graph_t::addAlignment(const string & set,
 	const int hp)
 	
 {
-	int rd = addRead(set, readname, seq, qv, code, label, strand, mate_id, bx, hp);
-	trim(rd, seq, qv, false);
+	addRead(set, readname, seq, qv, code, label, strand, mate_id, bx, hp, true);
 }
 
 // addpaired
@@ -539,32 +523,11 @@ void Graph_t::buildgraph(Ref_t * refinfo)
 		if (VERBOSE) { cerr << "refid: " << refid << endl; }
 	}	
 		
+	// the reads are stored trimmed in the arena
 	for (unsigned int i = 0; i < readid2info.size(); ++i)
 	{
 		if ( !(readid2info[i].isjunk) ) { // skip junk (not A,C,G,T)
-			string seq; // = readid2info[i].seq_m;
-			string qv; // = readid2info[i].qv_m;
-			int len = (readid2info[i].seq_m).length();
-			int t5 = readid2info[i].trm5;
-			int t3 = readid2info[i].trm3;
-			unsigned int strand = readid2info[i].strand;
-			//string cseq = seq;
-			//string cqv = qv;
-			if (t5 || t3) { 
-				seq = (readid2info[i].seq_m).substr(t5, len-t5-t3); 
-				qv = (readid2info[i].qv_m).substr(t5, len-t5-t3); 
-			}
-			else {
-				seq = readid2info[i].seq_m;
-				qv = readid2info[i].qv_m;
-			}
-																			
-			if(readid2info[i].label_m == REF) {
-				loadSequence(i, seq, qv, true, t5, strand);
-			}
-			else {
-				loadSequence(i, seq, qv, false, t5, strand);
-			}			
+			loadSequence(i, (readid2info[i].label_m == REF));
 		}
 	}
 	
@@ -573,8 +536,8 @@ void Graph_t::buildgraph(Ref_t * refinfo)
 	for (mi = nodes_m.begin(); mi != nodes_m.end(); ++mi) {
 		(mi->second)->computeMinCov();
 		
-		sort((mi->second)->mate1_name.begin(), (mi->second)->mate1_name.end()); // sort mate1 names
-		sort((mi->second)->mate2_name.begin(), (mi->second)->mate2_name.end()); // sort mate2 names
+		sort((mi->second)->mate1_name.begin(), (mi->second)->mate1_name.end(), Node_t::lessName); // sort mate1 names
+		sort((mi->second)->mate2_name.begin(), (mi->second)->mate2_name.end(), Node_t::lessName); // sort mate2 names
 		
 		(mi->second)->mate1_name.erase(unique((mi->second)->mate1_name.begin(), (mi->second)->mate1_name.end()), (mi->second)->mate1_name.end()); // remove duplicates
 		(mi->second)->mate2_name.erase(unique((mi->second)->mate2_name.begin(), (mi->second)->mate2_name.end()), (mi->second)->mate2_name.end()); // remove duplicates
@@ -584,6 +547,7 @@ void Graph_t::buildgraph(Ref_t * refinfo)
 	
 	ref_m->computeCoverage(TMR);
 	ref_m->computeCoverage(NML);
+	for (int t = 0; t < ref_m->numSamples(); ++t) { ref_m->computeCoverage(SMP+t); }
 	//if (verbose) { ref_m->printKmerCoverage(NML); }
 	//if (verbose) { ref_m->printKmerCoverage(TMR); }
 }
@@ -812,6 +776,12 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 	
 	assert(coverageN.size() == coverageT.size());
 	
+	// coverage of each tumor of a multi-tumor run
+	vector< vector<cov_t> > coverageS(NUM_TUMORS);
+	for (int t = 0; t < NUM_TUMORS; ++t) { coverageS[t] = path->covDistr('S', t); }
+	vector<cov_t> COVs(NUM_TUMORS);
+	vector<cov_t> REFs(NUM_TUMORS);
+	
 	string pathseq = path->str();
 	
 	// Run global align if strings have different length or large hamming distance	
@@ -920,7 +890,7 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 				/*
 				unordered_set<ReadId_t>::const_iterator it;
 				for (auto it = spanner->reads_m.begin(); it != spanner->reads_m.end(); it++) {
-					cerr << readid2info[*it].readname_m.c_str() << endl;
+					cerr << readid2info[*it].readname_m->c_str() << endl;
 				}
 				*/
 			}			
@@ -939,6 +909,11 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 			
 			cov_t REFn = ref->getCovStructAt(pos_in_ref+ref->trim5, NML);
 			cov_t REFt = ref->getCovStructAt(pos_in_ref+ref->trim5, TMR);
+			
+			for (int t = 0; t < NUM_TUMORS; ++t) {
+				COVs[t] = coverageS[t][P];
+				REFs[t] = ref->getCovStructAt(pos_in_ref+ref->trim5, SMP+t);
+			}
 			//cov_t REFn = ref->getCovStructAt(pos_in_ref, NML);
 			//cov_t REFt = ref->getCovStructAt(pos_in_ref, TMR);
 			/*
@@ -1003,17 +978,21 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 					if ( (code == '^') && (transcript[ts-1].code == code) && (transcript[ts-1].pos == rrpos) ) { // extending insertion
 						transcript[ts-1].addAltCovNml(COVn);
 						transcript[ts-1].addAltCovTmr(COVt);
+						transcript[ts-1].addAltCovSmp(COVs);
 					} 
 					else if ( (code == 'v') && (transcript[ts-1].code == code) && ((transcript[ts-1].pos + transcript[ts-1].ref.length()) == rrpos) ) { // extending deletion
 						transcript[ts-1].addRefCovNml(REFn);
 						transcript[ts-1].addRefCovTmr(REFt);
+						transcript[ts-1].addRefCovSmp(REFs);
 					} 
 					else if ( (code == 'x') || (transcript[ts-1].code != code) ) { // extending complex replacement event
 						transcript[ts-1].code = 'c'; // complex transcript
 						transcript[ts-1].addAltCovNml(COVn);
 						transcript[ts-1].addAltCovTmr(COVt);
+						transcript[ts-1].addAltCovSmp(COVs);
 						transcript[ts-1].addRefCovNml(REFn);
 						transcript[ts-1].addRefCovTmr(REFt);
+						transcript[ts-1].addRefCovSmp(REFs);
 					}
 				}
 				
@@ -1024,6 +1003,7 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 						COVn, COVt, REFn, REFt,
 						ref_aln[pr], path_aln[pa], 
 						P, pos_in_ref, within_tumor_node));
+					transcript.back().setSmpCov(COVs, REFs);
 				}
 			}
 		}
@@ -1094,6 +1074,8 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 						// debug end
 						transcript[ti].addAltCovNml(coverageN[idx1]);
 						transcript[ti].addAltCovTmr(coverageT[idx1]);
+						for (int t = 0; t < NUM_TUMORS; ++t) { COVs[t] = coverageS[t][idx1]; }
+						transcript[ti].addAltCovSmp(COVs);
 					}
 					unsigned int idx2 = transcript[ti].ref_end_pos + ref->trim5 + j;
 					// debug start
@@ -1108,6 +1090,8 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 					// debug end
 					transcript[ti].addRefCovNml(ref->getCovStructAt(idx2, NML));
 					transcript[ti].addRefCovTmr(ref->getCovStructAt(idx2, TMR));
+					for (int t = 0; t < NUM_TUMORS; ++t) { REFs[t] = ref->getCovStructAt(idx2, SMP+t); }
+					transcript[ti].addRefCovSmp(REFs);
 				}
 			}
 			
@@ -1176,6 +1160,19 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 				HP0AN = 0; HP1AN = 0; HP2AN = 0;
 			}
 			
+			// ref fwd, ref rev, alt fwd and alt rev coverage of each tumor (multi-tumor mode)
+			vector< array<unsigned short,4> > TS(NUM_TUMORS);
+			for (int t = 0; t < NUM_TUMORS; ++t) {
+				if(transcript[ti].isSomatic) {
+					TS[t] = {{ (unsigned short)transcript[ti].getAvgRefCovSfwd(t), (unsigned short)transcript[ti].getAvgRefCovSrev(t), 
+						(unsigned short)transcript[ti].getMinCovSfwd(t), (unsigned short)transcript[ti].getMinCovSrev(t) }};
+				}
+				else {
+					TS[t] = {{ (unsigned short)transcript[ti].getMinRefCovSfwd(t), (unsigned short)transcript[ti].getMinRefCovSrev(t), 
+						(unsigned short)transcript[ti].getMinCovSfwd(t), (unsigned short)transcript[ti].getMinCovSrev(t) }};
+				}
+			}
+			
 			//int ACTF = (transcript[ti].code=='x') ? transcript[ti].getMinCovTfwd() : transcript[ti].getMedianCovTfwd(); // alt tumor cov fwd
 			//int ACTR = (transcript[ti].code=='x') ? transcript[ti].getMinCovTrev() : transcript[ti].getMedianCovTrev(); // alt tumor cov rev
 					
@@ -1234,12 +1231,14 @@ void Graph_t::processPath(Path_t * path, Ref_t * ref, FILE * fp, bool printPaths
 				cerr << RCN.first << " " << RCN.second << " " << RCT.first << " " << RCT.second << " " << ACN.first << " " << ACN.second << " " << ACT.first << " " << ACT.second << endl;
 				cerr << "==================e" << endl;
 
-				vDB->addVar(Variant_t(LR_MODE, ref->refchr, transcript[ti].pos-1, transcript[ti].ref, transcript[ti].qry, transcript[ti].isSomatic,
+				Variant_t var(LR_MODE, ref->refchr, transcript[ti].pos-1, transcript[ti].ref, transcript[ti].qry, transcript[ti].isSomatic,
 					similar_variants_count,
 					RCN, RCT, ACN, ACT,
 					HPRN, HPRT, HPAN, HPAT,
 					transcript[ti].prev_bp_ref, transcript[ti].prev_bp_alt, K, STR.str(), transcript[ti].code,
-					bxset_ref_N, bxset_ref_T, bxset_alt_N, bxset_alt_T));
+					bxset_ref_N, bxset_ref_T, bxset_alt_N, bxset_alt_T);
+				var.tumors = TS;
+				vDB->addVar(var);
 			}
 		}
 		if(verbose) { cerr << endl; }
@@ -1730,7 +1729,7 @@ string Graph_t::nodeColor(Node_t * cur, string & who)
 	unordered_set<ReadId_t>::const_iterator si;
 	for (si = cur->reads_m.begin(); si != cur->reads_m.end(); ++si)
 	{
-		++(whocnt[readid2info[*si].set_m]);
+		++(whocnt[*(readid2info[*si].set_m)]);
 	}
 
 	bool isTumor = cur->isTumor();
@@ -1803,9 +1802,9 @@ void Graph_t::printDot(const string & filename, int compid)
 		for (unsigned int i = 0; i < readid2info.size(); ++i)
 		{
 			fprintf(fp, "// %s %d %s -> %d (%s)\n",
-				readid2info[i].set_m.c_str(),
+				readid2info[i].set_m->c_str(),
 				i, 
-				readid2info[i].readname_m.c_str(),
+				readid2info[i].readname_m->c_str(),
 				readid2info[i].mateid_m, 
 				readid2info[i].contigid_m.c_str());
 		}
@@ -2410,7 +2409,7 @@ void Graph_t::denovoNodes(const string & filename, const string & refname)
 		unordered_set<ReadId_t>::const_iterator si;
 		for (si = cur->reads_m.begin(); si != cur->reads_m.end(); ++si)
 		{
-			string & set = readid2info[*si].set_m;
+			const string & set = *(readid2info[*si].set_m);
 			if (set != "ref")
 			{
 				++(who[set]);
@@ -2667,6 +2666,17 @@ void Graph_t::compressNode(Node_t * node, Ori_t dir)
 		}
 		*/
 		
+		// tumors of a multi-tumor run (before the tumor distribution grows)
+		int nsmp = max(node->numSamples(), buddy->numSamples());
+		if (nsmp > 0) { node->smpCovDistr(nsmp-1); buddy->smpCovDistr(nsmp-1); }
+		for (int t = 0; t < nsmp; ++t) {
+			for (unsigned int j = (K-1); j < buddy->cov_distr_smp[t].size(); ++j) {
+				node->cov_distr_smp[t].push_back(buddy->cov_distr_smp[t][j]);
+			}
+			node->cov_smp_fwd[t] = ((node->cov_smp_fwd[t] * amerlen) + (buddy->cov_smp_fwd[t] * bmerlen)) / (amerlen + bmerlen);
+			node->cov_smp_rev[t] = ((node->cov_smp_rev[t] * amerlen) + (buddy->cov_smp_rev[t] * bmerlen)) / (amerlen + bmerlen);
+		}
+		
 		for (unsigned int j = (K-1); j < buddy->cov_distr_tmr.size(); ++j) {
 			node->cov_distr_tmr.push_back(buddy->cov_distr_tmr[j]); // tumor
 			node->cov_distr_nml.push_back(buddy->cov_distr_nml[j]); // normal
@@ -3348,6 +3358,9 @@ void Graph_t::threadReads(int compid)
 									copy->cov_status = cur->cov_status; // T=tumot,N=normal,B=both,E=empty
 									copy->cov_distr_tmr = cur->cov_distr_tmr;
 									copy->cov_distr_nml = cur->cov_distr_nml;;
+									copy->cov_distr_smp = cur->cov_distr_smp;
+									copy->cov_smp_fwd.assign(cur->cov_smp_fwd.size(), overlap.size());
+									copy->cov_smp_rev.assign(cur->cov_smp_rev.size(), overlap.size());
 									//copy->updateCovDistr(overlap.size()); // coverage distribution
 
 									if(cur->isRef()) { copy->setIsRef(); }
@@ -3461,7 +3474,8 @@ void Graph_t::checkReadStarts(int compid)
 				ReadInfo_t & rinfo   = readid2info[rid];
 
 				string ckmer;
-				string rkmer = rinfo.seq_m.substr(rstart.trim5_m, K);
+				string rkmer;
+				reads.kmer(rinfo, 0, min(K, (int)rinfo.len_m), rkmer);
 
 				++all;
 
@@ -3477,7 +3491,7 @@ void Graph_t::checkReadStarts(int compid)
 
 				if ((rkmer != ckmer)) // || VERBOSE)
 				{
-					cerr << "Checking " << rid << " " << rinfo.readname_m 
+					cerr << "Checking " << rid << " " << *(rinfo.readname_m) 
 						<< " " << rstart.ori_m 
 						<< " offset:" << rstart.nodeoffset_m 
 						<< " trim5:" << rstart.trim5_m << endl;
@@ -3655,8 +3669,8 @@ void Graph_t::bundleMates()
 						cerr << Edge_t::toString(linkdir) << ":" << linkdist << "\t"
 							<< lo << "\t" << hi << "\t"
 							<< rinfo.code_m << "\t" << dup << "\t"
-							<< rid << "\t"  << rinfo.readname_m <<  "\t" << rstart.nodeoffset_m << "\t" << rstart.ori_m << "\t"
-							<< mid << "\t"  << minfo.readname_m <<  "\t" << mstart.nodeoffset_m << "\t" << mstart.ori_m << endl;
+							<< rid << "\t"  << *(rinfo.readname_m) <<  "\t" << rstart.nodeoffset_m << "\t" << rstart.ori_m << "\t"
+							<< mid << "\t"  << *(minfo.readname_m) <<  "\t" << mstart.nodeoffset_m << "\t" << mstart.ori_m << endl;
 					}
 
 					if (!dup)
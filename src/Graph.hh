@@ -39,6 +39,7 @@
 #include "util.hh"
 #include "Edge.hh"
 #include "Node.hh"
+#include "ReadArena.hh"
 #include "Mer.hh"
 #include "Ref.hh"
 #include "ContigLink.hh"
@@ -90,6 +91,7 @@ public:
 	bool PRINT_DOT_READS;
 	
 	bool LR_MODE;
+	int NUM_TUMORS; // tumors with their own colour (multi-tumor mode, 0 otherwise)
 
 	int MIN_QUAL_TRIM;
 	int MIN_QUAL_CALL;
@@ -127,6 +129,7 @@ public:
 	bool is_ref_added;
 
 	ReadInfoList_t readid2info;
+	ReadArena_t reads; // bases, quality values and names of the reads in readid2info
 	int readCycles;
 	
 	VariantDB_t *vDB; // DB of variants
@@ -135,7 +138,7 @@ public:
 	unordered_map<Mer_t,set<string>> bx_table_tmr; // mer to barcode map for tumor
 	unordered_map<Mer_t,set<string>> bx_table_nml; // mer to barcode map for normal
 
-	Graph_t() : ref_m(NULL), is_ref_added(0), readCycles(0) {
+	Graph_t() : NUM_TUMORS(0), ref_m(NULL), is_ref_added(0), readCycles(0) {
 		clear(true); 
 	}
 
@@ -161,6 +164,7 @@ public:
 	void setMaxMismatch(int mm) { MAX_MISMATCH = mm; }
 	void setFilters(Filters * fs) { filters = fs; }
 	void setLRMode(bool mode) { LR_MODE = mode; }
+	void setNumTumors(int n) { NUM_TUMORS = n; }
 	
 	//set STR params
 	void setMaxUnitLen(int l) { MAX_UNIT_LEN = l; }
@@ -171,16 +175,15 @@ public:
 	bool hasRepeatsInGraphPaths(Ref_t * ref) { return findRepeatsInGraphPaths(source_m, sink_m, F, ref); }
 
 	void clear(bool flag);
-	void loadSequence(int readid, const string & seq, const string & qv, bool isRef, int trim5, unsigned int strand);
-	void trimAndLoad(int readid, const string & seq, const string & qv, bool isRef, unsigned int strand);
-	void trim(int readid, const string & seq, const string & qv, bool isRef);
+	void loadSequence(int readid, bool isRef);
+	void trim(ReadInfo_t & info, const string & seq, const string & qv);
 	void buildgraph(Ref_t * refinfo);
 
 	int countBastardReads();
 
 	int countMappedReads();
 
-	ReadId_t addRead(const string & set, const string & readname, const string & seq, const string & qv, char code, int label, unsigned int strand, int mate_order, const string & bx, const int hp);
+	ReadId_t addRead(const string & set, const string & readname, const string & seq, const string & qv, char code, int label, unsigned int strand, int mate_order, const string & bx, const int hp, bool trimRead = false);
 
 	void addMates(ReadId_t r1, ReadId_t r2);
 
@@ -0,0 +1,140 @@
+#include "Journal.hh"
+
+/****************************************************************************
+** Journal.cc
+**
+** Append-only journal of the completed windows and of the variants they
+** produced. Each thread flushes its records periodically, so an interrupted
+** run can be resumed (--resume) skipping the windows already completed
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// Journal format:
+//
+// #lancet-journal <key>
+// W <window id> <number of variants>
+// <variant> (one line per variant, VCF record printed in shard mode)
+// ...
+
+// load the windows completed by a previous run with the same key: the
+// windows are marked as completed in the queue and their variants are
+// added to db. An incomplete record at the end of the file (interrupted
+// write) is discarded.
+// returns the number of completed windows (-1 on error)
+//////////////////////////////////////////////////////////////
+int Journal_t::load(const string & fname, const string & key, bool lrmode, WindowQueue_t & queue, VariantDB_t & db) {
+
+	ifstream jfile(fname);
+	if (!jfile.is_open()) { return 0; }
+
+	string line;
+	if( !getline(jfile, line) || (line != "#lancet-journal\t" + key) ) {
+		cerr << "Error: journal " << fname << " was written by a run with different input, windows or parameters" << endl;
+		return -1;
+	}
+	long valid_end = jfile.tellg(); // end of the last complete record
+
+	int num_loaded = 0;
+	vector<Variant_t> variants;
+	while ( getline(jfile, line) ) {
+
+		int window = -1;
+		int num_variants = -1;
+		if( (sscanf(line.c_str(), "W\t%d\t%d", &window, &num_variants) != 2) ||
+			(window < 0) || (window >= queue.size()) || (num_variants < 0) ) { break; }
+
+		variants.clear();
+		bool complete = true;
+		for (int i = 0; i < num_variants; ++i) {
+			Variant_t v;
+			if( !getline(jfile, line) || jfile.eof() || !v.parseVCF(line, lrmode) ) { complete = false; break; }
+			variants.push_back(v);
+		}
+		if(!complete || jfile.eof()) { break; } // last line was not terminated
+
+		for (unsigned int i = 0; i < variants.size(); ++i) { db.addVar(variants[i]); }
+		if(!queue.isCompleted(window)) { ++num_loaded; }
+		queue.markCompleted(window);
+
+		valid_end = jfile.tellg();
+	}
+	jfile.close();
+
+	// drop the incomplete tail before appending new records
+	if(truncate(fname.c_str(), valid_end) != 0) {
+		cerr << "Error: could not truncate journal " << fname << endl;
+		return -1;
+	}
+
+	return num_loaded;
+}
+
+// open the journal (a new journal starts with the key of the run)
+// returns false if the journal cannot be opened or written
+//////////////////////////////////////////////////////////////
+bool Journal_t::open(const string & fname, const string & key, bool append) {
+
+	filename = fname;
+	fp = fopen(filename.c_str(), append ? "a" : "w");
+	if (fp == NULL) {
+		cerr << "Couldn't open journal " << filename << endl;
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	if(ftell(fp) == 0) {
+		if( (fprintf(fp, "#lancet-journal\t%s\n", key.c_str()) < 0) || (fflush(fp) != 0) ) {
+			cerr << "Error: could not write to journal " << filename << endl;
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+// append the records of completed windows and sync them to disk
+// returns false if the records could not be written
+//////////////////////////////////////////////////////////////
+bool Journal_t::write(const string & records) {
+
+	if(fp == NULL || records.empty()) { return true; }
+
+	pthread_mutex_lock(&lock);
+	bool ok = (fwrite(records.data(), 1, records.size(), fp) == records.size()) && (fflush(fp) == 0);
+	if(ok) { fsync(fileno(fp)); }
+	pthread_mutex_unlock(&lock);
+
+	if(!ok) { cerr << "Error: could not write to journal " << filename << endl; }
+	return ok;
+}
+
+void Journal_t::close() {
+
+	if(fp != NULL) { fclose(fp); }
+	fp = NULL;
+}
+
+// add the record of a completed window to a thread buffer
+//////////////////////////////////////////////////////////////
+void Journal_t::addWindow(stringstream & buf, int window, vector<Variant_t> & variants, Filters * fs) {
+
+	buf << "W\t" << window << "\t" << variants.size() << "\n";
+	for (unsigned int i = 0; i < variants.size(); ++i) {
+		buf << variants[i].printVCF(fs, true);
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef JOURNAL_HH
+#define JOURNAL_HH 1
+
+/****************************************************************************
+** Journal.hh
+**
+** Append-only journal of the completed windows and of the variants they
+** produced. Each thread flushes its records periodically, so an interrupted
+** run can be resumed (--resume) skipping the windows already completed
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "util.hh"
+#include "Variant.hh"
+#include "VariantDB.hh"
+#include "WindowQueue.hh"
+
+using namespace std;
+
+class Journal_t
+{
+public:
+
+	Journal_t() : fp(NULL) { pthread_mutex_init(&lock, NULL); }
+	~Journal_t() { close(); pthread_mutex_destroy(&lock); }
+
+	int load(const string & filename, const string & key, bool lrmode, WindowQueue_t & queue, VariantDB_t & db);
+	bool open(const string & filename, const string & key, bool append);
+	bool write(const string & records);
+	void close();
+
+	static void addWindow(stringstream & buf, int window, vector<Variant_t> & variants, Filters * fs);
+
+private:
+
+	FILE * fp;
+	string filename;
+	pthread_mutex_t lock; // records are appended by all assembly threads
+};
+
+#endif
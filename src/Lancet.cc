@@ -40,69 +40,92 @@ void printUsage() {
 		"Version: "<< VERSION << "\n"
 		"Contact: Giuseppe Narzisi <gnarzisi@nygenome.org>\n";
 
-	string USAGE = "\nUsage: lancet [options] --tumor <BAM file> --normal <BAM file> --ref <FASTA file> --reg <chr:start-end>\n [-h for full list of commands]\n\n";
+	string USAGE = "\nUsage: lancet [options] --tumor <BAM file> --normal <BAM file> --ref <FASTA file> --reg <chr:start-end>\n"
+		"       lancet merge <shard VCF> [<shard VCF> ...]\n [-h for full list of commands]\n\n";
 
 	cerr << HEADER.str() << USAGE;
 }
 
 // print help text to stderr
-void printHelpText(Filters & filters) {
+void printHelpText(LancetConfig_t & cfg) {
 		
 	stringstream helptext;
 	helptext <<
 		"Required\n"
-		"   --tumor, -t              <BAM file>    : BAM file of mapped reads for tumor\n"
-		"   --normal, -n             <BAM file>    : BAM file of mapped reads for normal\n"
+		"   --tumor, -t              <BAM file>    : BAM (or CRAM) file of mapped reads for tumor (repeat for multiple tumors sharing the normal)\n"
+		"   --normal, -n             <BAM file>    : BAM (or CRAM) file of mapped reads for normal (repeat for the lanes/libraries of the normal)\n"
+		"                                            the files of a sample sequenced on several lanes or libraries can be given as a comma separated list\n"
+		"                                            (e.g. -t lane1.bam,lane2.bam): they are merged by position while reading\n"
 		"   --ref, -r                <FASTA file>  : FASTA file of reference genome\n"
 		"   --reg, -p                <string>      : genomic region (in chr:start-end format)\n"
 		"   --bed, -B                <string>      : genomic regions from file (BED format)\n"
 
 		"\nOptional\n"
-		"   --min-k, k                <int>         : min kmersize [default: " << minK << "]\n"
-		"   --max-k, -K               <int>         : max kmersize [default: " << maxK << "]\n"
-		"   --trim-lowqual, -q        <int>         : trim bases below qv at 5' and 3' [default: " << MIN_QV_TRIM << "]\n"
-		"   --min-base-qual, -C       <int>         : minimum base quality required to consider a base for SNV calling [default: " << MIN_QV_CALL << "]\n"
-		"   --quality-range, -Q       <char>        : quality value range [default: " << (char) QV_RANGE << "]\n"
-		"   --min-map-qual, -b        <int>         : minimum read mapping quality in Phred-scale [default: " << MIN_MAP_QUAL << "]\n"
-		"   --max-as-xs-diff, -Z      <int>         : maximum difference between AS and XS alignments scores [default: " << MAX_DELTA_AS_XS << "]\n"
-		"   --tip-len, -l             <int>         : max tip length [default: " << MAX_TIP_LEN << "]\n"
-		"   --cov-thr, -c             <int>         : min coverage threshold used to select reference anchors from the De Bruijn graph [default: " << COV_THRESHOLD << "]\n"
-		"   --cov-ratio, -x           <float>       : minimum coverage ratio used to remove nodes from the De Bruijn graph [default: " << MIN_COV_RATIO << "]\n"
-		"   --low-cov, -d             <int>         : low coverage threshold used to remove nodes from the De Bruijn graph [default: " << LOW_COV_THRESHOLD << "]\n"
-		"   --max-avg-cov, -u         <int>         : maximum average coverage allowed per region [default: " << MAX_AVG_COV << "]\n"
-		"   --window-size, -w         <int>         : window size of the region to assemble (in base-pairs) [default: " << WINDOW_SIZE << "]\n"
-		"   --padding, -P             <int>         : left/right padding (in base-pairs) applied to the input genomic regions [default: " << PADDING << "]\n"
-		"   --dfs-limit, -F           <int>         : limit dfs/bfs graph traversal search space [default: " << DFS_LIMIT << "]\n"
-		"   --max-indel-len, -T       <int>         : limit on size of detectable indel [default: " << MAX_INDEL_LEN << "]\n"
-		"   --max-mismatch, -M        <int>         : max number of mismatches for near-perfect repeats [default: " << MAX_MISMATCH << "]\n"
-		"   --num-threads, -X         <int>         : number of parallel threads [default: " << NUM_THREADS << "]\n"
+		"   --min-k, k                <int>         : min kmersize [default: " << cfg.minK << "]\n"
+		"   --max-k, -K               <int>         : max kmersize [default: " << cfg.maxK << "]\n"
+		"   --trim-lowqual, -q        <int>         : trim bases below qv at 5' and 3' [default: " << cfg.MIN_QV_TRIM << "]\n"
+		"   --min-base-qual, -C       <int>         : minimum base quality required to consider a base for SNV calling [default: " << cfg.MIN_QV_CALL << "]\n"
+		"   --quality-range, -Q       <char>        : quality value range [default: " << (char) cfg.QV_RANGE << "]\n"
+		"   --min-map-qual, -b        <int>         : minimum read mapping quality in Phred-scale [default: " << cfg.MIN_MAP_QUAL << "]\n"
+		"   --max-as-xs-diff, -Z      <int>         : maximum difference between AS and XS alignments scores [default: " << cfg.MAX_DELTA_AS_XS << "]\n"
+		"   --tip-len, -l             <int>         : max tip length [default: " << cfg.MAX_TIP_LEN << "]\n"
+		"   --cov-thr, -c             <int>         : min coverage threshold used to select reference anchors from the De Bruijn graph [default: " << cfg.COV_THRESHOLD << "]\n"
+		"   --cov-ratio, -x           <float>       : minimum coverage ratio used to remove nodes from the De Bruijn graph [default: " << cfg.MIN_COV_RATIO << "]\n"
+		"   --low-cov, -d             <int>         : low coverage threshold used to remove nodes from the De Bruijn graph [default: " << cfg.LOW_COV_THRESHOLD << "]\n"
+		"   --max-avg-cov, -u         <int>         : maximum average coverage allowed per region, the reads of deeper regions are downsampled [default: " << cfg.MAX_AVG_COV << "]\n"
+		"   --window-size, -w         <int>         : window size of the region to assemble (in base-pairs) [default: " << cfg.WINDOW_SIZE << "]\n"
+		"   --padding, -P             <int>         : left/right padding (in base-pairs) applied to the input genomic regions [default: " << cfg.PADDING << "]\n"
+		"   --dfs-limit, -F           <int>         : limit dfs/bfs graph traversal search space [default: " << cfg.DFS_LIMIT << "]\n"
+		"   --max-indel-len, -T       <int>         : limit on size of detectable indel [default: " << cfg.MAX_INDEL_LEN << "]\n"
+		"   --max-mismatch, -M        <int>         : max number of mismatches for near-perfect repeats [default: " << cfg.MAX_MISMATCH << "]\n"
+		"   --num-threads, -X         <int>         : number of parallel threads [default: " << cfg.NUM_THREADS << "]\n"
 //		"   --rg-file, -g             <string>      : read group file\n"
-		"   --node-str-len, -L        <int>         : length of sequence to display at graph node (default: " << NODE_STRLEN << ")\n"
+		"   --node-str-len, -L        <int>         : length of sequence to display at graph node (default: " << cfg.NODE_STRLEN << ")\n"
+		"   --active-scan-cache       <string>      : file used to save/reuse the results of the active-region pre-scan\n"
+		"   --shard                   <i/N>         : process only the i-th of N shards of the windows (merge the outputs with: lancet merge)\n"
+		"   --journal                 <string>      : journal file of the completed windows and their variants (checkpoint)\n"
+		"   --window-budget           <float>       : time budget per window in seconds, slower windows are retried at the end with a " << DEFERRED_BUDGET_FACTOR << "x budget [default: " << cfg.WINDOW_BUDGET << " (no limit)]\n"
+		"   --bed-merge-gap           <int>         : merge the padded BED intervals closer than this distance (in base-pairs), -1 to turn off merging (one sweep per distinct interval, the identical ones are swept once) [default: " << cfg.BED_MERGE_GAP << "]\n"
+		"   --reader-threads          <int>         : number of reader threads in pipeline mode (implies --pipeline) [default: " << cfg.READER_THREADS << "]\n"
+		"   --hts-threads             <int>         : number of BGZF/CRAM decoding threads shared by the htslib readers (implies --htslib) [default: " << cfg.HTS_THREADS << "]\n"
+		"   --bgzf-cache              <int>         : size (in MB) of the cache of decompressed BAM blocks shared by the threads, 0 to turn off [default: " << cfg.BGZF_CACHE << "]\n"
+		"   --min-window-bytes        <float>       : prune the windows with less estimated compressed bytes of alignments in the BAM indexes (implies --index-prune) [default: " << cfg.MIN_WINDOW_BYTES << "]\n"
+		"   --serve                   <string>      : keep the BAMs and indexes open and answer region requests with VCF records on this Unix domain socket\n"
 
 		"\nFilters\n"
-		"   --min-alt-count-tumor, -a  <int>        : minimum alternative count in the tumor [default: " << filters.minAltCntTumor << "]\n"
-		"   --max-alt-count-normal, -m <int>        : maximum alternative count in the normal [default: " << filters.maxAltCntNormal << "]\n"
-		"   --min-vaf-tumor, -e        <float>      : minimum variant allele frequency (AlleleCov/TotCov) in the tumor [default: " << filters.minVafTumor << "]\n"
-		"   --max-vaf-normal, -i       <float>      : maximum variant allele frequency (AlleleCov/TotCov) in the normal [default: " << filters.maxVafNormal << "]\n"
-		"   --min-coverage-tumor, -o   <int>        : minimum coverage in the tumor [default: " << filters.minCovTumor << "]\n"
-		"   --max-coverage-tumor, -y   <int>        : maximum coverage in the tumor [default: " << filters.maxCovTumor << "]\n"
-		"   --min-coverage-normal, -z  <int>        : minimum coverage in the normal [default: " << filters.minCovNormal << "]\n"
-		"   --max-coverage-normal, -j  <int>        : maximum coverage in the normal [default: " << filters.maxCovNormal << "]\n"
-		"   --min-phred-fisher, -s     <float>      : minimum fisher exact test score [default: " << filters.minPhredFisher << "]\n"
-		"   --min-phred-fisher-str, -E <float>      : minimum fisher exact test score for STR mutations [default: " << filters.minPhredFisherSTR << "]\n"
-		"   --min-strand-bias, -f      <float>      : minimum strand bias threshold [default: " << filters.minStrandBias << "]\n"
+		"   --min-alt-count-tumor, -a  <int>        : minimum alternative count in the tumor [default: " << cfg.filters.minAltCntTumor << "]\n"
+		"   --max-alt-count-normal, -m <int>        : maximum alternative count in the normal [default: " << cfg.filters.maxAltCntNormal << "]\n"
+		"   --min-vaf-tumor, -e        <float>      : minimum variant allele frequency (AlleleCov/TotCov) in the tumor [default: " << cfg.filters.minVafTumor << "]\n"
+		"   --max-vaf-normal, -i       <float>      : maximum variant allele frequency (AlleleCov/TotCov) in the normal [default: " << cfg.filters.maxVafNormal << "]\n"
+		"   --min-coverage-tumor, -o   <int>        : minimum coverage in the tumor [default: " << cfg.filters.minCovTumor << "]\n"
+		"   --max-coverage-tumor, -y   <int>        : maximum coverage in the tumor [default: " << cfg.filters.maxCovTumor << "]\n"
+		"   --min-coverage-normal, -z  <int>        : minimum coverage in the normal [default: " << cfg.filters.minCovNormal << "]\n"
+		"   --max-coverage-normal, -j  <int>        : maximum coverage in the normal [default: " << cfg.filters.maxCovNormal << "]\n"
+		"   --min-phred-fisher, -s     <float>      : minimum fisher exact test score [default: " << cfg.filters.minPhredFisher << "]\n"
+		"   --min-phred-fisher-str, -E <float>      : minimum fisher exact test score for STR mutations [default: " << cfg.filters.minPhredFisherSTR << "]\n"
+		"   --min-strand-bias, -f      <float>      : minimum strand bias threshold [default: " << cfg.filters.minStrandBias << "]\n"
 			
 		"\nShort Tandem Repeat parameters\n"
-		"   --max-unit-length, -U      <int>        : maximum unit length of the motif [default: " << MAX_UNIT_LEN << "]\n"
-		"   --min-report-unit, -N      <int>        : minimum number of units to report [default: " << MIN_REPORT_UNITS << "]\n"
-		"   --min-report-len, -Y       <int>        : minimum length of tandem in base pairs [default: " << MIN_REPORT_LEN << "]\n"
-		"   --dist-from-str, -D        <int>        : distance (in bp) of variant from STR locus [default: " << DIST_FROM_STR << "]\n"
+		"   --max-unit-length, -U      <int>        : maximum unit length of the motif [default: " << cfg.MAX_UNIT_LEN << "]\n"
+		"   --min-report-unit, -N      <int>        : minimum number of units to report [default: " << cfg.MIN_REPORT_UNITS << "]\n"
+		"   --min-report-len, -Y       <int>        : minimum length of tandem in base pairs [default: " << cfg.MIN_REPORT_LEN << "]\n"
+		"   --dist-from-str, -D        <int>        : distance (in bp) of variant from STR locus [default: " << cfg.DIST_FROM_STR << "]\n"
 		
 		"\nFlags\n"
 		"   --linked-reads, -J            : linked-reads analysis mode\n"	
 		"   --primary-alignment-only, -I  : only use primary alignments for variant calling\n"
 		"   --XA-tag-filter, -O           : skip reads with multiple hits listed in the XA tag (BWA only)\n"
-		"   --active-region-off, -W       : turn off active region module\n"		
+		"   --active-region-off, -W       : turn off active region module\n"
+		"   --active-scan                 : pre-scan the BAMs once to skip the windows without evidence of variation\n"
+		"   --adaptive-windows            : merge the active windows into larger regions centred on the evidence (implies --active-scan)\n"
+		"   --resume                      : resume an interrupted run skipping the windows completed in the journal\n"
+		"   --cost-schedule               : estimate the cost of the windows from the BAM indexes and the reference and assemble the most expensive first\n"		
+		"   --pipeline                    : fetch the reads in reader threads, assemble in --num-threads threads and collect the variants in one thread\n"
+		"   --htslib                      : read the BAM files with htslib instead of bamtools (CRAM files are always read with htslib)\n"
+		"   --numa                        : pin the threads to the cpus of the NUMA nodes and split the windows across the nodes\n"
+		"   --index-prune                 : prune the windows without alignments in the BAM indexes before reading the BAMs\n"
+		"   --downsample-off              : skip the regions above --max-avg-cov instead of downsampling their reads\n"
+		"   --shared-index-off            : read the bins of the BAM indexes from disk at each region instead of sharing them in memory across the threads\n"
 		"   --kmer-recovery, -R           : turn on k-mer recovery (experimental)\n"
 		"   --print-graph, -A             : print graph (in .dot format) after every stage\n"
 		"   --verbose, -v                 : be verbose\n"
@@ -114,488 +137,121 @@ void printHelpText(Filters & filters) {
 }
 
 // print configuration to file
-void printConfiguration(ostream & out, Filters & filters)
+void printConfiguration(ostream & out, LancetConfig_t & cfg, const string & region, const string & bedfile)
 {
-	out << "tumor-BAM: "        << TUMOR << endl;
-	out << "normal-BAM: "       << NORMAL << endl;
-	out << "reference: "        << REFFILE << endl;
-	out << "region: "           << REGION  << endl;
-	out << "BED-file: "         << BEDFILE  << endl;
+	out << "tumor-BAM: "        << cfg.TUMOR << endl;
+	for (unsigned int t = 0; t < cfg.EXTRA_TUMORS.size(); ++t) { out << "tumor-BAM: " << cfg.EXTRA_TUMORS[t] << endl; }
+	out << "normal-BAM: "       << cfg.NORMAL << endl;
+	out << "reference: "        << cfg.REFFILE << endl;
+	out << "region: "           << region  << endl;
+	out << "BED-file: "         << bedfile  << endl;
 
-	out << "min-K: "            << minK << endl;
-	out << "max-K: "            << maxK << endl;
-	out << "tip-len: "          << MAX_TIP_LEN << endl;
+	out << "min-K: "            << cfg.minK << endl;
+	out << "max-K: "            << cfg.maxK << endl;
+	out << "tip-len: "          << cfg.MAX_TIP_LEN << endl;
 
 	//out << "MIN_THREAD_READS: " << MIN_THREAD_READS << endl;
-	out << "cov-thr: "          << COV_THRESHOLD << endl;
+	out << "cov-thr: "          << cfg.COV_THRESHOLD << endl;
 	cerr.unsetf(ios::floatfield); // floatfield not set
 	cerr.precision(5);
-	out << "cov-ratio: "        << MIN_COV_RATIO << endl;
+	out << "cov-ratio: "        << cfg.MIN_COV_RATIO << endl;
 	cerr.setf(ios::fixed,ios::floatfield);
 	cerr.precision(1);
-	out << "low-cov: "          << LOW_COV_THRESHOLD << endl;
-	out << "window-size: "      << WINDOW_SIZE << endl;
-	out << "padding: "          << PADDING << endl;
-	out << "max-avg-cov: "      << MAX_AVG_COV << endl;
-	out << "min-map-qual: "     << MIN_MAP_QUAL << endl;
-	out << "max-as-xs-diff: "   << MAX_DELTA_AS_XS << endl;
-	out << "min-base-qual: "    << MIN_QV_CALL << endl;
-	out << "trim-lowqual: "     << MIN_QV_TRIM << endl;
-	out << "quality-range: "    << QV_RANGE << endl;	
-	out << "node-str-len: "     << NODE_STRLEN << endl;
-	out << "dfs-limit: "        << DFS_LIMIT << endl;
-	out << "max-indel-len: "    << MAX_INDEL_LEN << endl;
-	out << "max-mismatch: "     << MAX_MISMATCH << endl;
-	out << "num-threads: "      << NUM_THREADS << endl;	
+	out << "low-cov: "          << cfg.LOW_COV_THRESHOLD << endl;
+	out << "window-size: "      << cfg.WINDOW_SIZE << endl;
+	out << "padding: "          << cfg.PADDING << endl;
+	out << "bed-merge-gap: "    << cfg.BED_MERGE_GAP << endl;
+	out << "max-avg-cov: "      << cfg.MAX_AVG_COV << endl;
+	out << "downsample: "       << bvalue(cfg.DOWNSAMPLE) << endl;
+	out << "min-map-qual: "     << cfg.MIN_MAP_QUAL << endl;
+	out << "max-as-xs-diff: "   << cfg.MAX_DELTA_AS_XS << endl;
+	out << "min-base-qual: "    << cfg.MIN_QV_CALL << endl;
+	out << "trim-lowqual: "     << cfg.MIN_QV_TRIM << endl;
+	out << "quality-range: "    << cfg.QV_RANGE << endl;	
+	out << "node-str-len: "     << cfg.NODE_STRLEN << endl;
+	out << "dfs-limit: "        << cfg.DFS_LIMIT << endl;
+	out << "max-indel-len: "    << cfg.MAX_INDEL_LEN << endl;
+	out << "max-mismatch: "     << cfg.MAX_MISMATCH << endl;
+	out << "num-threads: "      << cfg.NUM_THREADS << endl;	
 	//out << "SCAFFOLD_CONTIGS: " << bvalue(SCAFFOLD_CONTIGS) << endl;
 	//out << "INSERT_SIZE: "      << INSERT_SIZE << " +/- " << INSERT_STDEV << endl;
 	
 	// str parameters
-	out << "max-unit-length: "   << MAX_UNIT_LEN << endl;
-	out << "min-report-unit: "   << MIN_REPORT_UNITS << endl;
-	out << "min-report-len: "    << MIN_REPORT_LEN << endl;
-	out << "dist-from-str: "     << DIST_FROM_STR << endl;	
+	out << "max-unit-length: "   << cfg.MAX_UNIT_LEN << endl;
+	out << "min-report-unit: "   << cfg.MIN_REPORT_UNITS << endl;
+	out << "min-report-len: "    << cfg.MIN_REPORT_LEN << endl;
+	out << "dist-from-str: "     << cfg.DIST_FROM_STR << endl;	
 	
 	//filters
-	out << "min-phred-fisher: "     << filters.minPhredFisher << endl;
-	out << "min-phred-fisher-str: " << filters.minPhredFisherSTR << endl;
-	out << "min-strand-bias: "      << filters.minStrandBias << endl;
-	out << "min-alt-count-tumor: "  << filters.minAltCntTumor << endl;
-	out << "max-alt-count-normal: " << filters.maxAltCntNormal << endl;
-	out << "min-vaf-tumor: "        << filters.minVafTumor << endl;
-	out << "max-vaf-normal: "       << filters.maxVafNormal << endl;
-	out << "min-coverage-tumor: "   << filters.minCovTumor << endl;
-	out << "max-coverage-tumor: "   << filters.maxCovTumor << endl;
-	out << "min-coverage-normal: "  << filters.minCovNormal << endl;
-	out << "max-coverage-normal: "  << filters.maxCovNormal << endl;
+	out << "min-phred-fisher: "     << cfg.filters.minPhredFisher << endl;
+	out << "min-phred-fisher-str: " << cfg.filters.minPhredFisherSTR << endl;
+	out << "min-strand-bias: "      << cfg.filters.minStrandBias << endl;
+	out << "min-alt-count-tumor: "  << cfg.filters.minAltCntTumor << endl;
+	out << "max-alt-count-normal: " << cfg.filters.maxAltCntNormal << endl;
+	out << "min-vaf-tumor: "        << cfg.filters.minVafTumor << endl;
+	out << "max-vaf-normal: "       << cfg.filters.maxVafNormal << endl;
+	out << "min-coverage-tumor: "   << cfg.filters.minCovTumor << endl;
+	out << "max-coverage-tumor: "   << cfg.filters.maxCovTumor << endl;
+	out << "min-coverage-normal: "  << cfg.filters.minCovNormal << endl;
+	out << "max-coverage-normal: "  << cfg.filters.maxCovNormal << endl;
 
 	// flags
-	out << "linked-reads: "     << bvalue(LR_MODE) << endl;	
-	out << "primary-alignment-only: " << bvalue(PRIMARY_ALIGNMENT_ONLY) << endl;	
-	out << "XA-tag-filter: "    << bvalue(XA_FILTER) << endl;	
-	out << "active-regions: "   << bvalue(ACTIVE_REGIONS) << endl;
-	out << "kmer-recovery: "    << bvalue(KMER_RECOVERY) << endl;
-	out << "print-graphs: "     << bvalue(PRINT_ALL) << endl;
-	out << "verbose: "          << bvalue(verbose) << endl;
-	out << "more-verbose: "     << bvalue(VERBOSE) << endl;
+	out << "linked-reads: "     << bvalue(cfg.LR_MODE) << endl;	
+	out << "primary-alignment-only: " << bvalue(cfg.PRIMARY_ALIGNMENT_ONLY) << endl;	
+	out << "XA-tag-filter: "    << bvalue(cfg.XA_FILTER) << endl;	
+	out << "active-regions: "   << bvalue(cfg.ACTIVE_REGIONS) << endl;
+	out << "active-scan: "      << bvalue(cfg.ACTIVE_SCAN) << endl;
+	out << "active-scan-cache: " << cfg.ACTIVE_SCAN_CACHE << endl;
+	out << "adaptive-windows: " << bvalue(cfg.ADAPTIVE_WINDOWS) << endl;
+	if(cfg.NUM_SHARDS > 0) { out << "shard: " << cfg.SHARD << "/" << cfg.NUM_SHARDS << endl; }
+	out << "journal: " << cfg.JOURNAL_FILE << endl;
+	out << "resume: " << bvalue(cfg.RESUME) << endl;
+	out << "window-budget: " << cfg.WINDOW_BUDGET << endl;
+	out << "cost-schedule: " << bvalue(cfg.COST_SCHEDULE) << endl;
+	out << "index-prune: " << bvalue(cfg.INDEX_PRUNE) << endl;
+	out << "numa: " << bvalue(cfg.NUMA_MODE) << endl;
+	out << "pipeline: " << bvalue(cfg.PIPELINE_MODE) << endl;
+	out << "reader-threads: " << cfg.READER_THREADS << endl;
+	out << "htslib: " << bvalue(cfg.HTSLIB) << endl;
+	out << "hts-threads: " << cfg.HTS_THREADS << endl;
+	out << "bgzf-cache: " << cfg.BGZF_CACHE << endl;
+	out << "shared-index: " << bvalue(cfg.SHARED_INDEX) << endl;
+	out << "min-window-bytes: " << cfg.MIN_WINDOW_BYTES << endl;
+	out << "kmer-recovery: "    << bvalue(cfg.KMER_RECOVERY) << endl;
+	out << "print-graphs: "     << bvalue(cfg.PRINT_ALL) << endl;
+	out << "verbose: "          << bvalue(cfg.verbose) << endl;
+	out << "more-verbose: "     << bvalue(cfg.VERBOSE) << endl;
 	
 	out << endl;
 }
 
-// loadRef
-//////////////////////////////////////////////////////////////
-int loadRefs(const string reference, const string region, vector< map<string, Ref_t *> > &reftable, RefVector &bamrefs, int num_threads, int thread)	
-{
-	//if(verbose) { cerr << "LoadRef " << reference << endl; }
-
-	string ss;
-	string hdr = region;
-	string CHR;
-	string START;
-	string END;
-	
-	// extrat coordinates for header
-	size_t x     = hdr.find_first_of(':');
-	
-	if ( (x == string::npos) && (hdr.length()>0) ) { // no ":" symbol found -> assume single chromosome name format	
-		CHR   = hdr.substr(0,x);
-		START = "1";
-		std::vector<RefData>::iterator it;
-	    for (it = bamrefs.begin() ; it != bamrefs.end(); ++it) {
-			//cerr << it->RefName << endl;
-			if (it->RefName == CHR) { 
-			    std::ostringstream oss;
-			    oss << it->RefLength;
-				END = oss.str(); 
-				break; 
-			}
-	    }
-		
-		// report error if the chromosome label is not found in BAM header.
-		if (it == bamrefs.end()) {
-			cerr << "ERROR: chromosome label " << CHR << " not found in BAM header!" << endl;  
-		}
-		
-	}
-	else {
-		size_t y = hdr.find_first_of('-', x);
-		CHR  	 = hdr.substr(0,x);
-		START	 = hdr.substr(x+1, y-x-1);
-		END   	 = hdr.substr(y+1, string::npos);
-				
-		int SP = stoi(START) - PADDING;
-		int EP = stoi(END) + PADDING;
-		
-		if(SP<1) {SP=1;} // start position cannnot be less than 1
-		// check chromosome size
-		std::vector<RefData>::iterator it;
-	    for (it = bamrefs.begin() ; it != bamrefs.end(); ++it) {
-			if (it->RefName == CHR) {
-				if(EP > it->RefLength) { EP = it->RefLength; } 
-				break; 
-			}
-		}		
-		// save updated coordinates
-		START = itos(SP);
-		END = itos(EP);
-	}
-	//cerr << CHR << ":" << START << "-" << END << endl; 
-	string REG = CHR+":"+START+"-"+END;
-	
-	// open fasta index
-    faidx_t *fai = fai_load(reference.c_str());
-    if ( !fai ) { cerr << "Could not load fai index of " << reference << endl; }
-
-	// extrat sequence
-    int seq_len;
-    char *seq = fai_fetch(fai, REG.c_str(), &seq_len);
-    if ( seq_len < 0 ) { cerr << "Failed to fetch sequence in " << REG << endl; }
-		
-	// convert char* to string
-	string s(seq, seq + seq_len);
-	
-	// convert to upper case and change IUPAC ambiguos codes in reference to Ns
-	for (unsigned int i = 0; i < s.length(); ++i) {
-		s[i] = toupper(s[i]);
-		if(isAmbiguos(s[i])) { s[i]='N'; }
-	}
-
-	// split into overalpping windows if sequence is too long
-	int end = s.length();
-	int offset = 0;
-	int delta = 100;
-	
-	int T = thread; // thread counter
-	for (; offset < end; offset+=delta) {
-		
-		// adjust end if 
-		int LEN = WINDOW_SIZE;
-		if( (offset + WINDOW_SIZE) >= (int)s.length() ) { 
-			LEN = s.length() - offset - 1;
-			//offset = s.length() - WINDOW_SIZE - 1;
-			end = offset;
-		}
-		
-		ss = s.substr(offset,LEN);
-		
-		// make new reference entry 
-		Ref_t * ref = new Ref_t(minK);
-	
-		ref->refchr   = CHR;
-		ref->refstart = atoi(START.c_str()) + offset;
-		ref->refend   = ref->refstart + LEN;
-		//ref->refend   = atoi(end.c_str());
-		
-		hdr = ref->refchr;
-		hdr += ":";
-		hdr += itos(ref->refstart);
-		hdr += "-";
-		hdr += itos(ref->refend);
-
-		if(verbose) { cerr << "hdr:\t" << hdr << endl; }
-		
-		ref->setHdr(hdr);
-		ref->setSeq(ss);
-		ref->setRawSeq(ss);
-		
-		ref->hdr = hdr;
-		
-		reftable[T].insert(make_pair(hdr, ref));
-		++num_windows;
-		
-		// move to next reftable
-		++T;
-		if( (num_windows%num_threads) == 0) { T=0; }
-	}
-	
-	fai_destroy(fai);
-	
-	return T;
-}
-
-// loadbed : load regions from BED file
-//////////////////////////////////////////////////////////////
-void loadBed(const string bedfile, vector< map<string, Ref_t *> > &reftable, RefVector &bamrefs, int num_threads) { 
-	
-	int num_regions = 0;
-	string line;
-	string region;
-	vector<std::string> tokens;
-	ifstream bfile (bedfile);
-	int t = 0;
-	if (bfile.is_open()) {
-		while ( getline (bfile,line) ) {
-			
-			size_t x = line.find_first_of('#');
-			if(x == 0) { continue; } // skip comments
-			
-			++num_regions;
-			//cerr << line << '\n';
-			
-			// extrat coordinates			
-		    istringstream iss(line);
-		    string token;
-			tokens.clear();
-		    while(std::getline(iss, token, '\t')) {  // but we can specify a different one
-				tokens.push_back(token);
-			}
-			
-			int SP = stoi(tokens[1]) - PADDING;
-			int EP = stoi(tokens[2]) + PADDING;
-			
-			if(SP<1) {SP=1;} // start position cannnot be less than 1
-				
-			//region = tokens[0] + ":" + tokens[1] + "-" + tokens[2];	
-			region = tokens[0] + ":" + itos(SP) + "-" + itos(EP);	
-			t = loadRefs(REFFILE,region,reftable,bamrefs,num_threads, t);
-		}
-		bfile.close();
-		
-		cerr << "Loaded " << num_regions << " from bedfile" << endl;
-	}
-	else {
-		cerr << "Couldn't open " << bedfile << endl;
-		exit(1);
-	}
-}
-
-static void* execute(void* ptr) {
-
-    Microassembler* ma = (Microassembler*)ptr;
-	
-	ma->processReads();
-	//ma->vDB.printToVCF();
-	
-	pthread_exit(NULL);
-}
-
-//lancet_function(tumor, normal, ref, reg, numthreads)
-
-
-// main
+// rLancet : call the variants of a region (or BED file) with the default
+// parameters and export them to VCF (stdout)
 //////////////////////////////////////////////////////////////////////////
 int rLancet(string tumor_bam, string normal_bam, string ref_fasta, string reg, string bed_file, int numthreads)
 {
-
-	TUMOR = tumor_bam;
-	NORMAL = normal_bam;
-	REFFILE = ref_fasta;
-	REGION = reg;
-	BEDFILE = bed_file;
-	NUM_THREADS = numthreads;
-	
-	// initilize filter thresholds
-	Filters filters;
-	filters.minPhredFisherSTR = 25;
-	filters.minPhredFisher = 5;
-	filters.minCovNormal = 10;
-	filters.maxCovNormal = 1000000;
-	filters.minCovTumor = 4;
-	filters.maxCovTumor = 1000000;
-	filters.minVafTumor = 0.04;
-	filters.maxVafNormal = 0;
-	filters.minAltCntTumor = 3;
-	filters.maxAltCntNormal = 0;
-	filters.minStrandBias = 1;
-
-	// update min base quality values
-	MIN_QUAL_TRIM = MIN_QV_TRIM + QV_RANGE;
-	MIN_QUAL_CALL = MIN_QV_CALL + QV_RANGE;
-
-	bool errflg = false;
-
-	if (TUMOR == "") { cerr << "ERROR: Must provide the tumor BAM file (-t)" << endl; ++errflg; }
-	if (NORMAL == "") { cerr << "ERROR: Must provide the normal BAM file (-n)" << endl; ++errflg; }		
-	if (REFFILE == "") { cerr << "ERROR: Must provide a reference genome file (-r)" << endl; ++errflg; }
-	if ( (BEDFILE == "") && (REGION == "") ) { cerr << "ERROR: Must provide region (-p) or BED file (-B)" << endl; ++errflg; }
-
-	if (errflg) { exit(EXIT_FAILURE); }
-	
-    ofstream params_file;
-    params_file.open ("config.txt");
-	printConfiguration(params_file, filters); // save parameters setting to file
-    params_file.close();
-
-	if(verbose) { printConfiguration(cerr, filters); }
-	
-	BamReader readerT;
-	// attempt to open the BamReader
-	if ( !readerT.Open(TUMOR) ) {
-		cerr << "Could not open tumor BAM file." << endl;
-		return -1;
-	}
-	
-	BamReader readerN;
-	// attempt to open the BamReader
-	if ( !readerN.Open(NORMAL) ) {
-		cerr << "Could not open normal BAM file." << endl;
-		return -1;
-	}
-	
-	bool found = (checkPresenceOfMDtag(readerT) || checkPresenceOfMDtag(readerN));		
-	if(!found && ACTIVE_REGIONS) {
-		cerr << endl << "--------WARNING--------" << endl;
-		cerr << "MD tag required to select active regions, but is missing from alignments." << endl;
-		cerr << "RECOMMENDED ACTION: turn off the active region module (--active-region-off)" << endl;
-		cerr << "-----------------------" << endl << endl;
-	}
-	
-	RefVector references = readerT.GetReferenceData(); // Extract all reference sequence entries.
-	
-	// run the assembler on each region
-	try {
-		
-		//Microassembler* driver = new Microassembler();
-		//driver->run(argc, argv);
-		//assembler->vDB.printToVCF();
-
-		pthread_t threads[NUM_THREADS];
-		pthread_attr_t attr;
-		void * status;
-		int rc;
-		int i;		
-		vector<Microassembler*> assemblers(NUM_THREADS, new Microassembler(LR_MODE));
-		vector< map<string, Ref_t *> > reftables(NUM_THREADS, map<string, Ref_t *>()); // table of references to analyze
-		
-		if (BEDFILE != "") {
-			loadBed(BEDFILE,reftables,references,NUM_THREADS);
-		}
-		if (REGION != "") {
-			loadRefs(REFFILE,REGION,reftables,references,NUM_THREADS, 0);
-		}
-		
-		cerr << num_windows << " total windows to process" << endl << endl;
-		
-		// Initialize and set thread joinable
-		pthread_attr_init(&attr);
-		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-		for( i=0; i < NUM_THREADS; ++i ) {
-			cerr << "starting thread " << (i+1) << " on " << reftables[i].size() << " windows" << endl;
-		
-			assemblers[i] = new Microassembler(LR_MODE);
-
-			//assemblers[i]->LR_MODE = LR_MODE;
-			assemblers[i]->XA_FILTER = XA_FILTER;
-			assemblers[i]->PRIMARY_ALIGNMENT_ONLY = PRIMARY_ALIGNMENT_ONLY;
-			assemblers[i]->ACTIVE_REGION_MODULE = ACTIVE_REGIONS;
-			assemblers[i]->KMER_RECOVERY = KMER_RECOVERY;
-			assemblers[i]->verbose = verbose;
-			assemblers[i]->VERBOSE = VERBOSE;
-			assemblers[i]->PRINT_DOT_READS = PRINT_DOT_READS;
-			assemblers[i]->PRINT_ALL = PRINT_ALL;
-			assemblers[i]->MIN_QV_CALL = MIN_QV_CALL;
-			assemblers[i]->MIN_QV_TRIM = MIN_QV_TRIM;
-			assemblers[i]->QV_RANGE = QV_RANGE;
-			assemblers[i]->MIN_QUAL_TRIM = MIN_QUAL_TRIM;
-			assemblers[i]->MIN_QUAL_CALL = MIN_QUAL_CALL;
-			assemblers[i]->MIN_MAP_QUAL = MIN_MAP_QUAL;
-			assemblers[i]->MAX_DELTA_AS_XS = MAX_DELTA_AS_XS;
-			assemblers[i]->TUMOR = TUMOR;
-			assemblers[i]->NORMAL = NORMAL;
-			assemblers[i]->RG_FILE = RG_FILE;
-			assemblers[i]->REFFILE = REFFILE;
-			assemblers[i]->minK = minK;
-			assemblers[i]->maxK = maxK;
-			assemblers[i]->MAX_TIP_LEN = MAX_TIP_LEN;
-			assemblers[i]->MIN_THREAD_READS = MIN_THREAD_READS;
-			assemblers[i]->COV_THRESHOLD = COV_THRESHOLD;
-			assemblers[i]->MIN_COV_RATIO = MIN_COV_RATIO;
-			assemblers[i]->LOW_COV_THRESHOLD = LOW_COV_THRESHOLD;
-			assemblers[i]->MAX_AVG_COV = MAX_AVG_COV;
-			assemblers[i]->NODE_STRLEN = NODE_STRLEN;
-			assemblers[i]->DFS_LIMIT = DFS_LIMIT;
-			assemblers[i]->MAX_INDEL_LEN = MAX_INDEL_LEN;
-			assemblers[i]->MAX_MISMATCH = MAX_MISMATCH;	
-			assemblers[i]->MAX_UNIT_LEN = MAX_UNIT_LEN;
-			assemblers[i]->MIN_REPORT_UNITS = MIN_REPORT_UNITS;
-			assemblers[i]->MIN_REPORT_LEN = MIN_REPORT_LEN;
-			assemblers[i]->DIST_FROM_STR = DIST_FROM_STR;
-			
-			assemblers[i]->reftable = &reftables[i];
-			assemblers[i]->setFilters(&filters);
-			assemblers[i]->setID(i+1);
-	
-			rc = pthread_create(&threads[i], NULL, execute, (void * )assemblers[i]);
-			
-			if (rc){
-				cerr << "Error:unable to create thread," << rc << endl;
-				exit(-1);
-			}
-		}
-		
-		// free attribute and wait for the other threads
-		pthread_attr_destroy(&attr);
-		for( i=0; i < NUM_THREADS; ++i ){
-			rc = pthread_join(threads[i], &status);
-			if (rc){
-				cerr << "Error:unable to join," << rc << endl;
-				exit(-1);
-			}
-			cerr << "Main: completed thread id :" << (i+1) ;
-			cerr << " exiting with status :" << status << endl;
-		}
-		
-		int tot_skip = 0;
-		int tot_svn_only = 0;
-		int tot_indel_only = 0;
-		int tot_softclip_only = 0;
-		int tot_indel_or_softclip = 0;
-		int tot_snv_or_indel = 0;
-		int tot_snv_or_softclip = 0;
-		int tot_snv_or_indel_or_softclip = 0;
-		//merge variant from all threads
-		cerr << "Merge variants" << endl;
-		VariantDB_t variantDB(LR_MODE); // variants DB
-		variantDB.setFilters(&filters);
-		for( i=0; i < NUM_THREADS; ++i ) {
-			
-			tot_skip += assemblers[i]->num_skip;
-			tot_svn_only += assemblers[i]->num_snv_only_regions;
-			tot_indel_only += assemblers[i]->num_indel_only_regions;
-			tot_softclip_only += assemblers[i]->num_softclip_only_regions;
-			tot_indel_or_softclip += assemblers[i]->num_indel_or_softclip_regions;			
-			tot_snv_or_indel += assemblers[i]->num_snv_or_indel_regions;			
-			tot_snv_or_softclip += assemblers[i]->num_snv_or_softclip_regions;
-			tot_snv_or_indel_or_softclip += assemblers[i]->num_snv_or_indel_or_softclip_regions;
-						
-			map<string,Variant_t> db = (assemblers[i]->vDB).DB;
-			map<string,Variant_t>::iterator it;			
-			for (it=db.begin(); it!=db.end(); ++it) {
-				variantDB.addVar(it->second);
-			}
-		}
-		
-		//if(verbose) {
-			cerr << "Total # of skipped windows: " << tot_skip << " (" << (100*(double)tot_skip/double(num_windows)) << "\%)" << endl;
-			cerr << "- # of windows with SNVs only: " << tot_svn_only << endl;
-			cerr << "- # of windows with indels only: " << tot_indel_only << endl;
-			cerr << "- # of windows with softclips only: " << tot_softclip_only << endl;
-			cerr << "- # of windows with indels or softclips: " << tot_indel_or_softclip << endl;
-			cerr << "- # of windows with SNVs or indels: " << tot_snv_or_indel << endl;
-			cerr << "- # of windows with SNVs or softclips: " << tot_snv_or_softclip << endl;
-			cerr << "- # of windows with SNVs or indels or softclips: " << tot_snv_or_indel_or_softclip << endl;
-		//}
-		
-		/***** get current time and date *****/
-		time_t rawtime;
-		time (&rawtime);
-		char* DATE = ctime (&rawtime);
-		/***************************************/
-		
-		variantDB.printToVCF(VERSION, REFFILE, DATE, filters, assemblers[0]->sample_name_normal, assemblers[0]->sample_name_tumor);		
-	}
-	catch (int e) {
-		cerr << "An exception occurred. Exception Nr. " << e << endl;
-	}
-
-	pthread_exit(NULL);
+	LancetConfig_t cfg;
+	cfg.TUMOR = tumor_bam;
+	cfg.NORMAL = normal_bam;
+	cfg.REFFILE = ref_fasta;
+	cfg.NUM_THREADS = numthreads;
+	
+	LancetEngine_t engine(cfg);
+	LancetResult_t result;
+	if (engine.run(reg, bed_file, result) < 0) { return -1; }
+	engine.printVCF(result, VERSION, cout);
+	
+	return 0;
 }
 
 // main
 //////////////////////////////////////////////////////////////////////////
 int main(int argc, char** argv)
 {
+	LancetConfig_t cfg; // configuration parameters (with the default values)
+	string REGION;
+	string BEDFILE;
+	string SERVE_SOCKET; // Unix domain socket of the server mode
 
 	if (argc == 1)
 	{
@@ -615,25 +271,19 @@ int main(int argc, char** argv)
 		exit(0);
 	}
 
-	COMMAND_LINE = buildCommandLine(argc,argv);
+	cfg.COMMAND_LINE = buildCommandLine(argc,argv);
+	
+	// merge the VCF files of a sharded run
+	if (string(argv[1]) == "merge") {
+		ShardMerge_t merge;
+		merge.VERSION = VERSION;
+		merge.COMMAND_LINE = cfg.COMMAND_LINE;
+		return merge.run(vector<string>(argv+2, argv+argc));
+	}
 	
 	cerr.setf(ios::fixed,ios::floatfield);
 	cerr.precision(1);
 	
-	// initilize filter thresholds
-	Filters filters;
-	filters.minPhredFisherSTR = 25;
-	filters.minPhredFisher = 5;
-	filters.minCovNormal = 10;
-	filters.maxCovNormal = 1000000;
-	filters.minCovTumor = 4;
-	filters.maxCovTumor = 1000000;
-	filters.minVafTumor = 0.04;
-	filters.maxVafNormal = 0;
-	filters.minAltCntTumor = 3;
-	filters.maxAltCntNormal = 0;
-	filters.minStrandBias = 1;
-	
 	bool errflg = false;
 	int ch;
 
@@ -695,6 +345,26 @@ int main(int argc, char** argv)
 		{"primary-alignment-only", no_argument, 0, 'I'},
 		{"XA-tag-filter", no_argument, 0, 'O'},
 		{"active-region-off", no_argument, 0, 'W'},		
+		{"active-scan", no_argument, 0, OPT_ACTIVE_SCAN},
+		{"active-scan-cache", required_argument, 0, OPT_ACTIVE_SCAN_CACHE},
+		{"adaptive-windows", no_argument, 0, OPT_ADAPTIVE_WINDOWS},
+		{"shard", required_argument, 0, OPT_SHARD},
+		{"journal", required_argument, 0, OPT_JOURNAL},
+		{"resume", no_argument, 0, OPT_RESUME},
+		{"window-budget", required_argument, 0, OPT_WINDOW_BUDGET},
+		{"cost-schedule", no_argument, 0, OPT_COST_SCHEDULE},
+		{"index-prune", no_argument, 0, OPT_INDEX_PRUNE},
+		{"bed-merge-gap", required_argument, 0, OPT_BED_MERGE_GAP},
+		{"numa", no_argument, 0, OPT_NUMA},
+		{"pipeline", no_argument, 0, OPT_PIPELINE},
+		{"reader-threads", required_argument, 0, OPT_READER_THREADS},
+		{"htslib", no_argument, 0, OPT_HTSLIB},
+		{"hts-threads", required_argument, 0, OPT_HTS_THREADS},
+		{"bgzf-cache", required_argument, 0, OPT_BGZF_CACHE},
+		{"shared-index-off", no_argument, 0, OPT_SHARED_INDEX_OFF},
+		{"downsample-off", no_argument, 0, OPT_DOWNSAMPLE_OFF},
+		{"min-window-bytes", required_argument, 0, OPT_MIN_WINDOW_BYTES},
+		{"serve", required_argument, 0, OPT_SERVE},
 		{"kmer-recovery-on", no_argument, 0, 'R'},		
 		{"erroflag", no_argument, 0, 'h'},		
 		{"verbose", no_argument, 0, 'v'},
@@ -711,61 +381,92 @@ int main(int argc, char** argv)
 	{
 		switch (ch)
 		{
-			case 't': TUMOR            = optarg;       break; 
-			case 'n': NORMAL           = optarg;       break; 
-			case 'r': REFFILE          = optarg;       break;
+			case 't': 
+				if (cfg.TUMOR == "") { cfg.TUMOR = optarg; }
+				else { cfg.EXTRA_TUMORS.push_back(optarg); }
+				break; 
+			case 'n': 
+				if (cfg.NORMAL == "") { cfg.NORMAL = optarg; }
+				else { cfg.NORMAL += string(",") + optarg; }
+				break; 
+			case 'r': cfg.REFFILE          = optarg;       break;
 			case 'B': BEDFILE          = optarg;       break;
 			case 'p': REGION           = optarg;       break;
 			
-			case 'g': RG_FILE          = optarg;       break;
-			case 'k': minK             = atoi(optarg); break;
-			case 'K': maxK             = atoi(optarg); break;
-			case 'l': MAX_TIP_LEN      = atoi(optarg); break;
+			case 'g': cfg.RG_FILE          = optarg;       break;
+			case 'k': cfg.minK             = atoi(optarg); break;
+			case 'K': cfg.maxK             = atoi(optarg); break;
+			case 'l': cfg.MAX_TIP_LEN      = atoi(optarg); break;
 			//case 't': MIN_THREAD_READS = atoi(optarg); break;
-			case 'c': COV_THRESHOLD    = atoi(optarg); break;
-			case 'x': MIN_COV_RATIO    = atof(optarg); break;
-			case 'd': LOW_COV_THRESHOLD= atoi(optarg); break;
-			case 'w': WINDOW_SIZE      = atoi(optarg); break;
-			case 'P': PADDING          = atoi(optarg); break;
-			case 'u': MAX_AVG_COV      = atoi(optarg); break;
+			case 'c': cfg.COV_THRESHOLD    = atoi(optarg); break;
+			case 'x': cfg.MIN_COV_RATIO    = atof(optarg); break;
+			case 'd': cfg.LOW_COV_THRESHOLD= atoi(optarg); break;
+			case 'w': cfg.WINDOW_SIZE      = atoi(optarg); break;
+			case 'P': cfg.PADDING          = atoi(optarg); break;
+			case 'u': cfg.MAX_AVG_COV      = atoi(optarg); break;
 			
-			case 'q': MIN_QV_TRIM      = atoi(optarg); break;
-			case 'C': MIN_QV_CALL      = atoi(optarg); break;
-			case 'b': MIN_MAP_QUAL     = atoi(optarg); break;
-			case 'Z': MAX_DELTA_AS_XS  = atoi(optarg); break;
-			case 'Q': QV_RANGE         = *optarg;      break;
-
-			case 'L': NODE_STRLEN      = atoi(optarg); break;
-			case 'F': DFS_LIMIT        = atoi(optarg); break;
-			case 'X': NUM_THREADS      = atoi(optarg); break;
-			case 'T': MAX_INDEL_LEN    = atoi(optarg); break;
-			case 'M': MAX_MISMATCH     = atoi(optarg); break;
+			case 'q': cfg.MIN_QV_TRIM      = atoi(optarg); break;
+			case 'C': cfg.MIN_QV_CALL      = atoi(optarg); break;
+			case 'b': cfg.MIN_MAP_QUAL     = atoi(optarg); break;
+			case 'Z': cfg.MAX_DELTA_AS_XS  = atoi(optarg); break;
+			case 'Q': cfg.QV_RANGE         = *optarg;      break;
+
+			case 'L': cfg.NODE_STRLEN      = atoi(optarg); break;
+			case 'F': cfg.DFS_LIMIT        = atoi(optarg); break;
+			case 'X': cfg.NUM_THREADS      = atoi(optarg); break;
+			case 'T': cfg.MAX_INDEL_LEN    = atoi(optarg); break;
+			case 'M': cfg.MAX_MISMATCH     = atoi(optarg); break;
 			
-			case 'U': MAX_UNIT_LEN     = atoi(optarg); break;
-			case 'N': MIN_REPORT_UNITS = atoi(optarg); break;
-			case 'Y': MIN_REPORT_LEN   = atoi(optarg); break;
-			case 'D': DIST_FROM_STR    = atoi(optarg); break;
-
-			case 'E': filters.minPhredFisherSTR = atof(optarg); break;			
-			case 's': filters.minPhredFisher = atof(optarg); break;
-			case 'f': filters.minStrandBias = atof(optarg); break;
-			case 'a': filters.minAltCntTumor = atoi(optarg); break;
-			case 'm': filters.maxAltCntNormal = atoi(optarg); break;
-			case 'e': filters.minVafTumor = atof(optarg); break;
-			case 'i': filters.maxVafNormal = atof(optarg); break;
-			case 'o': filters.minCovTumor = atoi(optarg); break;
-			case 'y': filters.maxCovTumor = atoi(optarg); break;
-			case 'z': filters.minCovNormal = atoi(optarg); break;
-			case 'j': filters.maxCovNormal = atoi(optarg); break;
-
-			case 'J': LR_MODE          = 1;            break;
-			case 'I': PRIMARY_ALIGNMENT_ONLY   = 1;    break;
-			case 'O': XA_FILTER        = 1;            break;
-			case 'W': ACTIVE_REGIONS   = 0;            break;
-			case 'R': KMER_RECOVERY    = 1;            break;
-			case 'v': verbose          = 1;            break;
-			case 'V': VERBOSE=1; verbose=1;            break;
-			case 'A': PRINT_ALL        = 1;            break;
+			case 'U': cfg.MAX_UNIT_LEN     = atoi(optarg); break;
+			case 'N': cfg.MIN_REPORT_UNITS = atoi(optarg); break;
+			case 'Y': cfg.MIN_REPORT_LEN   = atoi(optarg); break;
+			case 'D': cfg.DIST_FROM_STR    = atoi(optarg); break;
+
+			case 'E': cfg.filters.minPhredFisherSTR = atof(optarg); break;			
+			case 's': cfg.filters.minPhredFisher = atof(optarg); break;
+			case 'f': cfg.filters.minStrandBias = atof(optarg); break;
+			case 'a': cfg.filters.minAltCntTumor = atoi(optarg); break;
+			case 'm': cfg.filters.maxAltCntNormal = atoi(optarg); break;
+			case 'e': cfg.filters.minVafTumor = atof(optarg); break;
+			case 'i': cfg.filters.maxVafNormal = atof(optarg); break;
+			case 'o': cfg.filters.minCovTumor = atoi(optarg); break;
+			case 'y': cfg.filters.maxCovTumor = atoi(optarg); break;
+			case 'z': cfg.filters.minCovNormal = atoi(optarg); break;
+			case 'j': cfg.filters.maxCovNormal = atoi(optarg); break;
+
+			case 'J': cfg.LR_MODE          = 1;            break;
+			case 'I': cfg.PRIMARY_ALIGNMENT_ONLY   = 1;    break;
+			case 'O': cfg.XA_FILTER        = 1;            break;
+			case 'W': cfg.ACTIVE_REGIONS   = 0;            break;
+			case OPT_ACTIVE_SCAN: cfg.ACTIVE_SCAN = 1;     break;
+			case OPT_ACTIVE_SCAN_CACHE: cfg.ACTIVE_SCAN = 1; cfg.ACTIVE_SCAN_CACHE = optarg; break;
+			case OPT_ADAPTIVE_WINDOWS: cfg.ACTIVE_SCAN = 1; cfg.ADAPTIVE_WINDOWS = 1; break;
+			case OPT_SHARD:
+				if( (sscanf(optarg, "%d/%d", &cfg.SHARD, &cfg.NUM_SHARDS) != 2) || (cfg.NUM_SHARDS < 1) || (cfg.SHARD < 1) || (cfg.SHARD > cfg.NUM_SHARDS) ) {
+					cerr << "Error: invalid shard " << optarg << " (expected i/N with 1 <= i <= N)" << endl;
+					exit(1);
+				}
+				break;
+			case OPT_JOURNAL: cfg.JOURNAL_FILE = optarg; break;
+			case OPT_RESUME: cfg.RESUME = 1; break;
+			case OPT_WINDOW_BUDGET: cfg.WINDOW_BUDGET = atof(optarg); break;
+			case OPT_COST_SCHEDULE: cfg.COST_SCHEDULE = 1; break;
+			case OPT_INDEX_PRUNE: cfg.INDEX_PRUNE = 1; break;
+			case OPT_BED_MERGE_GAP: cfg.BED_MERGE_GAP = atoi(optarg); break;
+			case OPT_NUMA: cfg.NUMA_MODE = 1; break;
+			case OPT_PIPELINE: cfg.PIPELINE_MODE = 1; break;
+			case OPT_READER_THREADS: cfg.PIPELINE_MODE = 1; cfg.READER_THREADS = max(1, atoi(optarg)); break;
+			case OPT_HTSLIB: cfg.HTSLIB = 1; break;
+			case OPT_HTS_THREADS: cfg.HTSLIB = 1; cfg.HTS_THREADS = atoi(optarg); break;
+			case OPT_BGZF_CACHE: cfg.BGZF_CACHE = atoi(optarg); break;
+			case OPT_SHARED_INDEX_OFF: cfg.SHARED_INDEX = 0; break;
+			case OPT_DOWNSAMPLE_OFF: cfg.DOWNSAMPLE = 0; break;
+			case OPT_MIN_WINDOW_BYTES: cfg.INDEX_PRUNE = 1; cfg.MIN_WINDOW_BYTES = atof(optarg); break;
+			case OPT_SERVE: SERVE_SOCKET = optarg; break;
+			case 'R': cfg.KMER_RECOVERY    = 1;            break;
+			case 'v': cfg.verbose          = 1;            break;
+			case 'V': cfg.VERBOSE=1; cfg.verbose=1;            break;
+			case 'A': cfg.PRINT_ALL        = 1;            break;
 
 			case 'h': errflg = 1;                      break;
 
@@ -779,201 +480,42 @@ int main(int argc, char** argv)
 		if (errflg)
 		{
 			//cout << helptext.str();
-			printHelpText(filters);
+			printHelpText(cfg);
 			exit (EXIT_FAILURE);
 		}
 	}
 
-	// update min base quality values
-	MIN_QUAL_TRIM = MIN_QV_TRIM + QV_RANGE;
-	MIN_QUAL_CALL = MIN_QV_CALL + QV_RANGE;
-
-	if (TUMOR == "") { cerr << "ERROR: Must provide the tumor BAM file (-t)" << endl; ++errflg; }
-	if (NORMAL == "") { cerr << "ERROR: Must provide the normal BAM file (-n)" << endl; ++errflg; }		
-	if (REFFILE == "") { cerr << "ERROR: Must provide a reference genome file (-r)" << endl; ++errflg; }
-	if ( (BEDFILE == "") && (REGION == "") ) { cerr << "ERROR: Must provide region (-p) or BED file (-B)" << endl; ++errflg; }
+	if (!cfg.check()) { ++errflg; }
+	if (SERVE_SOCKET != "") {
+		// the regions come from the requests
+		if ( (BEDFILE != "") || (REGION != "") ) { cerr << "ERROR: --serve cannot be used with -p or -B" << endl; ++errflg; }
+		if ( (cfg.JOURNAL_FILE != "") || (cfg.NUM_SHARDS > 0) ) { cerr << "ERROR: --serve cannot be used with --journal or --shard" << endl; ++errflg; }
+	}
+	else if ( (BEDFILE == "") && (REGION == "") ) { cerr << "ERROR: Must provide region (-p) or BED file (-B)" << endl; ++errflg; }
 
 	if (errflg) { exit(EXIT_FAILURE); }
 	
-	BamReader readerT;
-	// attempt to open the BamReader
-	if ( !readerT.Open(TUMOR) ) {
-		cerr << "Could not open tumor BAM file." << endl;
-		return -1;
-	}
-	
-	BamReader readerN;
-	// attempt to open the BamReader
-	if ( !readerN.Open(NORMAL) ) {
-		cerr << "Could not open normal BAM file." << endl;
-		return -1;
-	}
-	
-	bool found = (checkPresenceOfMDtag(readerT) || checkPresenceOfMDtag(readerN));	
-	if(!found && ACTIVE_REGIONS) {
-		cerr << endl << "--------WARNING--------" << endl;
-		cerr << "The MD tag is required to select the active regions, but is missing from the alignments in the BAM(s) file(s)." << endl;
-		cerr << "To avoid unpredictable behavior, the active region module has been automatically turned off (--active-region-off)" << endl;
-		cerr << "-----------------------" << endl << endl;
-		
-		ACTIVE_REGIONS = 0; 
-	}
-
-	RefVector references = readerT.GetReferenceData(); // Extract all reference sequence entries.
+	// open the BAM files and the reference
+	LancetEngine_t engine(cfg);
+	if (!engine.open()) { return -1; }
 	
     ofstream params_file;
     params_file.open ("config.txt");
-	printConfiguration(params_file, filters); // save parameters setting to file
+	printConfiguration(params_file, engine.getConfig(), REGION, BEDFILE); // save parameters setting to file
     params_file.close();
-	if(verbose) { printConfiguration(cerr, filters); }
-	
-	// run the assembler on each region
-	try {
-		
-		//Microassembler* driver = new Microassembler();
-		//driver->run(argc, argv);
-		//assembler->vDB.printToVCF();
-
-		pthread_t threads[NUM_THREADS];
-		pthread_attr_t attr;
-		void * status;
-		int rc;
-		int i;		
-		vector<Microassembler*> assemblers(NUM_THREADS, new Microassembler(LR_MODE));
-		vector< map<string, Ref_t *> > reftables(NUM_THREADS, map<string, Ref_t *>()); // table of references to analyze
-		
-		if (BEDFILE != "") {
-			loadBed(BEDFILE,reftables,references,NUM_THREADS);
-		}
-		if (REGION != "") {
-			loadRefs(REFFILE,REGION,reftables,references,NUM_THREADS, 0);
-		}
-		
-		cerr << num_windows << " total windows to process" << endl << endl;
-		
-		// Initialize and set thread joinable
-		pthread_attr_init(&attr);
-		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-		for( i=0; i < NUM_THREADS; ++i ) {
-			cerr << "starting thread " << (i+1) << " on " << reftables[i].size() << " windows" << endl;
-		
-			assemblers[i] = new Microassembler(LR_MODE);
-
-			//assemblers[i]->LR_MODE = LR_MODE;
-			assemblers[i]->XA_FILTER = XA_FILTER;
-			assemblers[i]->PRIMARY_ALIGNMENT_ONLY = PRIMARY_ALIGNMENT_ONLY;
-			assemblers[i]->ACTIVE_REGION_MODULE = ACTIVE_REGIONS;
-			assemblers[i]->KMER_RECOVERY = KMER_RECOVERY;
-			assemblers[i]->verbose = verbose;
-			assemblers[i]->VERBOSE = VERBOSE;
-			assemblers[i]->PRINT_DOT_READS = PRINT_DOT_READS;
-			assemblers[i]->PRINT_ALL = PRINT_ALL;
-			assemblers[i]->MIN_QV_CALL = MIN_QV_CALL;
-			assemblers[i]->MIN_QV_TRIM = MIN_QV_TRIM;
-			assemblers[i]->QV_RANGE = QV_RANGE;
-			assemblers[i]->MIN_QUAL_TRIM = MIN_QUAL_TRIM;
-			assemblers[i]->MIN_QUAL_CALL = MIN_QUAL_CALL;
-			assemblers[i]->MIN_MAP_QUAL = MIN_MAP_QUAL;
-			assemblers[i]->TUMOR = TUMOR;
-			assemblers[i]->NORMAL = NORMAL;
-			assemblers[i]->RG_FILE = RG_FILE;
-			assemblers[i]->REFFILE = REFFILE;
-			assemblers[i]->minK = minK;
-			assemblers[i]->maxK = maxK;
-			assemblers[i]->MAX_TIP_LEN = MAX_TIP_LEN;
-			assemblers[i]->MIN_THREAD_READS = MIN_THREAD_READS;
-			assemblers[i]->COV_THRESHOLD = COV_THRESHOLD;
-			assemblers[i]->MIN_COV_RATIO = MIN_COV_RATIO;
-			assemblers[i]->LOW_COV_THRESHOLD = LOW_COV_THRESHOLD;
-			assemblers[i]->MAX_AVG_COV = MAX_AVG_COV;
-			assemblers[i]->NODE_STRLEN = NODE_STRLEN;
-			assemblers[i]->DFS_LIMIT = DFS_LIMIT;
-			assemblers[i]->MAX_INDEL_LEN = MAX_INDEL_LEN;
-			assemblers[i]->MAX_MISMATCH = MAX_MISMATCH;		
-			assemblers[i]->MAX_UNIT_LEN = MAX_UNIT_LEN;
-			assemblers[i]->MIN_REPORT_UNITS = MIN_REPORT_UNITS;
-			assemblers[i]->MIN_REPORT_LEN = MIN_REPORT_LEN;
-			assemblers[i]->DIST_FROM_STR = DIST_FROM_STR;	
-			
-			assemblers[i]->reftable = &reftables[i];
-			assemblers[i]->setFilters(&filters);
-			assemblers[i]->setID(i+1);
+	if(cfg.verbose) { printConfiguration(cerr, engine.getConfig(), REGION, BEDFILE); }
 	
-			rc = pthread_create(&threads[i], NULL, execute, (void * )assemblers[i]);
-			
-			if (rc){
-				cerr << "Error:unable to create thread," << rc << endl;
-				exit(-1);
-			}
-		}
-		
-		// free attribute and wait for the other threads
-		pthread_attr_destroy(&attr);
-		for( i=0; i < NUM_THREADS; ++i ){
-			rc = pthread_join(threads[i], &status);
-			if (rc){
-				cerr << "Error:unable to join," << rc << endl;
-				exit(-1);
-			}
-			cerr << "Main: completed thread id :" << (i+1) ;
-			cerr << " exiting with status :" << status << endl;
-		}
-		
-		int tot_skip = 0;
-		int tot_svn_only = 0;
-		int tot_indel_only = 0;
-		int tot_softclip_only = 0;
-		int tot_indel_or_softclip = 0;
-		int tot_snv_or_indel = 0;
-		int tot_snv_or_softclip = 0;
-		int tot_snv_or_indel_or_softclip = 0;
-		//merge variant from all threads
-		cerr << "Merge variants" << endl;
-		VariantDB_t variantDB(LR_MODE); // variants DB
-		variantDB.setCommandLine(COMMAND_LINE);
-		variantDB.setFilters(&filters);
-		for( i=0; i < NUM_THREADS; ++i ) {
-			
-			tot_skip += assemblers[i]->num_skip;
-			tot_svn_only += assemblers[i]->num_snv_only_regions;
-			tot_indel_only += assemblers[i]->num_indel_only_regions;
-			tot_softclip_only += assemblers[i]->num_softclip_only_regions;
-			tot_indel_or_softclip += assemblers[i]->num_indel_or_softclip_regions;			
-			tot_snv_or_indel += assemblers[i]->num_snv_or_indel_regions;			
-			tot_snv_or_softclip += assemblers[i]->num_snv_or_softclip_regions;
-			tot_snv_or_indel_or_softclip += assemblers[i]->num_snv_or_indel_or_softclip_regions;
-						
-			map<string,Variant_t> db = (assemblers[i]->vDB).DB;
-			map<string,Variant_t>::iterator it;			
-			for (it=db.begin(); it!=db.end(); ++it) {
-				variantDB.addVar(it->second);
-			}
-		}
-		
-		//if(verbose) {
-			cerr << "Total # of skipped windows: " << tot_skip << " (" << (100*(double)tot_skip/double(num_windows)) << "\%)" << endl;
-			cerr << "- # of windows with SNVs only: " << tot_svn_only << endl;
-			cerr << "- # of windows with indels only: " << tot_indel_only << endl;
-			cerr << "- # of windows with softclips only: " << tot_softclip_only << endl;
-			cerr << "- # of windows with indels or softclips: " << tot_indel_or_softclip << endl;
-			cerr << "- # of windows with SNVs or indels: " << tot_snv_or_indel << endl;
-			cerr << "- # of windows with SNVs or softclips: " << tot_snv_or_softclip << endl;
-			cerr << "- # of windows with SNVs or indels or softclips: " << tot_snv_or_indel_or_softclip << endl;
-		//}
-		
-		/***** get current time and date *****/
-		time_t rawtime;
-		time (&rawtime);
-		char* DATE = ctime (&rawtime);
-		/***************************************/
-		
-		variantDB.selectVar();
-		variantDB.printToVCF(VERSION, REFFILE, DATE, filters, assemblers[0]->sample_name_normal, assemblers[0]->sample_name_tumor);		
-	}
-	catch (int e) {
-		cerr << "An exception occurred. Exception Nr. " << e << endl;
+	// answer the region requests until shutdown
+	if (SERVE_SOCKET != "") {
+		LancetServer_t server(&engine, SERVE_SOCKET);
+		server.VERSION = VERSION;
+		return server.run();
 	}
+	
+	// run the assembler on each region
+	LancetResult_t result;
+	if (engine.run(REGION, BEDFILE, result) < 0) { return -1; }
+	engine.printVCF(result, VERSION, cout);
 
-	pthread_exit(NULL);
+	return 0;
 }
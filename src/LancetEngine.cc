@@ -0,0 +1,927 @@
+#include "LancetEngine.hh"
+
+/****************************************************************************
+** LancetEngine.cc
+**
+** Reentrant variant calling engine: the configuration lives in a
+** LancetConfig_t, the BAM headers, the FASTA index and the BAM indexes are
+** opened once by open() and, together with the BAM readers of the assembly
+** threads, reused by every call to run(), so a long-lived process can call
+** many region batches without global state
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// constants
+//////////////////////////////////////////////////////////////////////////
+
+const char Graph_t::CODE_MAPPED = 'M';
+const char Graph_t::CODE_BASTARD = 'B';
+
+const string Graph_t::COLOR_ALL    = "white";
+const string Graph_t::COLOR_LOW    = "grey";
+const string Graph_t::COLOR_NOVO   = "darkorange3";
+const string Graph_t::COLOR_TUMOR  = "red";
+const string Graph_t::COLOR_NORMAL = "green";
+const string Graph_t::COLOR_SHARED = "blue"; //"deepskyblue4";
+const string Graph_t::COLOR_SOURCE = "orange\" style=\"filled";
+const string Graph_t::COLOR_SINK   = "yellow\" style=\"filled";
+const string Graph_t::COLOR_TOUCH  = "magenta";
+
+// default configuration
+//////////////////////////////////////////////////////////////
+LancetConfig_t::LancetConfig_t() {
+
+	NUM_THREADS = 1;
+	READER_THREADS = 1;
+
+	LR_MODE = false;
+	XA_FILTER = false;
+	PRIMARY_ALIGNMENT_ONLY = false;
+	ACTIVE_REGIONS = true;
+	ACTIVE_SCAN = false;
+	ADAPTIVE_WINDOWS = false;
+	RESUME = false;
+	COST_SCHEDULE = false;
+	INDEX_PRUNE = false;
+	NUMA_MODE = false;
+	PIPELINE_MODE = false;
+	HTSLIB = false;
+	HTS_THREADS = 0;
+	BGZF_CACHE = 64;
+	SHARED_INDEX = true;
+	verbose = false;
+	VERBOSE = false;
+	KMER_RECOVERY = false;
+	PRINT_ALL = false;
+	PRINT_DOT_READS = true;
+	MIN_QV_TRIM = 10;
+	MIN_QV_CALL = 17;
+	QV_RANGE = '!';
+	MIN_MAP_QUAL = 15;
+	MAX_DELTA_AS_XS = 5;
+	WINDOW_SIZE = 600;
+	WINDOW_BUDGET = 0;
+	MIN_WINDOW_BYTES = 0;
+	PADDING = 250;
+	BED_MERGE_GAP = 0;
+
+	minK = 11;
+	maxK = 101;
+	MAX_TIP_LEN = minK;
+	MIN_THREAD_READS = 1;
+	COV_THRESHOLD = 5;
+	MIN_COV_RATIO = 0.01;
+	LOW_COV_THRESHOLD = 1;
+	MAX_AVG_COV = 10000;
+	DOWNSAMPLE = true;
+	NODE_STRLEN = 100;
+	DFS_LIMIT = 1000000;
+	MAX_INDEL_LEN = 500;
+	MAX_MISMATCH = 2;
+
+	MAX_UNIT_LEN = 4;
+	MIN_REPORT_UNITS = 3;
+	MIN_REPORT_LEN = 7;
+	DIST_FROM_STR = 1;
+
+	SHARD = 0;
+	NUM_SHARDS = 0;
+
+	// initilize filter thresholds
+	filters.minPhredFisherSTR = 25;
+	filters.minPhredFisher = 5;
+	filters.minCovNormal = 10;
+	filters.maxCovNormal = 1000000;
+	filters.minCovTumor = 4;
+	filters.maxCovTumor = 1000000;
+	filters.minVafTumor = 0.04;
+	filters.maxVafNormal = 0;
+	filters.minAltCntTumor = 3;
+	filters.maxAltCntNormal = 0;
+	filters.minStrandBias = 1;
+}
+
+// check the required inputs and the combinations of options
+// (errors are reported to stderr)
+//////////////////////////////////////////////////////////////
+bool LancetConfig_t::check() {
+
+	bool errflg = false;
+
+	if (TUMOR == "") { cerr << "ERROR: Must provide the tumor BAM file (-t)" << endl; errflg = true; }
+	if (NORMAL == "") { cerr << "ERROR: Must provide the normal BAM file (-n)" << endl; errflg = true; }
+	if (REFFILE == "") { cerr << "ERROR: Must provide a reference genome file (-r)" << endl; errflg = true; }
+	if (HTS_THREADS < 0) { cerr << "ERROR: the number of decoding threads (--hts-threads) cannot be negative" << endl; errflg = true; }
+	if (BGZF_CACHE < 0) { cerr << "ERROR: the size of the BGZF block cache (--bgzf-cache) cannot be negative" << endl; errflg = true; }
+	if ( RESUME && (JOURNAL_FILE == "") ) { cerr << "ERROR: --resume requires the journal file (--journal)" << endl; errflg = true; }
+	if ( EXTRA_TUMORS.size() > 0 ) {
+		if (PIPELINE_MODE) { cerr << "ERROR: multiple tumors are not supported with --pipeline" << endl; errflg = true; }
+		if (JOURNAL_FILE != "") { cerr << "ERROR: multiple tumors are not supported with --journal" << endl; errflg = true; }
+		if (NUM_SHARDS > 0) { cerr << "ERROR: multiple tumors are not supported with --shard" << endl; errflg = true; }
+		if (ACTIVE_SCAN) { cerr << "ERROR: multiple tumors are not supported with --active-scan" << endl; errflg = true; }
+		if (LR_MODE) { cerr << "ERROR: multiple tumors are not supported with --linked-reads" << endl; errflg = true; }
+	}
+
+	return !errflg;
+}
+
+// signature of the parameters that select the reads and change the
+// assembled variants or their filters (the performance options are left
+// out, so a run can be resumed with different threads or caches)
+//////////////////////////////////////////////////////////////
+string LancetConfig_t::signature() {
+
+	stringstream ss;
+	ss.precision(17);
+	ss << "reads:" << MIN_MAP_QUAL << ":" << MAX_DELTA_AS_XS << ":" << MIN_QV_TRIM << ":" << MIN_QV_CALL << ":" << QV_RANGE
+	   << ":" << LR_MODE << ":" << XA_FILTER << ":" << PRIMARY_ALIGNMENT_ONLY << ":" << RG_FILE
+	   << ":" << MAX_AVG_COV << ":" << DOWNSAMPLE << ":" << ACTIVE_REGIONS << ":" << ACTIVE_SCAN << ":" << ADAPTIVE_WINDOWS;
+	ss << "|assembly:" << minK << ":" << maxK << ":" << MAX_TIP_LEN << ":" << MIN_THREAD_READS << ":" << COV_THRESHOLD
+	   << ":" << MIN_COV_RATIO << ":" << LOW_COV_THRESHOLD << ":" << NODE_STRLEN << ":" << DFS_LIMIT
+	   << ":" << MAX_INDEL_LEN << ":" << MAX_MISMATCH << ":" << KMER_RECOVERY;
+	ss << "|str:" << MAX_UNIT_LEN << ":" << MIN_REPORT_UNITS << ":" << MIN_REPORT_LEN << ":" << DIST_FROM_STR;
+	ss << "|filters:" << filters.minPhredFisher << ":" << filters.minPhredFisherSTR << ":" << filters.minStrandBias
+	   << ":" << filters.minAltCntTumor << ":" << filters.maxAltCntNormal << ":" << filters.minVafTumor << ":" << filters.maxVafNormal
+	   << ":" << filters.minCovTumor << ":" << filters.maxCovTumor << ":" << filters.minCovNormal << ":" << filters.maxCovNormal;
+
+	return sha256(ss.str());
+}
+
+LancetEngine_t::LancetEngine_t(const LancetConfig_t & cfg)
+	: config(cfg), is_open(false), indexed(false), bam_cache(NULL)
+{
+	hts_pool.pool = NULL;
+	hts_pool.qsize = 0;
+	pthread_mutex_init(&run_lock, NULL);
+}
+
+LancetEngine_t::~LancetEngine_t() {
+	close();
+	pthread_mutex_destroy(&run_lock);
+}
+
+// open the BAM headers, the FASTA index and the BAM indexes once for all
+// the runs of the engine (false if an input cannot be opened)
+//////////////////////////////////////////////////////////////
+bool LancetEngine_t::open() {
+
+	if (is_open) { return true; }
+	if (!config.check()) { return false; }
+
+	// release what was set up before the failure (pool, caches, reference)
+	if (!openInputs()) { close(); return false; }
+
+	is_open = true;
+	return true;
+}
+
+// set up the shared state of the engine and check the inputs (see open)
+//////////////////////////////////////////////////////////////
+bool LancetEngine_t::openInputs() {
+
+	// htslib readers (CRAM files or --htslib) share one pool of decoding threads
+	reader_opts.htslib = config.HTSLIB;
+	reader_opts.reffile = config.REFFILE;
+	if (config.HTS_THREADS > 0) {
+		hts_pool.pool = hts_tpool_init(config.HTS_THREADS);
+		hts_pool.qsize = 0;
+		if (hts_pool.pool == NULL) { cerr << "Could not create the pool of " << config.HTS_THREADS << " decoding threads" << endl; return false; }
+		reader_opts.pool = &hts_pool;
+	}
+
+	// the bamtools readers of all the threads share the inflated BGZF blocks
+	// and the bins of the indexes, loaded by the first reader of each file
+	bam_cache = new BamReaderCache((size_t)config.BGZF_CACHE << 20, config.SHARED_INDEX);
+	reader_opts.cache = bam_cache;
+
+	AlignmentReader_t readerT;
+	// attempt to open the reader
+	if ( !readerT.open(config.TUMOR, &reader_opts) ) {
+		cerr << "Could not open tumor BAM file." << endl;
+		return false;
+	}
+
+	AlignmentReader_t readerN;
+	// attempt to open the reader
+	if ( !readerN.open(config.NORMAL, &reader_opts) ) {
+		cerr << "Could not open normal BAM file." << endl;
+		return false;
+	}
+
+	bool found = (checkPresenceOfMDtag(readerT) || checkPresenceOfMDtag(readerN));
+	if(!found && config.ACTIVE_REGIONS) {
+		cerr << endl << "--------WARNING--------" << endl;
+		cerr << "The MD tag is required to select the active regions, but is missing from the alignments in the BAM(s) file(s)." << endl;
+		cerr << "To avoid unpredictable behavior, the active region module has been automatically turned off (--active-region-off)" << endl;
+		cerr << "-----------------------" << endl << endl;
+
+		config.ACTIVE_REGIONS = 0;
+	}
+
+	references = readerT.getReferenceData(); // Extract all reference sequence entries.
+	readerT.close();
+	readerN.close();
+
+	// the tumors share the windows: their BAMs must be aligned to the same reference
+	for (unsigned int t = 0; t < config.EXTRA_TUMORS.size(); ++t) {
+		AlignmentReader_t readerX;
+		if ( !readerX.open(config.EXTRA_TUMORS[t], &reader_opts) ) {
+			cerr << "Could not open tumor BAM file " << config.EXTRA_TUMORS[t] << endl;
+			return false;
+		}
+		RefVector refsX = readerX.getReferenceData();
+		bool same = (refsX.size() == references.size());
+		for (unsigned int r = 0; same && r < refsX.size(); ++r) {
+			same = (refsX[r].RefName == references[r].RefName) && (refsX[r].RefLength == references[r].RefLength);
+		}
+		readerX.close();
+		if (!same) {
+			cerr << "ERROR: the reference sequences of " << config.EXTRA_TUMORS[t] << " do not match those of " << config.TUMOR << endl;
+			return false;
+		}
+	}
+
+	// open fasta index (and map the sequence)
+	if ( !reference.open(config.REFFILE) ) { return false; }
+
+	// read the alignment bytes of the windows from the BAM indexes
+	if (config.COST_SCHEDULE || config.INDEX_PRUNE) {
+		indexed = true;
+		if (!model.loadIndex(config.TUMOR)) { cerr << "Warning: could not read the index of " << config.TUMOR << " for the cost model" << endl; indexed = false; }
+		if (!model.loadIndex(config.NORMAL)) { cerr << "Warning: could not read the index of " << config.NORMAL << " for the cost model" << endl; indexed = false; }
+		for (unsigned int t = 0; t < config.EXTRA_TUMORS.size(); ++t) {
+			if (!model.loadIndex(config.EXTRA_TUMORS[t])) { cerr << "Warning: could not read the index of " << config.EXTRA_TUMORS[t] << " for the cost model" << endl; indexed = false; }
+		}
+	}
+
+	// the assembly threads open their readers in the first run
+	for (int i = 0; i < config.NUM_THREADS; ++i) { thread_readers.push_back(new AssemblerReaders_t()); }
+
+	return true;
+}
+
+// close the BAM readers of the threads and release the FASTA index
+//////////////////////////////////////////////////////////////
+void LancetEngine_t::close() {
+
+	for (unsigned int i = 0; i < thread_readers.size(); ++i) { delete thread_readers[i]; }
+	thread_readers.clear();
+	reference.close();
+	if (hts_pool.pool != NULL) { hts_tpool_destroy(hts_pool.pool); hts_pool.pool = NULL; }
+	reader_opts.pool = NULL;
+	delete bam_cache; // after the readers using it
+	bam_cache = NULL;
+	reader_opts.cache = NULL;
+	is_open = false;
+}
+
+// loadRef
+//////////////////////////////////////////////////////////////
+int LancetEngine_t::loadRefs(const string region, WindowQueue_t &queue)
+{
+	RefVector &bamrefs = references;
+	string hdr = region;
+	string CHR;
+	string START;
+	string END;
+	int REFID = -1; // reference id in the BAM header
+
+	// extrat coordinates for header
+	size_t x     = hdr.find_first_of(':');
+
+	if ( (x == string::npos) && (hdr.length()>0) ) { // no ":" symbol found -> assume single chromosome name format
+		CHR   = hdr.substr(0,x);
+		START = "1";
+		std::vector<RefData>::iterator it;
+	    for (it = bamrefs.begin() ; it != bamrefs.end(); ++it) {
+			//cerr << it->RefName << endl;
+			if (it->RefName == CHR) {
+			    std::ostringstream oss;
+			    oss << it->RefLength;
+				END = oss.str();
+				REFID = it - bamrefs.begin();
+				break;
+			}
+	    }
+
+		// report error if the chromosome label is not found in BAM header.
+		if (it == bamrefs.end()) {
+			cerr << "ERROR: chromosome label " << CHR << " not found in BAM header!" << endl;
+		}
+
+	}
+	else {
+		size_t y = hdr.find_first_of('-', x);
+		CHR  	 = hdr.substr(0,x);
+		START	 = hdr.substr(x+1, y-x-1);
+		END   	 = hdr.substr(y+1, string::npos);
+
+		int SP = stoi(START) - config.PADDING;
+		int EP = stoi(END) + config.PADDING;
+
+		if(SP<1) {SP=1;} // start position cannnot be less than 1
+		// check chromosome size
+		std::vector<RefData>::iterator it;
+	    for (it = bamrefs.begin() ; it != bamrefs.end(); ++it) {
+			if (it->RefName == CHR) {
+				if(EP > it->RefLength) { EP = it->RefLength; }
+				REFID = it - bamrefs.begin();
+				break;
+			}
+		}
+		// save updated coordinates
+		START = itos(SP);
+		END = itos(EP);
+	}
+	//cerr << CHR << ":" << START << "-" << END << endl;
+	string REG = CHR+":"+START+"-"+END;
+
+	// clip region to the length of the reference sequence
+	int chr_len = reference.seqLength(CHR);
+	if ( chr_len < 0 ) { cerr << "Failed to fetch sequence in " << REG << endl; return 0; }
+
+	int SP = atoi(START.c_str());
+	int EP = chr_len;
+	if (END != "" && stoi(END) < EP) { EP = stoi(END); }
+	int len = EP - SP + 1;
+	if (len < 0) { len = 0; }
+
+	// windows are split and loaded on demand by the threads
+	return queue.addRegion(CHR, REFID, SP, len);
+}
+
+// loadbed : load regions from BED file
+//////////////////////////////////////////////////////////////
+bool LancetEngine_t::loadBed(const string bedfile, WindowQueue_t &queue) {
+
+	int PADDING = config.PADDING;
+	int BED_MERGE_GAP = config.BED_MERGE_GAP;
+	int num_regions = 0;
+	int num_blocks = 0;
+	string line;
+	string region;
+	vector<std::string> tokens;
+	vector<string> chrs; // chromosomes in order of appearance
+	map< string, vector< pair<int,int> > > intervals; // padded intervals by chromosome
+	set< pair< string, pair<int,int> > > loaded; // intervals already swept (no merging)
+	ifstream bfile (bedfile);
+	if (bfile.is_open()) {
+		while ( getline (bfile,line) ) {
+
+			size_t x = line.find_first_of('#');
+			if(x == 0) { continue; } // skip comments
+
+			//cerr << line << '\n';
+
+			// extrat coordinates
+		    istringstream iss(line);
+		    string token;
+			tokens.clear();
+		    while(std::getline(iss, token, '\t')) {  // but we can specify a different one
+				tokens.push_back(token);
+			}
+			if(tokens.size() < 3) { continue; } // skip empty lines
+
+			++num_regions;
+
+			int SP = stoi(tokens[1]) - PADDING;
+			int EP = stoi(tokens[2]) + PADDING;
+
+			if(SP<1) {SP=1;} // start position cannnot be less than 1
+
+			if(BED_MERGE_GAP < 0) { // no merging: one window sweep per distinct line
+				if(!loaded.insert(make_pair(tokens[0], make_pair(SP,EP))).second) { continue; }
+				region = tokens[0] + ":" + itos(SP) + "-" + itos(EP);
+				loadRefs(region,queue);
+				++num_blocks;
+				continue;
+			}
+
+			if(intervals.find(tokens[0]) == intervals.end()) { chrs.push_back(tokens[0]); }
+			intervals[tokens[0]].push_back(make_pair(SP,EP));
+		}
+		bfile.close();
+
+		// sort the intervals and merge the ones that overlap or lie within
+		// BED_MERGE_GAP bp of each other (after the padding added by loadRefs),
+		// so that every base is windowed once and each block is swept once
+		for (unsigned int c = 0; c < chrs.size(); ++c) {
+			vector< pair<int,int> > & iv = intervals[chrs[c]];
+			sort(iv.begin(), iv.end());
+
+			unsigned int i = 0;
+			while (i < iv.size()) {
+				int SP = iv[i].first;
+				int EP = iv[i].second;
+				++i;
+				while ( (i < iv.size()) && (iv[i].first - PADDING <= EP + PADDING + BED_MERGE_GAP + 1) ) {
+					if(iv[i].second > EP) { EP = iv[i].second; }
+					++i;
+				}
+
+				region = chrs[c] + ":" + itos(SP) + "-" + itos(EP);
+				loadRefs(region,queue);
+				++num_blocks;
+			}
+		}
+
+		cerr << "Loaded " << num_regions << " from bedfile (" << num_blocks << " blocks)" << endl;
+	}
+	else {
+		cerr << "Couldn't open " << bedfile << endl;
+		return false;
+	}
+	return true;
+}
+
+void* LancetEngine_t::execute(void* ptr) {
+
+    Microassembler* ma = (Microassembler*)ptr;
+
+	if(ma->processReads() < 0) {
+		ma->failed = true;
+		ma->queue->stop(); // the run is aborted: the other threads stop after their current window
+	}
+	if(ma->pipeline != NULL) { ma->pipeline->workerDone(); }
+	//ma->vDB.printToVCF();
+
+	pthread_exit(NULL);
+}
+
+// run : assemble the windows of a region (chr:start-end) and/or of a BED
+// file and return the variants in result (0 on success, -1 on error)
+// the runs of the same engine are serialized
+//////////////////////////////////////////////////////////////
+int LancetEngine_t::run(const string & region, const string & bedfile, LancetResult_t & result) {
+
+	vector<string> regions;
+	if (region != "") { regions.push_back(region); }
+	return run(regions, bedfile, result);
+}
+
+// run : assemble the windows of several regions and/or of a BED file
+//////////////////////////////////////////////////////////////
+int LancetEngine_t::run(const vector<string> & regions, const string & bedfile, LancetResult_t & result) {
+
+	if (!open()) { return -1; }
+	if ( (bedfile == "") && regions.empty() ) { cerr << "ERROR: Must provide region (-p) or BED file (-B)" << endl; return -1; }
+
+	pthread_mutex_lock(&run_lock);
+	int rc = runAssembly(regions, bedfile, result);
+	pthread_mutex_unlock(&run_lock);
+
+	return rc;
+}
+
+// run : call back each variant of the run in genomic order
+// returns the number of variants (-1 on error)
+//////////////////////////////////////////////////////////////
+int LancetEngine_t::run(const string & region, const string & bedfile, VariantCallback_t callback, void * data) {
+
+	LancetResult_t result;
+	if (run(region, bedfile, result) < 0) { return -1; }
+
+	VariantDB_t & db = result.db;
+	vector< pair<string,Variant_t> > myVec(db.DB.begin(), db.DB.end());
+	sort(myVec.begin(),myVec.end(),byPos());
+
+	int num_variants = 0;
+	vector< pair<string,Variant_t> >::iterator it;
+	for (it=myVec.begin(); it!=myVec.end(); ++it) {
+		string record;
+		if (config.EXTRA_TUMORS.size() > 0) { record = it->second.printMultiVCF(&config.filters); }
+		else { record = it->second.printVCF(&config.filters, (db.shard > 0)); }
+		callback(it->second, record, data);
+		++num_variants;
+	}
+
+	return num_variants;
+}
+
+// printVCF : export the variants of a run to VCF
+//////////////////////////////////////////////////////////////
+void LancetEngine_t::printVCF(LancetResult_t & result, const string & version, ostream & out) {
+
+	/***** get current time and date *****/
+	time_t rawtime;
+	time (&rawtime);
+	char* DATE = ctime (&rawtime);
+	/***************************************/
+
+	if (result.sample_name_extra.size() > 0) {
+		// multi-sample VCF with one column for each tumor
+		vector<string> names(1, result.sample_name_tumor);
+		names.insert(names.end(), result.sample_name_extra.begin(), result.sample_name_extra.end());
+		result.db.printMultiToVCF(version, config.REFFILE, DATE, config.filters, result.sample_name_normal, names, out);
+	}
+	else {
+		result.db.printToVCF(version, config.REFFILE, DATE, config.filters, result.sample_name_normal, result.sample_name_tumor, out);
+	}
+}
+
+// runAssembly : process all windows in parallel and merge the variants
+//////////////////////////////////////////////////////////////
+int LancetEngine_t::runAssembly(const vector<string> & regions, const string & bedfile, LancetResult_t & result) {
+
+	LancetConfig_t & c = config;
+	Filters & filters = config.filters;
+
+	try {
+
+		pthread_t threads[c.NUM_THREADS];
+		pthread_attr_t attr;
+		void * status;
+		int rc;
+		int i;
+		int num_windows = 0;
+		int num_started = 0; // assembly threads started
+		bool failed = false; // a thread could not be started or stopped on an error
+		vector<Microassembler*> assemblers(c.NUM_THREADS, NULL);
+		WindowQueue_t queue(c.WINDOW_SIZE); // shared queue of windows to analyze
+
+		if (bedfile != "") {
+			if (!loadBed(bedfile,queue)) { return -1; }
+		}
+		for (unsigned int r = 0; r < regions.size(); ++r) {
+			loadRefs(regions[r],queue);
+		}
+		num_windows = queue.size();
+
+		queue.sortByPosition(); // visit windows in genomic order
+
+		// drop the windows without reads before any decompression
+		if (c.INDEX_PRUNE && !indexed) {
+			cerr << "Warning: --index-prune requires the BAM indexes, option ignored" << endl;
+		}
+		else if (c.INDEX_PRUNE) {
+			int total = num_windows;
+			int num_pruned = queue.pruneWindows(model, c.MIN_WINDOW_BYTES);
+			num_windows = queue.size();
+			cerr << "Index pruning: " << num_pruned << " of " << total << " windows pruned (" << num_windows << " left)" << endl;
+		}
+
+		// estimate the cost of the windows from the BAM indexes and the reference
+		if (c.COST_SCHEDULE) {
+			model.setReference(&reference);
+			queue.estimateCosts(model);
+
+			double max_cost = 0;
+			double tot_cost = 0;
+			for (unsigned int w = 0; w < queue.cost.size(); ++w) {
+				tot_cost += queue.cost[w];
+				if(queue.cost[w] > max_cost) { max_cost = queue.cost[w]; }
+			}
+			cerr << "Cost model: mean window cost " << (tot_cost / max(1, num_windows)) << ", max " << max_cost << endl;
+		}
+
+		if (c.NUM_SHARDS > 0) {
+			int total = num_windows;
+			num_windows = queue.selectShard(c.SHARD, c.NUM_SHARDS);
+			cerr << "Shard " << c.SHARD << "/" << c.NUM_SHARDS << ": " << num_windows << " of " << total << " windows" << endl;
+		}
+
+		if (c.ADAPTIVE_WINDOWS && !c.ACTIVE_REGIONS) {
+			cerr << "Warning: --adaptive-windows requires the active region module, option ignored" << endl;
+		}
+
+		// pre-scan the BAMs to skip the windows without evidence of variation
+		if (c.ACTIVE_SCAN && c.ACTIVE_REGIONS) {
+			struct timespec sstart, sfinish;
+			clock_gettime(CLOCK_MONOTONIC, &sstart);
+
+			ActiveScan_t scan;
+			scan.TUMOR = c.TUMOR;
+			scan.NORMAL = c.NORMAL;
+			scan.CACHE_FILE = c.ACTIVE_SCAN_CACHE;
+			scan.MIN_MAP_QUAL = c.MIN_MAP_QUAL;
+			scan.MIN_QUAL_CALL = c.minQualCall();
+			scan.MIN_EVIDENCE = filters.minAltCntTumor;
+			scan.verbose = c.verbose;
+			scan.reader_opts = &reader_opts;
+			int num_active = scan.run(queue, c.NUM_THREADS);
+			if (num_active < 0) { return -1; }
+
+			clock_gettime(CLOCK_MONOTONIC, &sfinish);
+			double scan_time = (sfinish.tv_sec - sstart.tv_sec);
+			scan_time += (sfinish.tv_nsec - sstart.tv_nsec) / 1000000000.0;
+			cerr << "Active-region pre-scan: " << num_active << " of " << num_windows << " windows to assemble (" << scan_time << " seconds)" << endl;
+
+			if (c.ADAPTIVE_WINDOWS) {
+				vector< vector<int> > hot(scan.results.size());
+				for (unsigned int b = 0; b < scan.results.size(); ++b) {
+					if(!scan.results[b].all) { hot[b] = scan.results[b].hot; }
+				}
+				queue.mergeActive(hot, MAX_MERGED_WINDOWS*c.WINDOW_SIZE);
+				num_windows = queue.size();
+				cerr << "Adaptive windows: " << num_windows << " merged regions to assemble" << endl;
+				if (c.COST_SCHEDULE) { queue.estimateCosts(model); }
+			}
+		}
+
+		// journal of the completed windows: with --resume the windows completed
+		// by the interrupted run are skipped and their variants are reloaded
+		Journal_t journal;
+		VariantDB_t resumedDB(c.LR_MODE); // variants of the completed windows
+		if (c.JOURNAL_FILE != "") {
+			string key = c.TUMOR + "\t" + c.NORMAL + "\t" + c.REFFILE + "\t" + queue.signature() + "\t" + c.signature();
+			int num_resumed = 0;
+			if (c.RESUME) {
+				num_resumed = journal.load(c.JOURNAL_FILE, key, c.LR_MODE, queue, resumedDB);
+				if (num_resumed < 0) { return -1; }
+				cerr << "Resume: " << num_resumed << " of " << num_windows << " windows already completed (" << resumedDB.getNumVariants() << " variants) in " << c.JOURNAL_FILE << endl;
+			}
+			if (!journal.open(c.JOURNAL_FILE, key, c.RESUME)) { return -1; }
+		}
+
+		queue.setChunkSize(c.NUM_THREADS);
+
+		// NUMA placement: split the windows across the nodes and pin the
+		// threads of each node to its cpus
+		NumaTopology_t numa;
+		if (c.NUMA_MODE) {
+			numa.load();
+			if(numa.numNodes() > c.NUM_THREADS) { numa.node_cpus.resize(c.NUM_THREADS); numa.node_ids.resize(c.NUM_THREADS); }
+			queue.setNodes(numa.numNodes());
+			cerr << "NUMA placement: " << numa.numNodes() << " node(s)" << endl;
+		}
+
+		cerr << num_windows << " total windows to process (chunks of " << queue.getChunkSize() << " windows)" << endl << endl;
+
+		struct timespec start, finish;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		uint64_t cache_hits = 0, cache_misses = 0;
+		bam_cache->GetBlockCacheStats(cache_hits, cache_misses);
+
+		// pipeline mode: reader threads fetch the reads of the windows for
+		// the assembly threads and a collector thread gathers the variants
+		Pipeline_t * pipeline = NULL;
+		if (c.PIPELINE_MODE) {
+			pipeline = new Pipeline_t(&queue, c.READER_THREADS, c.NUM_THREADS, c.LR_MODE);
+			pipeline->TUMOR = c.TUMOR;
+			pipeline->NORMAL = c.NORMAL;
+			pipeline->reference = &reference;
+			pipeline->reader_opts = &reader_opts;
+			pipeline->MIN_MAP_QUAL = c.MIN_MAP_QUAL;
+			pipeline->minK = c.minK;
+			pipeline->maxK = c.maxK;
+			pipeline->filters = &filters;
+			if (c.JOURNAL_FILE != "") { pipeline->journal = &journal; }
+			if (!pipeline->start()) { delete pipeline; return -1; }
+			cerr << "Pipeline: " << c.READER_THREADS << " reader thread(s), " << c.NUM_THREADS << " assembly thread(s), 1 collector thread" << endl;
+		}
+
+		// Initialize and set thread joinable
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+		for( i=0; i < c.NUM_THREADS; ++i ) {
+			cerr << "starting thread " << (i+1) << endl;
+
+			assemblers[i] = new Microassembler(c.LR_MODE);
+
+			//assemblers[i]->LR_MODE = LR_MODE;
+			assemblers[i]->XA_FILTER = c.XA_FILTER;
+			assemblers[i]->PRIMARY_ALIGNMENT_ONLY = c.PRIMARY_ALIGNMENT_ONLY;
+			assemblers[i]->ACTIVE_REGION_MODULE = c.ACTIVE_REGIONS;
+			assemblers[i]->KMER_RECOVERY = c.KMER_RECOVERY;
+			assemblers[i]->verbose = c.verbose;
+			assemblers[i]->VERBOSE = c.VERBOSE;
+			assemblers[i]->PRINT_DOT_READS = c.PRINT_DOT_READS;
+			assemblers[i]->PRINT_ALL = c.PRINT_ALL;
+			assemblers[i]->MIN_QV_CALL = c.MIN_QV_CALL;
+			assemblers[i]->MIN_QV_TRIM = c.MIN_QV_TRIM;
+			assemblers[i]->QV_RANGE = c.QV_RANGE;
+			assemblers[i]->MIN_QUAL_TRIM = c.minQualTrim();
+			assemblers[i]->MIN_QUAL_CALL = c.minQualCall();
+			assemblers[i]->MIN_MAP_QUAL = c.MIN_MAP_QUAL;
+			assemblers[i]->WINDOW_SIZE = c.WINDOW_SIZE;
+			assemblers[i]->WINDOW_BUDGET = c.WINDOW_BUDGET;
+			assemblers[i]->MAX_DELTA_AS_XS = c.MAX_DELTA_AS_XS;
+			assemblers[i]->TUMOR = c.TUMOR;
+			assemblers[i]->EXTRA_TUMORS = c.EXTRA_TUMORS;
+			assemblers[i]->NORMAL = c.NORMAL;
+			assemblers[i]->RG_FILE = c.RG_FILE;
+			assemblers[i]->reference = &reference;
+			assemblers[i]->reader_opts = &reader_opts;
+			assemblers[i]->minK = c.minK;
+			assemblers[i]->maxK = c.maxK;
+			assemblers[i]->MAX_TIP_LEN = c.MAX_TIP_LEN;
+			assemblers[i]->MIN_THREAD_READS = c.MIN_THREAD_READS;
+			assemblers[i]->COV_THRESHOLD = c.COV_THRESHOLD;
+			assemblers[i]->MIN_COV_RATIO = c.MIN_COV_RATIO;
+			assemblers[i]->LOW_COV_THRESHOLD = c.LOW_COV_THRESHOLD;
+			assemblers[i]->MAX_AVG_COV = c.MAX_AVG_COV;
+			assemblers[i]->DOWNSAMPLE = c.DOWNSAMPLE;
+			assemblers[i]->NODE_STRLEN = c.NODE_STRLEN;
+			assemblers[i]->DFS_LIMIT = c.DFS_LIMIT;
+			assemblers[i]->MAX_INDEL_LEN = c.MAX_INDEL_LEN;
+			assemblers[i]->MAX_MISMATCH = c.MAX_MISMATCH;
+			assemblers[i]->MAX_UNIT_LEN = c.MAX_UNIT_LEN;
+			assemblers[i]->MIN_REPORT_UNITS = c.MIN_REPORT_UNITS;
+			assemblers[i]->MIN_REPORT_LEN = c.MIN_REPORT_LEN;
+			assemblers[i]->DIST_FROM_STR = c.DIST_FROM_STR;
+
+			assemblers[i]->queue = &queue;
+			if (c.JOURNAL_FILE != "" && pipeline == NULL) { assemblers[i]->journal = &journal; }
+			assemblers[i]->pipeline = pipeline;
+			assemblers[i]->readers = thread_readers[i];
+			assemblers[i]->setFilters(&filters);
+			assemblers[i]->setID(i+1);
+			if (c.NUMA_MODE) { numa.assign(i, c.NUM_THREADS, assemblers[i]->NODE, assemblers[i]->CPU); }
+
+			rc = pthread_create(&threads[i], NULL, execute, (void * )assemblers[i]);
+
+			if (rc){
+				cerr << "Error:unable to create thread," << rc << endl;
+				failed = true;
+				break;
+			}
+			++num_started;
+		}
+
+		// the threads already started stop after their current window
+		if (failed) {
+			queue.stop();
+			for( i=num_started; i < c.NUM_THREADS; ++i ) {
+				if (pipeline != NULL) { pipeline->workerDone(); }
+			}
+		}
+
+		// free attribute and wait for the other threads
+		pthread_attr_destroy(&attr);
+		for( i=0; i < num_started; ++i ){
+			rc = pthread_join(threads[i], &status);
+			if (rc){
+				cerr << "Error:unable to join," << rc << endl;
+				failed = true;
+				continue;
+			}
+			if (assemblers[i]->failed) { failed = true; }
+			cerr << "Main: completed thread id :" << (i+1) ;
+			cerr << " exiting with status :" << status << endl;
+		}
+
+		if (pipeline != NULL) {
+			pipeline->join();
+			if (pipeline->failed) { failed = true; }
+		}
+
+		if (failed) {
+			cerr << "ERROR: the run was aborted" << endl;
+			for( i=0; i < c.NUM_THREADS; ++i ) { delete assemblers[i]; }
+			delete pipeline;
+			return -1;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &finish);
+		double wall_time = (finish.tv_sec - start.tv_sec);
+		wall_time += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+
+		// report load balance across threads
+		cerr << "Thread load balance (wall time: " << wall_time << " seconds)" << endl;
+		for( i=0; i < c.NUM_THREADS; ++i ) {
+			double idle_time = wall_time - assemblers[i]->busy_time;
+			if(idle_time < 0) { idle_time = 0; }
+			cerr << "- thread " << (i+1) << ": " << assemblers[i]->num_windows_done << " windows, busy " << assemblers[i]->busy_time << " seconds, idle " << idle_time << " seconds" << endl;
+		}
+
+		// report the balance between the stages of the pipeline
+		if (pipeline != NULL) {
+			cerr << "- readers: " << pipeline->num_alignments << " alignments, busy " << pipeline->read_time << " seconds, waited " << pipeline->readerWait() << " seconds for the assembly threads" << endl;
+			cerr << "- assembly threads: waited " << pipeline->workerWait() << " seconds for the readers" << endl;
+		}
+
+		// report the BGZF blocks shared between the readers during this run
+		if (c.BGZF_CACHE > 0) {
+			uint64_t hits = 0, misses = 0;
+			bam_cache->GetBlockCacheStats(hits, misses);
+			hits -= cache_hits;
+			misses -= cache_misses;
+			double rate = (hits + misses > 0) ? (100 * (double)hits / (double)(hits + misses)) : 0;
+			cerr << "- BGZF block cache: " << hits << " hits, " << misses << " misses (" << rate << "\% hit rate)" << endl;
+		}
+
+		// report throughput of each NUMA node
+		if (c.NUMA_MODE) {
+			for (int n = 0; n < numa.numNodes(); ++n) {
+				int node_threads = 0;
+				int node_windows = 0;
+				double node_busy = 0;
+				for( i=0; i < c.NUM_THREADS; ++i ) {
+					if(assemblers[i]->NODE != n) { continue; }
+					++node_threads;
+					node_windows += assemblers[i]->num_windows_done;
+					node_busy += assemblers[i]->busy_time;
+				}
+				double rate = (wall_time > 0) ? (node_windows / wall_time) : 0;
+				cerr << "- node " << numa.node_ids[n] << ": " << node_threads << " threads, " << node_windows << " windows, busy " << node_busy << " seconds, " << rate << " windows/second" << endl;
+			}
+		}
+
+		int tot_skip = 0;
+		int tot_svn_only = 0;
+		int tot_indel_only = 0;
+		int tot_softclip_only = 0;
+		int tot_indel_or_softclip = 0;
+		int tot_snv_or_indel = 0;
+		int tot_snv_or_softclip = 0;
+		int tot_snv_or_indel_or_softclip = 0;
+		int tot_split = 0;
+		int tot_resumed = 0;
+		int tot_deferred = 0;
+		int tot_budget_skip = 0;
+		int tot_downsampled = 0;
+		//merge variant from all threads
+		cerr << "Merge variants" << endl;
+		VariantDB_t & variantDB = result.db; // variants DB
+		variantDB = VariantDB_t(c.LR_MODE);
+		variantDB.setCommandLine(c.COMMAND_LINE);
+		variantDB.setFilters(&filters);
+
+		// variants of the windows completed by the interrupted run
+		for (map<string,Variant_t>::iterator it=resumedDB.DB.begin(); it!=resumedDB.DB.end(); ++it) {
+			variantDB.addVar(it->second);
+		}
+
+		// variants gathered by the collector of the pipeline
+		if (pipeline != NULL) {
+			for (map<string,Variant_t>::iterator it=pipeline->db.DB.begin(); it!=pipeline->db.DB.end(); ++it) {
+				variantDB.addVar(it->second);
+			}
+			delete pipeline;
+		}
+
+		for( i=0; i < c.NUM_THREADS; ++i ) {
+
+			tot_skip += assemblers[i]->num_skip;
+			tot_split += assemblers[i]->num_split;
+			tot_resumed += assemblers[i]->num_resumed;
+			tot_deferred += assemblers[i]->num_deferred;
+			tot_budget_skip += assemblers[i]->num_budget_skip;
+			tot_downsampled += assemblers[i]->num_downsampled;
+			tot_svn_only += assemblers[i]->num_snv_only_regions;
+			tot_indel_only += assemblers[i]->num_indel_only_regions;
+			tot_softclip_only += assemblers[i]->num_softclip_only_regions;
+			tot_indel_or_softclip += assemblers[i]->num_indel_or_softclip_regions;
+			tot_snv_or_indel += assemblers[i]->num_snv_or_indel_regions;
+			tot_snv_or_softclip += assemblers[i]->num_snv_or_softclip_regions;
+			tot_snv_or_indel_or_softclip += assemblers[i]->num_snv_or_indel_or_softclip_regions;
+
+			map<string,Variant_t> & db = (assemblers[i]->vDB).DB;
+			map<string,Variant_t>::iterator it;
+			for (it=db.begin(); it!=db.end(); ++it) {
+				variantDB.addVar(it->second);
+			}
+		}
+
+		//if(verbose) {
+			cerr << "Total # of skipped windows: " << tot_skip << " (" << (100*(double)tot_skip/double(num_windows)) << "\%)" << endl;
+			cerr << "- # of windows with SNVs only: " << tot_svn_only << endl;
+			cerr << "- # of windows with indels only: " << tot_indel_only << endl;
+			cerr << "- # of windows with softclips only: " << tot_softclip_only << endl;
+			cerr << "- # of windows with indels or softclips: " << tot_indel_or_softclip << endl;
+			cerr << "- # of windows with SNVs or indels: " << tot_snv_or_indel << endl;
+			cerr << "- # of windows with SNVs or softclips: " << tot_snv_or_softclip << endl;
+			cerr << "- # of windows with SNVs or indels or softclips: " << tot_snv_or_indel_or_softclip << endl;
+			if(c.ADAPTIVE_WINDOWS) { cerr << "Total # of merged regions split into standard windows: " << tot_split << endl; }
+			if(c.RESUME) { cerr << "Total # of windows completed by the previous run: " << tot_resumed << endl; }
+			if(tot_downsampled > 0) { cerr << "Total # of windows downsampled to " << c.MAX_AVG_COV << "x: " << tot_downsampled << endl; }
+			if(c.WINDOW_BUDGET > 0) { cerr << "Total # of windows over the time budget: " << tot_deferred << " deferred, " << tot_budget_skip << " skipped" << endl; }
+		//}
+
+		// the variants of a shard are selected after merging all shards
+		if (c.NUM_SHARDS > 0) { variantDB.setShard(c.SHARD, c.NUM_SHARDS); }
+		else { variantDB.selectVar(); }
+
+		result.sample_name_tumor = assemblers[0]->sample_name_tumor;
+		result.sample_name_normal = assemblers[0]->sample_name_normal;
+		result.sample_name_extra = assemblers[0]->sample_name_extra;
+		result.num_windows = num_windows;
+		result.num_skip = tot_skip;
+		result.wall_time = wall_time;
+
+		for( i=0; i < c.NUM_THREADS; ++i ) { delete assemblers[i]; }
+	}
+	catch (int e) {
+		cerr << "An exception occurred. Exception Nr. " << e << endl;
+		return -1;
+	}
+
+	return 0;
+}
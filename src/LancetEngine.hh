@@ -0,0 +1,196 @@
+#ifndef LANCETENGINE_HH
+#define LANCETENGINE_HH 1
+
+/****************************************************************************
+** LancetEngine.hh
+**
+** Reentrant variant calling engine: the configuration lives in a
+** LancetConfig_t, the BAM headers, the FASTA index and the BAM indexes are
+** opened once by open() and, together with the BAM readers of the assembly
+** threads, reused by every call to run(), so a long-lived process can call
+** many region batches without global state
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <pthread.h>
+#include <time.h>
+
+#include "api/BamReader.h"
+
+#include "Microassembler.hh"
+#include "ActiveScan.hh"
+#include "RefProvider.hh"
+
+using namespace std;
+using namespace BamTools;
+
+// LancetConfig_t
+// configuration parameters of the engine (defaults of the command line tool)
+//////////////////////////////////////////////////////////////////////////
+class LancetConfig_t
+{
+public:
+
+	int NUM_THREADS;
+	int READER_THREADS; // reader threads in pipeline mode
+
+	bool LR_MODE; // linked-reads mode
+	bool XA_FILTER;
+	bool PRIMARY_ALIGNMENT_ONLY;
+	bool ACTIVE_REGIONS;
+	bool ACTIVE_SCAN; // pre-scan the BAMs for active regions
+	bool ADAPTIVE_WINDOWS; // merge the active windows into variable-size regions
+	bool RESUME; // skip the windows completed in the journal
+	bool COST_SCHEDULE; // assemble the most expensive windows first
+	bool INDEX_PRUNE; // drop the windows without alignments in the BAM indexes
+	bool NUMA_MODE; // pin the threads and split the windows across the NUMA nodes
+	bool PIPELINE_MODE; // separate reader, assembly and collector threads
+	bool HTSLIB; // read the BAM files with htslib (CRAM files always are)
+	int HTS_THREADS; // BGZF/CRAM decoding threads shared by all the readers (0 = none)
+	int BGZF_CACHE; // MB of inflated BGZF blocks shared by the bamtools readers (0 = off)
+	bool SHARED_INDEX; // load the .bai indexes once in memory for all the bamtools readers
+	bool verbose;
+	bool VERBOSE;
+	bool KMER_RECOVERY;
+	bool PRINT_ALL;
+	bool PRINT_DOT_READS;
+	int MIN_QV_TRIM;
+	int MIN_QV_CALL;
+	int QV_RANGE;
+	int MIN_MAP_QUAL;
+	int MAX_DELTA_AS_XS;
+	int WINDOW_SIZE;
+	double WINDOW_BUDGET; // max time (in seconds) spent on a window (0 = no limit)
+	double MIN_WINDOW_BYTES; // windows with less estimated compressed bytes of alignments are pruned
+	int PADDING;
+	int BED_MERGE_GAP; // max distance between padded BED intervals merged into one block (-1 = no merging)
+
+	string TUMOR;
+	vector<string> EXTRA_TUMORS; // other tumors of the same patient (multi-tumor mode)
+	string NORMAL;
+	string RG_FILE;
+	string REFFILE;
+	string ACTIVE_SCAN_CACHE; // cache file for the active-region pre-scan
+	string JOURNAL_FILE; // journal of the completed windows
+	string COMMAND_LINE; // reported in the VCF header
+
+	int minK;
+	int maxK;
+	int MAX_TIP_LEN;
+	unsigned int MIN_THREAD_READS;
+	int COV_THRESHOLD;
+	double MIN_COV_RATIO;
+	int LOW_COV_THRESHOLD;
+	int MAX_AVG_COV;
+	bool DOWNSAMPLE; // downsample the windows above MAX_AVG_COV (skipped otherwise)
+	int NODE_STRLEN;
+	int DFS_LIMIT;
+	int MAX_INDEL_LEN;
+	int MAX_MISMATCH;
+
+	//STR parameters
+	int MAX_UNIT_LEN;
+	int MIN_REPORT_UNITS;
+	int MIN_REPORT_LEN;
+	int DIST_FROM_STR;
+
+	int SHARD; // shard to process (1-based, 0 = whole input)
+	int NUM_SHARDS;
+
+	Filters filters; // filter thresholds
+
+	LancetConfig_t();
+
+	int minQualTrim() { return MIN_QV_TRIM + QV_RANGE; }
+	int minQualCall() { return MIN_QV_CALL + QV_RANGE; }
+	bool check();
+	string signature();
+};
+
+// LancetResult_t
+// variants and statistics of one run
+//////////////////////////////////////////////////////////////////////////
+class LancetResult_t
+{
+public:
+
+	VariantDB_t db; // variants of the tumor, or of all the tumors (selected, or sharded)
+
+	string sample_name_tumor;
+	string sample_name_normal;
+	vector<string> sample_name_extra; // other tumors (multi-tumor mode)
+
+	int num_windows; // windows assembled by the run
+	int num_skip; // windows without evidence of variation
+	double wall_time; // in seconds
+
+	LancetResult_t() : num_windows(0), num_skip(0), wall_time(0) { }
+};
+
+// called for every variant of a run in genomic order with its VCF record
+// (one column for each tumor in multi-tumor mode)
+typedef void (*VariantCallback_t)(const Variant_t & var, const string & record, void * data);
+
+class LancetEngine_t
+{
+public:
+
+	LancetEngine_t(const LancetConfig_t & cfg);
+	~LancetEngine_t();
+
+	bool open();
+	void close();
+	bool isOpen() { return is_open; }
+
+	LancetConfig_t & getConfig() { return config; }
+	RefVector & getReferences() { return references; }
+
+	int run(const string & region, const string & bedfile, LancetResult_t & result);
+	int run(const vector<string> & regions, const string & bedfile, LancetResult_t & result);
+	int run(const string & region, const string & bedfile, VariantCallback_t callback, void * data);
+	void printVCF(LancetResult_t & result, const string & version, ostream & out);
+
+private:
+
+	LancetConfig_t config;
+	bool is_open;
+	RefVector references; // reference sequences of the BAM headers
+	RefProvider_t reference; // FASTA index and mapped sequence shared by all the threads
+	CostModel_t model; // alignment bytes from the BAM indexes
+	bool indexed; // all the BAM indexes were read by the cost model
+	vector<AssemblerReaders_t *> thread_readers; // BAM readers of each assembly thread
+	ReaderOptions_t reader_opts; // backend of the alignment readers
+	htsThreadPool hts_pool; // decoding threads of the htslib readers
+	BamReaderCache * bam_cache; // BGZF blocks and indexes shared by the bamtools readers of the engine
+	pthread_mutex_t run_lock; // runs of the same engine are serialized
+
+	bool openInputs();
+	int loadRefs(const string region, WindowQueue_t &queue);
+	bool loadBed(const string bedfile, WindowQueue_t &queue);
+	int runAssembly(const vector<string> & regions, const string & bedfile, LancetResult_t & result);
+
+	static void* execute(void* ptr);
+};
+
+#endif
@@ -54,7 +54,7 @@ public:
 	CanonicalMer_t(Mer_t mer) 
 		{ set(mer); }
 
-	void set(string mer)
+	void set(const string & mer)
 	{
 		Mer_t rmer = rc2(mer);
 
@@ -66,16 +66,61 @@ string Microassembler::retriveSampleName(SamHeader &header) {
 	return sample_name;
 }
 
+// open a BAM file and its index (.bam.bai or .bai, or .crai with htslib)
+// with the backend selected by reader_opts
+//////////////////////////////////////////////////////////////////////////
+bool Microassembler::openReader(AlignmentReader_t & reader, const string & filename) {
+	
+	if ( !reader.open(filename, reader_opts) ) {
+		cerr << "Could not open BAM file " << filename << endl;
+		return false;
+	}
+	
+	if ( !reader.openIndex() ) {
+		cerr << "ERROR: index not found for BAM file " << filename << endl;
+		return false;
+	}
+	return true;
+}
+
+// open the BAM files of the tumor(s) and of the normal (one set per thread)
+//////////////////////////////////////////////////////////////////////////
+bool Microassembler::openReaders(AssemblerReaders_t & r) {
+	
+	r.close();
+	
+	if ( !openReader(r.readerT, TUMOR) ) { return false; }
+	SamHeader headerT = r.readerT.getHeader();
+	r.sample_name_tumor = retriveSampleName(headerT); // extract tumor sample name 
+	
+	if ( !openReader(r.readerN, NORMAL) ) { return false; }
+	SamHeader headerN = r.readerN.getHeader();
+	r.sample_name_normal = retriveSampleName(headerN); // extract normal sammple name
+	
+	for (unsigned int t = 0; t < EXTRA_TUMORS.size(); ++t) {
+		AlignmentReader_t * readerX = new AlignmentReader_t();
+		r.readersX.push_back(readerX);
+		if ( !openReader(*readerX, EXTRA_TUMORS[t]) ) { return false; }
+		SamHeader headerX = readerX->getHeader();
+		r.sample_name_extra.push_back(retriveSampleName(headerX));
+	}
+	
+	r.is_open = true;
+	return true;
+}
+
 
 // processGraph
 //////////////////////////////////////////////////////////////////////////
 
-int Microassembler::processGraph(Graph_t & g, const string & refname, int minkmer, int maxkmer)
+int Microassembler::processGraph(Graph_t & g, Ref_t * refinfo, int minkmer, int maxkmer)
 {	
 	int numreads = 0;
 
-	if (refname != "")
+	if (refinfo != NULL)
 	{
+		string refname = refinfo->hdr;
+
 		++graphCnt;
 		//VERBOSE = false;
 		
@@ -92,21 +137,16 @@ int Microassembler::processGraph(Graph_t & g, const string & refname, int minkme
 			<< endl;
 			cerr << "=====================================================" << endl;
 		}
-		// Load the reference
-		map<string, Ref_t *>::iterator ri = reftable->find(refname);
-		if (ri == reftable->end())
-		{
-			cerr << "Can't find ref info for: " << refname << endl;
-			exit(1);
-		}
-		Ref_t * refinfo = ri->second;
-		
 		bool rptInRef = false;
 		bool rptInQry = false;
 		bool cycleInGraph = false;
 
 		// dinamic kmer mode
 		for (int k=minkmer; k<=maxkmer; k+=2) {
+			
+			// stop if the window ran out of time
+			if (overBudget()) { break; }
+			
 			g.setK(k);
 			refinfo->setK(k);
 			
@@ -167,6 +207,8 @@ int Microassembler::processGraph(Graph_t & g, const string & refname, int minkme
 				
 				if(verbose) { g.printStats(c); }
 				
+				if (overBudget()) { g.clear(false); break; }
+				
 				// mark source and sink
 				g.markRefEnds(refinfo, c);
 			
@@ -197,11 +239,15 @@ int Microassembler::processGraph(Graph_t & g, const string & refname, int minkme
 				g.removeShortLinks(c);
 				if (PRINT_ALL) { g.printDot(out_prefix + ".5s.c" + comp + ".dot",c); }
 				
+				if (overBudget()) { g.clear(false); break; }
+				
 				// skip analysis if there is a cycle in the graph 
 				if (g.hasCycle()) { g.clear(false); cycleInGraph = true; break; }
 
 				// skip analysis if there is a perfect or near-perfect repeat in the graph paths			
 				if(g.hasRepeatsInGraphPaths(refinfo)) { g.clear(false); rptInQry = true; break; }
+				
+				if (overBudget()) { g.clear(false); break; }
 			
 				// Thread reads
 				// BUG: threding is off because creates problems if the the bubble is not covered (end-to-end) 
@@ -229,11 +275,14 @@ int Microassembler::processGraph(Graph_t & g, const string & refname, int minkme
 				if (PRINT_ALL) { g.printDot(out_prefix + ".final.c" + comp + ".dot",c); }				
 			}
 			
-			if (rptInQry || cycleInGraph) { continue; }
+			if ( (rptInQry || cycleInGraph) && !budget_exceeded ) { continue; }
 			
 			break; // break loop if graph has been processed correctly
 		}
 		
+		// the graph could not be processed for any k
+		graph_failed = !budget_exceeded && (rptInRef || rptInQry || cycleInGraph);
+		
 		// clear graph at the end.
 		g.clear(true);
 		
@@ -249,209 +298,22 @@ int Microassembler::processGraph(Graph_t & g, const string & refname, int minkme
 }
 
 
-// isActiveRegion
-// Examines reads alignments (CIGAR and MD) to find evidence of mutations
-// returns true if there is evidence of mutation in the region
-bool Microassembler::isActiveRegion(BamReader &reader, Ref_t *refinfo, BamRegion &region, int code) {
-	
-	// iterate through all alignments
-	int MIN_EVIDENCE = filters->minAltCntTumor; // min evidence equal to min support for somatic variant
-	BamAlignment al;
-	int totalreadbp = 0;
-	bool ans = false;
-	bool flag = false;
-	int MQ = MIN_MAP_QUAL;
-	string CIGAR = "";
-	string rg = "";
-	string md = "";
-	
-	vector< int > clipSizes;
-	vector< int > readPositions; 
-	vector< int > genomePositions;
-
-    map<int,int> mapX; // table with counts of all mismatches at a given locus	
-    map<int,int> mapI; // table with counts of all insertions at a given locus	
-    map<int,int> mapD; // table with counts of all deletion at a given locus	
-    map<int,int> mapSC; // table with counts of all softclipped sequences starting at a given locus
-    map<int,int>::iterator mit;
-	
-	// more sensitive in normal (extract all reads)
-	if (code == NML) { MQ = 0; }
-	
-	/*** TUMOR ****/
-	//while ( reader.GetNextAlignment(al) ) { // get next alignment and populate the alignment's string data fields
-	while ( reader.GetNextAlignmentCore(al) ) { // get next alignment and populate the alignment's string data fields
-		
-		int alstart = al.Position;
-		int alend = al.GetEndPosition();
-		if( (alstart < region.LeftPosition) || (alend > region.RightPosition) ) { continue; } // skip alignments outside region
-		
-		if ( (al.MapQuality >= MQ) && !al.IsDuplicate() ) { // only keep reads with high map quality and skip PCR duplicates
-			
-			al.BuildCharData(); // Populates alignment string fields (read name, bases, qualities, tag data)
-			
-			if( (al.QueryBases).empty() || (al.Qualities).empty() ) { continue; } // skip alignments with undefined sequence or qualities
-			
-			al.GetTag("RG", rg); // get the read group information for the read
-			if(rg.empty()) { rg = "null"; }
-			
-			if( (al.QueryBases).length() != (al.Qualities).length() ) { 
-				cerr << "WARNING: inconsistent length between read sequence (L=" << (al.QueryBases).length() << ") and base qualities (L=" << (al.Qualities).length() << ")" << endl; 
-			}
-			
-			if ( (readgroups.find("null") != readgroups.end())  || (readgroups.find(rg) != readgroups.end()) ) { // select reads in the read group RG
-				
-				// parse MD string
-				// String for mismatching positions. Regex : [0-9]+(([A-Z]|\^[A-Z]+)[0-9]+)*10
-				flag = al.GetTag("MD", md); // get string of mismatching positions
-				//cerr << "MD: " << md << " alstart: " << alstart << " Q: " << al.Qualities << " MinQ " << MIN_QUAL_CALL << endl;
-				if(flag==true) { parseMD(md, mapX, alstart, al.Qualities, MIN_QUAL_CALL); }
-				
-				// add SNV to database
-				//Variant_t(string chr_, int pos_, string ref_, string alt_, int ref_cov_normal_, int ref_cov_tumor_, int alt_cov_normal_fwd_, int alt_cov_normal_rev_, int alt_cov_tumor_fwd_, int alt_cov_tumor_rev_, char prev_bp_ref_, char prev_bp_alt_, Filters &fs)
-				
-				// example: 31M1I17M1D37M
-				CIGAR = "";
-				int pos = alstart; // initialize position to start of alignment
-				for (std::vector<CigarOp>::iterator it = (al.CigarData).begin() ; it != (al.CigarData).end(); ++it) {
-					char T = (*it).Type;
-					
-					// update position (except for insertions)
-					if(T!='I') { pos += (*it).Length; }
-					
-					if(T=='X') {
-						//cerr << "X:" << pos << "|";
-						mit = mapX.find(pos);
-						if (mit != mapX.end()) { ++((*mit).second); }
-						else { mapX.insert(std::pair<int,int>(pos,1)); }
-					}
-					if(T=='I') {
-						//cerr << "I:" << pos << "|";
-						mit = mapI.find(pos);
-						if (mit != mapI.end()) { ++((*mit).second); }
-						else { mapI.insert(std::pair<int,int>(pos,1)); }
-					}
-					if(T=='D') {
-						//cerr << "D:" << pos << "|";
-						mit = mapD.find(pos);
-						if (mit != mapD.end()) { ++((*mit).second); }
-						else { mapD.insert(std::pair<int,int>(pos,1)); }
-					}
-					
-					std::stringstream ss;
-					ss << (*it).Length;
-					CIGAR += ss.str();
-					CIGAR += (*it).Type;
-					//cerr << "CIGAR: " << CIGAR << endl;
-				}
-				//cerr << endl;
-				
-				int len = al.Length;
-				totalreadbp += len;
-				
-				clipSizes.clear();
-				readPositions.clear();
-				genomePositions.clear();
-				
-				if(al.GetSoftClips(clipSizes, readPositions, genomePositions)) {
-					//cerr << CIGAR << " MD:" << md << " START:" << alstart << " ";
-					for (std::vector<int>::iterator it = genomePositions.begin() ; it != genomePositions.end(); ++it) {
-						//cerr << (*it) << " ";
-						mit = mapSC.find((*it));
-						if (mit != mapSC.end()) { ++((*mit).second); }
-						else { mapSC.insert(std::pair<int,int>((*it),1)); }
-					}
-				}
-				//cerr << endl;
-			}
-		}
-	}
-
-	// check for any locus with evidence for SNVs, indel, or soft-clipped sequences	
-	bool snv_evidence = false;
-	bool indel_evidence = false;
-	bool softclip_evidence = false;
-	
-	//cerr << "X: ";
-    for (mit=mapX.begin(); mit!=mapX.end(); ++mit) {
-		if((*mit).second >= MIN_EVIDENCE) { 
-			//cerr << (*mit).first << "," << (*mit).second << "|";
-			snv_evidence = true;
-			ans = true; 
-			break; 
-		}
-	}
-	//cerr << endl;
-	
-	//cerr << "I: ";
-    for (mit=mapI.begin(); mit!=mapI.end(); ++mit) {
-		if((*mit).second >= MIN_EVIDENCE) { 
-			//cerr << (*mit).first << "," << (*mit).second << "|";
-			indel_evidence = true;
-			ans = true; 
-			break; 
-		}
-	}
-	//cerr << endl;
-	
-	//cerr << "D: ";
-    for (mit=mapD.begin(); mit!=mapD.end(); ++mit) {
-		if((*mit).second >= MIN_EVIDENCE) { 
-			//cerr << (*mit).first << "," << (*mit).second << "|";
-			indel_evidence = true;
-			ans = true; 
-			break;
-		}
-	}
-	//cerr << endl;
-	
-	//cerr << "S: ";
-    for (mit=mapSC.begin(); mit!=mapSC.end(); ++mit) {
-		if((*mit).second >= MIN_EVIDENCE) { 
-			//cerr << (*mit).first << "," << (*mit).second << "|";
-			softclip_evidence = true;
-			ans = true; 
-			break; 
-		}
-	}
-	//cerr << endl;
-	
-	if(code == TMR) {
-		if(snv_evidence && !indel_evidence && !softclip_evidence)   { ++num_snv_only_regions; /*ans = false*/; }
-		if(!snv_evidence && indel_evidence && !softclip_evidence)   { ++num_indel_only_regions; }
-		if(!snv_evidence && !indel_evidence && softclip_evidence)   { ++num_softclip_only_regions; }
-		if(!snv_evidence && (indel_evidence || softclip_evidence))  { ++num_indel_or_softclip_regions; }	
-		if((snv_evidence || indel_evidence) && !softclip_evidence)  { ++num_snv_or_indel_regions; }	
-		if((snv_evidence || softclip_evidence) && !indel_evidence)  { ++num_snv_or_softclip_regions; }	
-		if(snv_evidence || indel_evidence || softclip_evidence)     { ++num_snv_or_indel_or_softclip_regions; }
-	}
-
-	if(!snv_evidence && !indel_evidence && !softclip_evidence) { ans = false; }
-	
-	return ans;
-}
-
-// extract the reads from BAM file
-// return false if the region could not be analyzed (e.g., too much coverage)
-bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo, BamRegion &region, int &readcnt, int code) {
-	
-	if(verbose) { 
-		if(code == TMR) { cerr << "Extract reads from tumor" << endl; }
-		if(code == NML) { cerr << "Extract reads from normal" << endl; }
-	}
+// scanReads
+// scan the alignments of the window once (for one sample):
+// collect evidence of mutations from CIGAR and MD (if the active region module is on)
+// and select the reads to be used for the assembly (downsampled to MAX_AVG_COV)
+//////////////////////////////////////////////////////////////
+void Microassembler::scanReads(ReadBuffer_t &buffer, Ref_t *refinfo, BamRegion &region, WindowReads_t &scan, int code) {
 	
-	string sampleType;	
-	if(code == TMR) { sampleType = "tumor";  }
-	if(code == NML) { sampleType = "normal"; }
+	scan.clear();
+	if (DOWNSAMPLE) { scan.maxreadbp = (long)MAX_AVG_COV * (long)refinfo->rawseq.length(); }
 	
 	double CLIP_PRC = 0.5; // percent of soft-clipped bases in alignment
-	//double MAX_PRC_HIGH_CLIP_READS = 30; // max percent of reads with high soft-clipping rate (>CLIP_PRC)
 	int MIN_XM = 5;
 	int MIN_DELTA = MAX_DELTA_AS_XS; // min difference for AS and XS tags (AS-XS)
 	
-	// iterate through all alignments
-	//int num_PCR_duplicates = 0;
-	BamAlignment al;
+	int MQ = MIN_MAP_QUAL;
+	string ev_rg = "";
 	string rg = "";
 	string xt = "";	
 	string xa = "";
@@ -461,44 +323,55 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 	int nm = 0;
 	float as = -1; 
 	float xs = -1; 
-	
-	int num_unmapped = 0;
-	int num_XA_read = 0;
-	int num_XT_R_read = 0;
-	int num_XT_M_read = 0;
-	int num_high_softclip_read = 0;
-	int num_high_XM_read = 0;
-	int num_equal_AS_XS_read = 0;
-	
-	int tot_reads_window = 0;
-	int totalreadbp = 0;
 	double avgcov = 0.0;
-	int MQ = MIN_MAP_QUAL;
-	bool skip = false;
 	
 	// softclipping variables
-	std::vector< int > clipSizes;
-	std::vector< int > readPositions; 
-	std::vector< int > genomePositions;
+	vector< int > clipSizes;
+	vector< int > readPositions; 
+	vector< int > genomePositions;
 	
 	// more sensitive in normal (extract all reads)
 	if (code == NML) { MQ = 0; MIN_DELTA = -1; }
+	
+	for (deque<BufferedRead_t>::iterator rit = buffer.reads.begin(); rit != buffer.reads.end(); ++rit) { // alignments overlapping the window
 		
-	/*** TUMOR ****/
-	//while ( reader.GetNextAlignment(al) ) { // get next alignment and populate the alignment's string data fields
-	while ( reader.GetNextAlignmentCore(al) ) { // get next alignment and populate the alignment's string data fields
+		if( !buffer.inWindow(*rit) ) { continue; }
+		BamAlignment & al = (*rit).al;
 		
-		avgcov = ((double) totalreadbp) / ((double)refinfo->rawseq.length());
-		if(avgcov > MAX_AVG_COV) { 
-			cerr << "WARNING: Skip region " << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << ". Too much coverage (>" << MAX_AVG_COV << "x)." << endl;
-			skip = true;
-			break;
+		// stop selecting reads if the coverage is too high (without downsampling)
+		if(!scan.skip && !DOWNSAMPLE) {
+			avgcov = ((double) scan.totalreadbp) / ((double)refinfo->rawseq.length());
+			if(avgcov > MAX_AVG_COV) { scan.skip = true; }
 		}
+		if(scan.skip && !ACTIVE_REGION_MODULE) { break; }
 		
 		int alstart = al.Position;
-		int alend = al.GetEndPosition();
+		int alend = (*rit).end;
 		if( (alstart < region.LeftPosition) || (alend > region.RightPosition) ) { continue; } // skip alignments outside region
 		
+		/*** EVIDENCE ****/
+		if ( ACTIVE_REGION_MODULE && (al.MapQuality >= MQ) && !al.IsDuplicate() ) { // only keep reads with high map quality and skip PCR duplicates
+			
+			al.BuildCharData(); // Populates alignment string fields (read name, bases, qualities, tag data)
+			
+			if( !(al.QueryBases).empty() && !(al.Qualities).empty() ) { // skip alignments with undefined sequence or qualities
+			
+				al.GetTag("RG", ev_rg); // get the read group information for the read
+				if(ev_rg.empty()) { ev_rg = "null"; }
+			
+				if( (al.QueryBases).length() != (al.Qualities).length() ) { 
+					cerr << "WARNING: inconsistent length between read sequence (L=" << (al.QueryBases).length() << ") and base qualities (L=" << (al.Qualities).length() << ")" << endl; 
+				}
+			
+				if ( (readgroups.find("null") != readgroups.end())  || (readgroups.find(ev_rg) != readgroups.end()) ) { // select reads in the read group RG
+					collectEvidence(al, scan.mapX, scan.mapI, scan.mapD, scan.mapSC, MIN_QUAL_CALL);
+				}
+			}
+		}
+		
+		/*** SELECTION ****/
+		if(scan.skip) { continue; }
+		
 		if( PRIMARY_ALIGNMENT_ONLY && !al.IsPrimaryAlignment() ) { continue; } // skip secondary alignments
 		
 		if ( (al.MapQuality >= MQ) && !al.IsDuplicate() ) { // only keep reads with high map quality and skip PCR duplicates
@@ -511,13 +384,6 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			if(al.IsSecondMate()) { mate = 2; }
 			if(al.IsReverseStrand()) { strand = REV; }
 			
-			/*
-			// get original base quality scores
-			string oq;
-			al.GetTag("OQ", oq); 
-			cerr << oq << endl;
-			*/
-			
 			// extract AS and XS tags (available in bwa-mem , not in bwa-aln)
 			as = -1; xs = -1;
 			
@@ -525,20 +391,12 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			xs = extract_sam_tag("XS", al);
 			float delta = abs(as-xs);
 			
-			/*
-			char T;
-			al.GetTagType("AS", T);
-			cerr << al.Name << " " <<  as << " " << xs << " " << T << endl;
-			*/
-			
-			//if( as==xs && as!=-1 && xs!=-1 ) { ++num_equal_AS_XS_read; continue; } // skip alignments with equal score for AS and XS
-			if( (delta <= MIN_DELTA) && as!=-1 && xs!=-1 ) { ++num_equal_AS_XS_read; continue; } // skip alignments where AS and XS are very close
+			if( (delta <= MIN_DELTA) && as!=-1 && xs!=-1 ) { ++scan.num_equal_AS_XS_read; continue; } // skip alignments where AS and XS are very close
 			
 			// XM	Number of mismatches in the alignment
 			nm = 0;
 			nm = extract_sam_tag("XM", al);
-			//al.GetTag("XM", nm); // get the XM tag for the read
-			if(nm >= MIN_XM) { ++num_high_XM_read; /*continue;*/ } // skip alignments with too many mis-matches
+			if(nm >= MIN_XM) { ++scan.num_high_XM_read; /*continue;*/ } // skip alignments with too many mis-matches
 			
 			// XT type: Unique/Repeat/N/Mate-sw
 			//
@@ -552,16 +410,13 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			al.GetTag("XT", xt); // get the XT tag for the read
 			if(xt.empty()) { xt = "null"; }
 			if(xt == "R") { 
-				++num_XT_R_read; 
+				++scan.num_XT_R_read; 
 				if (code != NML) { // keep all reads in the normal, apply repeat filter only to tumor
 					continue; // skip alignments which are marked XT:R
 				}
 			}
 			if(xt == "M") { 
-				++num_XT_M_read; 
-				//if (code != NML) { // keep all reads in the normal, apply repeat filter only to tumor
-					/*continue;*/  // skip alignments which are marked XT:M
-				//}
+				++scan.num_XT_M_read; 
 			}
 		
 			// XA  
@@ -571,25 +426,21 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			al.GetTag("XA", xa); // get the XA for the read
 			if(xa.empty()) { xa = "null"; }
 			if(xa != "null") {
-				//cerr << al.Name << "\t" << xa << endl;
-				++num_XA_read; 
+				++scan.num_XA_read; 
 				if (code != NML && XA_FILTER) { // keep all reads in the normal, apply repeat filter only to tumor
 					continue; // skip alignments with alternative hits
 				}
 			}
 			
 			// 10x linked-read data
+			bx = "";
+			hp = 0;
 			if(LR_MODE) { 
-				bx = "";
 				al.GetTag("BX", bx); // get the BX barcode for the read
 				if(bx.empty()) { bx = "null"; }
-				//cerr << "BX=" << bx << endl; 
 				
-				hp = 0;
 				hp = extract_sam_tag("HP", al);
 				if(hp == -1) { hp = 0; }
-				//al.GetTag("HP", hp); // get the HP haplotype number assigned to each read
-				//if(hp.empty()) { hp = -1; }
 			}
 			
 			// clear arrays (otherwise they keep growing from previous alignment that are parsed) 
@@ -601,12 +452,10 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			if(al.GetSoftClips(clipSizes, readPositions, genomePositions)) {		
 				int numSoftClipBases = 0;
 				for (vector<int>::iterator it = clipSizes.begin() ; it != clipSizes.end(); ++it) {
-					//cerr << (*it) << " " << al.Length << " " << prc_sc << endl;
 					numSoftClipBases += (*it);
 				}
-				//cerr << "Nun SC bp: " << numSoftClipBases << endl;
 				double prc_sc = (double)(numSoftClipBases)/(double)al.Length;
-				if(prc_sc >= CLIP_PRC) { ++num_high_softclip_read; /*break;*/ }
+				if(prc_sc >= CLIP_PRC) { ++scan.num_high_softclip_read; }
 			}
 									
 			rg = "";
@@ -615,102 +464,324 @@ bool Microassembler::extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo,
 			
 			if ( (readgroups.find("null") != readgroups.end())  || (readgroups.find(rg) != readgroups.end()) ) { // select reads in the read group RG
 				
-				if( !(al.IsMapped()) ) { // unmapped read
-					g.addAlignment(sampleType, al.Name, al.QueryBases, al.Qualities, mate, Graph_t::CODE_BASTARD, code, strand, bx, hp);
-					//g.addpaired("tumor", al.Name, al.QueryBases, oq, mate, Graph_t::CODE_BASTARD, code, strand);
-					++num_unmapped; 
-				}
-				else { // mapped reads
-					g.addAlignment(sampleType, al.Name, al.QueryBases, al.Qualities, mate, Graph_t::CODE_MAPPED, code, strand, bx, hp);								
-					//g.addpaired("tumor", al.Name, al.QueryBases, oq, mate, Graph_t::CODE_MAPPED, code, strand);								
-				}
-				//cout << al.Name << endl;
-				++readcnt; ++tot_reads_window;
-				totalreadbp += (al.QueryBases).length();
+				scan.add(SelectedRead_t(&al, mate, strand, al.IsMapped(), bx, hp, SelectedRead_t::nameKey(al.Name), scan.tot_reads_window, (al.QueryBases).length()));
+				if( !(al.IsMapped()) ) { ++scan.num_unmapped; } // unmapped read
 				
-				//void addMates(ReadId_t r1, ReadId_t r2)
-				//{
-				//g.readid2info[r1].mateid_m = r2;
-				//g.readid2info[r2].mateid_m = r1;
-				//}
+				++scan.tot_reads_window;
 			}
 		}
-		//else{ num_PCR_duplicates++; }
+	}
+	
+	scan.finish();
+}
+
+// Examines the evidence of mutations collected from the reads alignments (CIGAR and MD)
+// returns true if there is evidence of mutation in the region
+//////////////////////////////////////////////////////////////
+bool Microassembler::isActiveRegion(WindowReads_t &scan, int code) {
+	
+	int MIN_EVIDENCE = filters->minAltCntTumor; // min evidence equal to min support for somatic variant
+	bool ans = false;
+	map<int,int> & mapX = scan.mapX;
+	map<int,int> & mapI = scan.mapI;
+	map<int,int> & mapD = scan.mapD;
+	map<int,int> & mapSC = scan.mapSC;
+	map<int,int>::iterator mit;
+	
+	// check for any locus with evidence for SNVs, indel, or soft-clipped sequences	
+	bool snv_evidence = false;
+	bool indel_evidence = false;
+	bool softclip_evidence = false;
+	
+	//cerr << "X: ";
+    for (mit=mapX.begin(); mit!=mapX.end(); ++mit) {
+		if((*mit).second >= MIN_EVIDENCE) { 
+			//cerr << (*mit).first << "," << (*mit).second << "|";
+			snv_evidence = true;
+			ans = true; 
+			break; 
+		}
+	}
+	//cerr << endl;
+	
+	//cerr << "I: ";
+    for (mit=mapI.begin(); mit!=mapI.end(); ++mit) {
+		if((*mit).second >= MIN_EVIDENCE) { 
+			//cerr << (*mit).first << "," << (*mit).second << "|";
+			indel_evidence = true;
+			ans = true; 
+			break; 
+		}
+	}
+	//cerr << endl;
+	
+	//cerr << "D: ";
+    for (mit=mapD.begin(); mit!=mapD.end(); ++mit) {
+		if((*mit).second >= MIN_EVIDENCE) { 
+			//cerr << (*mit).first << "," << (*mit).second << "|";
+			indel_evidence = true;
+			ans = true; 
+			break;
+		}
+	}
+	//cerr << endl;
+	
+	//cerr << "S: ";
+    for (mit=mapSC.begin(); mit!=mapSC.end(); ++mit) {
+		if((*mit).second >= MIN_EVIDENCE) { 
+			//cerr << (*mit).first << "," << (*mit).second << "|";
+			softclip_evidence = true;
+			ans = true; 
+			break; 
+		}
+	}
+	//cerr << endl;
+	
+	if(code == TMR) {
+		if(snv_evidence && !indel_evidence && !softclip_evidence)   { ++num_snv_only_regions; /*ans = false*/; }
+		if(!snv_evidence && indel_evidence && !softclip_evidence)   { ++num_indel_only_regions; }
+		if(!snv_evidence && !indel_evidence && softclip_evidence)   { ++num_softclip_only_regions; }
+		if(!snv_evidence && (indel_evidence || softclip_evidence))  { ++num_indel_or_softclip_regions; }	
+		if((snv_evidence || indel_evidence) && !softclip_evidence)  { ++num_snv_or_indel_regions; }	
+		if((snv_evidence || softclip_evidence) && !indel_evidence)  { ++num_snv_or_softclip_regions; }	
+		if(snv_evidence || indel_evidence || softclip_evidence)     { ++num_snv_or_indel_or_softclip_regions; }
+	}
+
+	if(!snv_evidence && !indel_evidence && !softclip_evidence) { ans = false; }
+	
+	return ans;
+}
+
+// load the selected reads in the graph (tumor is the index of the tumor in multi-tumor mode)
+// return false if the region could not be analyzed (e.g., too much coverage)
+//////////////////////////////////////////////////////////////
+bool Microassembler::extractReads(WindowReads_t &scan, Graph_t &g, Ref_t *refinfo, int &readcnt, int code, int tumor) {
+	
+	if(verbose) { 
+		if(code == TMR) { cerr << "Extract reads from tumor" << endl; }
+		if(code == NML) { cerr << "Extract reads from normal" << endl; }
+	}
+	
+	string sampleType;	
+	if(code == TMR) { sampleType = "tumor";  }
+	if(code == NML) { sampleType = "normal"; }
+	
+	double CLIP_PRC = 0.5; // percent of soft-clipped bases in alignment
+	int MIN_XM = 5;
+	int MIN_DELTA = MAX_DELTA_AS_XS; // min difference for AS and XS tags (AS-XS)
+	if (code == NML) { MIN_DELTA = -1; }
+	
+	int label = code;
+	if (tumor >= 0) { label = SMP + tumor; } // own colour of the tumor (multi-tumor mode)
+	
+	if(scan.skip) { 
+		cerr << "WARNING: Skip region " << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << ". Too much coverage (>" << MAX_AVG_COV << "x)." << endl;
+	}
+	if(scan.downsampled && verbose) {
+		cerr << "Downsampled " << sampleType << " to " << MAX_AVG_COV << "x: " << scan.num_downsampled << " of " << scan.tot_reads_window << " reads dropped" << endl;
+	}
+	
+	for (vector<SelectedRead_t>::iterator it = scan.reads.begin(); it != scan.reads.end(); ++it) {
+		
+		BamAlignment & al = *((*it).al);
+		
+		if( !((*it).mapped) ) { // unmapped read
+			g.addAlignment(sampleType, al.Name, al.QueryBases, al.Qualities, (*it).mate, Graph_t::CODE_BASTARD, label, (*it).strand, (*it).bx, (*it).hp);
+		}
+		else { // mapped reads
+			g.addAlignment(sampleType, al.Name, al.QueryBases, al.Qualities, (*it).mate, Graph_t::CODE_MAPPED, label, (*it).strand, (*it).bx, (*it).hp);
+		}
+		++readcnt;
 	}
 	
 	// compute percentage of reads having high sofclipping rate (>CLIP_PRC)
-	double prc_high_clippied_reads = 100*((double)num_high_softclip_read/(double)tot_reads_window);
-	//if(prc_high_clippied_reads > MAX_PRC_HIGH_CLIP_READS) { skip = true; }
+	double prc_high_clippied_reads = 100*((double)scan.num_high_softclip_read/(double)scan.tot_reads_window);
 	
 	if(verbose) {
-		cerr << "Num reads marked as repeat (XT:A:R tag): " << num_XT_R_read << endl;
-		cerr << "Num reads marked as Mate-sw (XT:A:M tag): " << num_XT_M_read << endl;
-		cerr << "Num reads with alternative hits (XA tag): " << num_XA_read << endl;
-		cerr << "Num reads with >=" << (100*CLIP_PRC) << "\% soft-clipping: " << num_high_softclip_read << "(" << prc_high_clippied_reads << "%)" << endl;
-		cerr << "Num reads with >=" << MIN_XM << " mis-matches: " << num_high_XM_read << endl;
-		cerr << "Num reads with |AS-XS|<=" << MIN_DELTA << ": " << num_equal_AS_XS_read << endl;
+		cerr << "Num reads marked as repeat (XT:A:R tag): " << scan.num_XT_R_read << endl;
+		cerr << "Num reads marked as Mate-sw (XT:A:M tag): " << scan.num_XT_M_read << endl;
+		cerr << "Num reads with alternative hits (XA tag): " << scan.num_XA_read << endl;
+		cerr << "Num reads with >=" << (100*CLIP_PRC) << "\% soft-clipping: " << scan.num_high_softclip_read << "(" << prc_high_clippied_reads << "%)" << endl;
+		cerr << "Num reads with >=" << MIN_XM << " mis-matches: " << scan.num_high_XM_read << endl;
+		cerr << "Num reads with |AS-XS|<=" << MIN_DELTA << ": " << scan.num_equal_AS_XS_read << endl;
 	}
 	
-	return skip;
+	return scan.skip;
 }
 
-// extract the reads from BAMs and process them
-int Microassembler::processReads() {
+// process one window: scan the reads, check if the region is active and assemble it
+// returns the number of reads in the graph (-1 if the BAM region is not reachable)
+//////////////////////////////////////////////////////////////
+int Microassembler::processWindow(Ref_t * refinfo, Graph_t & g, ReadBuffer_t & bufferT, ReadBuffer_t & bufferN, int & readcnt) {
 	
-	struct timespec start, finish;
-	double elapsed;
-	clock_gettime(CLOCK_MONOTONIC, &start);
+	BamRegion region;
+	int numreads_g = 0;
+	graph_failed = false;
 	
-	cerr << "Process reads" << endl;
+	// continue if the region has only Ns or prefect repeat of size maxK
+	if(isNseq(refinfo->rawseq)) { return 0; } 
+	if(isRepeat(refinfo->rawseq, maxK)) { return 0; } 
+
+	region.LeftRefID = refinfo->refid; // readerT.GetReferenceID(refinfo->refchr);
+	region.RightRefID = refinfo->refid; // readerT.GetReferenceID(refinfo->refchr);
+	region.LeftPosition = refinfo->refstart;
+	region.RightPosition = refinfo->refend;
+	//cout << "region = " << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << endl; 
+
+	bool jumpT = bufferT.setWindow(region);
+	if(!jumpT) {
+		cerr << "Error: not able to jump successfully to the region's left boundary in tumor" << endl;
+		return -1;
+	}
+
+	bool jumpN = bufferN.setWindow(region);
+	if(!jumpN) {
+		cerr << "Error: not able to jump successfully to the region's left boundary in normal" << endl;
+		return -1;
+	}
+
+	// single pass over the reads of each sample
+	scanReads(bufferT, refinfo, region, readsT, TMR);
+	scanReads(bufferN, refinfo, region, readsN, NML);
 	
-	// Process the reads
-	BamReader readerT;
-	SamHeader headerT;
+	// multi-tumor mode: the other tumors of the same patient
+	for (unsigned int t = 0; t < extraT.size(); ++t) {
+		if(!extraT[t]->setWindow(region)) {
+			cerr << "Error: not able to jump successfully to the region's left boundary in tumor " << EXTRA_TUMORS[t] << endl;
+			return -1;
+		}
+		scanReads(*extraT[t], refinfo, region, readsX[t], TMR);
+	}
+
+	bool activeT = true;
+	bool activeN = true;
+
+	if (ACTIVE_REGION_MODULE) {
+		activeT = isActiveRegion(readsT, TMR);
+		activeN = isActiveRegion(readsN, NML);
+		for (unsigned int t = 0; t < extraT.size(); ++t) {
+			if(isActiveRegion(readsX[t], TMR)) { activeT = true; }
+		}
+	}
 
-	BamReader readerN;	
-	SamHeader headerN;
+	if(activeT || activeN){
+	
+		// all the tumors go in the same graph as the normal, each one with
+		// its own colour in multi-tumor mode (and pooled as the tumor colour)
+		int tumor = extraT.empty() ? -1 : 0;
+		bool skipT = extractReads(readsT, g, refinfo, readcnt, TMR, tumor);
+		bool downsampled = readsT.downsampled;
+		for (unsigned int t = 0; t < extraT.size(); ++t) {
+			if(extractReads(readsX[t], g, refinfo, readcnt, TMR, t+1)) { skipT = true; }
+			if(readsX[t].downsampled) { downsampled = true; }
+		}
+		bool skipN = extractReads(readsN, g, refinfo, readcnt, NML);
+		if(downsampled || readsN.downsampled) { ++num_downsampled; }
 	
-	string index_filename;
-	bool index_found = false;
+		if(!skipT && !skipN) { 
+			numreads_g = processGraph(g, refinfo, minK, maxK);
+			//processGraph(g, refinfo, minK, maxK);
 		
-	// attempt to open our BamMultiReader
-	if ( !readerT.Open(TUMOR) ) {
-		cerr << "Could not open tumor BAM files." << endl;
-		return -1;
+		}
+		else { ++num_skip; g.clear(true); }
+	}
+	else {
+		++num_skip;
+		if(verbose) { cerr << "Skip region: not enough evidence for variation." << endl; }
 	}
-	// retrieve 'metadata' from BAM files, these are required by BamWriter
-	headerT = readerT.GetHeader();
 	
-	index_found = readerT.LocateIndex(); // locate and load BAM index file (.bam.bai)
-	if(!index_found) {
-		index_filename = GetBaseFilename(TUMOR.c_str())+".bai";
-		index_found = readerT.OpenIndex(index_filename); //try with different extension .bai
-		if(!index_found) {
-			cerr << "ERROR: index not found for BAM file " << TUMOR << endl;
-			exit(1);
+	return numreads_g;
+}
+
+// start the time budget of a new window (0 = no limit)
+//////////////////////////////////////////////////////////////
+void Microassembler::startBudget(double budget) {
+
+	window_budget = budget;
+	budget_exceeded = false;
+	clock_gettime(CLOCK_MONOTONIC, &window_start);
+}
+
+// check if the current window exceeded its time budget
+//////////////////////////////////////////////////////////////
+bool Microassembler::overBudget() {
+
+	if(window_budget <= 0) { return false; }
+	if(budget_exceeded) { return true; }
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double elapsed = (now.tv_sec - window_start.tv_sec);
+	elapsed += (now.tv_nsec - window_start.tv_nsec) / 1000000000.0;
+
+	budget_exceeded = (elapsed > window_budget);
+	return budget_exceeded;
+}
+
+// assemble a window within the time budget (0 = no limit)
+// merged regions that cannot be assembled are split into standard windows
+// returns the number of reads in the graph (-1 if the BAM region is not reachable)
+//////////////////////////////////////////////////////////////
+int Microassembler::assembleWindow(Ref_t * refinfo, Graph_t & g, ReadBuffer_t & bufferT, ReadBuffer_t & bufferN, int & readcnt, double budget) {
+
+	startBudget(budget);
+	
+	int numreads_g = processWindow(refinfo, g, bufferT, bufferN, readcnt);
+	if(numreads_g < 0) { return -1; }
+	
+	// merged region that could not be assembled (repeats or cycles):
+	// assemble the standard overlapping windows of the region instead
+	if( graph_failed && ((int)refinfo->rawseq.length() > WINDOW_SIZE) ) {
+		if(verbose) { cerr << "Split region " << refinfo->hdr << " into standard windows" << endl; }
+		vector<Ref_t *> subwindows;
+		queue->splitWindow(refinfo, minK, subwindows);
+		int status = 0;
+		for ( unsigned int s=0; s<subwindows.size(); ++s ) {
+			if( (status == 0) && !overBudget() && (processWindow(subwindows[s], g, bufferT, bufferN, readcnt) < 0) ) { status = -1; }
+			delete subwindows[s];
 		}
+		if(status < 0) { return -1; }
+		++num_split;
 	}
 	
-	sample_name_tumor = retriveSampleName(headerT); // extract tumor sample name 
+	return numreads_g;
+}
 
-	if ( !readerN.Open(NORMAL) ) {
-		cerr << "Could not open normal BAM files." << endl;
-		return -1;
-	}
-	// retrieve 'metadata' from BAM files, these are required by BamWriter
-	headerN = readerN.GetHeader();
+// extract the reads from BAMs and process them
+int Microassembler::processReads() {
 	
-	index_found = readerN.LocateIndex(); // locate and load BAM index file (.bam.bai)
-	if(!index_found) {
-		index_filename = GetBaseFilename(NORMAL.c_str())+".bai";		
-		index_found = readerN.OpenIndex(index_filename); //try with different extension .bai
-		if(!index_found) {
-			cerr << "ERROR: index not found for BAM file " << NORMAL << endl;
-			exit(1);
-		}
+	struct timespec start, finish;
+	double elapsed;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	cerr << "Process reads" << endl;
+	
+	// pin the thread before allocating the readers, buffers and graph, so
+	// that they are placed on the memory of its NUMA node
+	if( (CPU >= 0) && !NumaTopology_t::pinThread(CPU) ) {
+		cerr << "Warning: could not pin thread " << ID << " to cpu " << CPU << endl;
 	}
 	
-	sample_name_normal = retriveSampleName(headerN); // extract normal sammple name
+	// open the BAM files and the reference (unless kept open by the engine)
+	AssemblerReaders_t own_readers;
+	AssemblerReaders_t & R = (readers != NULL) ? *readers : own_readers;
+	if( !R.isOpen() && !openReaders(R) ) { return -1; }
+	
+	// on error (-1) the loops stop and the windows and buffers are freed below
+	int status = 0;
+	
+	AlignmentReader_t & readerT = R.readerT;
+	AlignmentReader_t & readerN = R.readerN;
+	
+	sample_name_tumor = R.sample_name_tumor;
+	sample_name_normal = R.sample_name_normal;
+	sample_name_extra = R.sample_name_extra;
+	
+	// other tumors of the same patient (multi-tumor mode)
+	for (unsigned int t = 0; t < R.readersX.size(); ++t) {
+		extraT.push_back(new ReadBuffer_t(*R.readersX[t]));
+	}
+	readsX.resize(extraT.size());
 
 	//load the read group information
 	if(RG_FILE.compare("") != 0) {
@@ -745,6 +816,7 @@ int Microassembler::processReads() {
 	g.setMaxMismatch(MAX_MISMATCH);
 	g.setFilters(filters);
 	g.setLRMode(LR_MODE);
+	g.setNumTumors(extraT.empty() ? 0 : 1 + extraT.size()); // each tumor has its own colour in multi-tumor mode
 	
 	// set STR params
 	g.setMaxUnitLen(MAX_UNIT_LEN);
@@ -752,20 +824,15 @@ int Microassembler::processReads() {
 	g.setMinReportLen(MIN_REPORT_LEN);
 	g.setDistFromStr(DIST_FROM_STR);
 
-	string graphref = "";
-
 	int paircnt = 0;
 	int graphcnt = 0;
 	int readcnt = 0;
 	int numreads_g = 0;
 	
 	// for each reference location
-	BamRegion region;
-	map<string, Ref_t *>::iterator ri;
-		
-	int counter = 0;
-	double progress;
-	double old_progress = 0;
+	ReadBuffer_t bufferT(readerT); // alignments shared by consecutive windows
+	ReadBuffer_t bufferN(readerN);
+	struct timespec bstart, bfinish;
 
 	//#define W_ELAPSED_TIME 1
 	
@@ -776,96 +843,207 @@ int Microassembler::processReads() {
     	ofile.open(filename.str());
 #endif
 	
-	for ( ri=reftable->begin() ; ri != reftable->end(); ++ri ) {
+	
+	// completed windows and their variants are journaled at the end of each chunk
+	// (in pipeline mode they are passed to the collector after each window)
+	stringstream journal_buf;
+	vDB.record = (journal != NULL) || (pipeline != NULL);
+	
+	// pipeline mode: take the windows whose reads were fetched by the readers
+	WindowBatch_t * batch = NULL;
+	while ( (status == 0) && (pipeline != NULL) && ((batch = pipeline->nextBatch()) != NULL) ) {
+	
+		clock_gettime(CLOCK_MONOTONIC, &bstart);
+		
+		++num_windows_done;
+		queue->windowDone(ID, vDB.num_added);
+		
+		int wid = batch->wid;
+		Ref_t * refinfo = batch->refinfo;
+		
+		if(refinfo == NULL) {
+			if(queue->isCompleted(wid)) { ++num_resumed; delete batch; continue; } // window completed by a previous run
+			
+			// window skipped by the active-region pre-scan
+			++num_skip;
+			if(verbose) { cerr << "Skip region: not enough evidence for variation (pre-scan)." << endl; }
+			pipeline->collect(wid, vDB.recorded);
+			delete batch;
+			continue;
+		}
+		if(batch->failed) { delete batch; status = -1; break; }
+		
+		if(verbose) { cerr << "hdr:\t" << refinfo->hdr << endl; }
+		
+		unsigned long num_added = vDB.num_added;
+		numreads_g = assembleWindow(refinfo, g, batch->bufferT, batch->bufferN, readcnt, WINDOW_BUDGET);
+		if(numreads_g < 0) { delete batch; status = -1; break; }
+		
+		if( budget_exceeded ) {
+			if(vDB.num_added == num_added) {
+				cerr << "Defer region " << refinfo->hdr << ": exceeded the time budget of " << WINDOW_BUDGET << " seconds" << endl;
+				queue->defer(wid);
+				++num_deferred;
+				delete batch;
+				continue;
+			}
+			cerr << "Skip region " << refinfo->hdr << ": exceeded the time budget of " << WINDOW_BUDGET << " seconds after reporting variants" << endl;
+			++num_budget_skip;
+		}
+		
+		// the collector owns the variants: keep only the window's own
+		pipeline->collect(wid, vDB.recorded);
+		vDB.recorded.clear();
+		vDB.DB.clear();
+		
+		delete batch; // window is done
+		
+		clock_gettime(CLOCK_MONOTONIC, &bfinish);
+		busy_time += (bfinish.tv_sec - bstart.tv_sec);
+		busy_time += (bfinish.tv_nsec - bstart.tv_nsec) / 1000000000.0;
+	}
+	
+	// claim chunks of windows from the shared queue until it is drained
+	int first = 0;
+	int last = 0;
+	vector<Ref_t *> windows;
+	while ( (status == 0) && (pipeline == NULL) && queue->nextChunk(first, last, NODE) ) {
+	
+		clock_gettime(CLOCK_MONOTONIC, &bstart);
+		
+		windows.clear();
+		queue->loadWindows(first, last, reference, minK, windows);
+	
+		for ( unsigned int w=0; (status == 0) && (w<windows.size()); ++w ) {
 
 #ifdef W_ELAPSED_TIME
-			struct timespec wstart, wfinish;
-			double welapsed;
-			clock_gettime(CLOCK_MONOTONIC, &wstart);
+				struct timespec wstart, wfinish;
+				double welapsed;
+				clock_gettime(CLOCK_MONOTONIC, &wstart);
 #endif
 		
-		++counter;
-		progress = floor(100*(double(counter)/(double)reftable->size()));
-		if (progress > old_progress) {
-			cerr << "Thread " << ID << " is " << progress << "\% done, with " << vDB.getNumVariants() << " variants collected so far." << endl;
-			old_progress = progress;
-		}
+			++num_windows_done;
+			queue->windowDone(ID, vDB.getNumVariants());
+		
+			Ref_t * refinfo = windows[w];
+			windows[w] = NULL;
 			
-		graphref = (*ri).first;
-		//cout << graphref << endl;
-		Ref_t * refinfo = (*ri).second;
+			if(refinfo == NULL) {
+				if(queue->isCompleted(first+w)) { ++num_resumed; continue; } // window completed by a previous run
+				
+				// window skipped by the active-region pre-scan
+				++num_skip;
+				if(verbose) { cerr << "Skip region: not enough evidence for variation (pre-scan)." << endl; }
+				if(journal != NULL) { Journal_t::addWindow(journal_buf, first+w, vDB.recorded, filters); }
+				continue;
+			}
 			
-		// continue if the region has only Ns or prefect repeat of size maxK
-		if(isNseq(refinfo->rawseq)) { continue; } 
-		if(isRepeat(refinfo->rawseq, maxK)) { continue; } 
-
-		region.LeftRefID = readerT.GetReferenceID(refinfo->refchr); // atoi((refinfo->refchr).c_str());
-		region.RightRefID = readerT.GetReferenceID(refinfo->refchr); // atoi((refinfo->refchr).c_str());
-		region.LeftPosition = refinfo->refstart;
-		region.RightPosition = refinfo->refend;
-		//cout << "region = " << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << endl; 
-
-		bool jumpT = readerT.SetRegion(region);
-		if(!jumpT) {
-			cerr << "Error: not able to jump successfully to the region's left boundary in tumor" << endl;
-			return -1;
+			if(verbose) { cerr << "hdr:\t" << refinfo->hdr << endl; }
+			
+			unsigned long num_added = vDB.num_added;
+			numreads_g = assembleWindow(refinfo, g, bufferT, bufferN, readcnt, WINDOW_BUDGET);
+			if(numreads_g < 0) { delete refinfo; status = -1; break; }
+			
+			// pathological window: retry at the end of the run with a larger budget
+			// (unless some of its variants were already reported)
+			if( budget_exceeded ) {
+				if(vDB.num_added == num_added) {
+					cerr << "Defer region " << refinfo->hdr << ": exceeded the time budget of " << WINDOW_BUDGET << " seconds" << endl;
+					queue->defer(first+w);
+					++num_deferred;
+					delete refinfo;
+					continue;
+				}
+				cerr << "Skip region " << refinfo->hdr << ": exceeded the time budget of " << WINDOW_BUDGET << " seconds after reporting variants" << endl;
+				++num_budget_skip;
+			}
+		
+#ifdef W_ELAPSED_TIME
+				clock_gettime(CLOCK_MONOTONIC, &wfinish);
+				welapsed = (wfinish.tv_sec - wstart.tv_sec);
+				welapsed += (wfinish.tv_nsec - wstart.tv_nsec) / 1000000000.0;
+				ofile << welapsed << "\t" << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << "\t" << numreads_g << endl;
+#endif	
+			
+			if(journal != NULL) {
+				Journal_t::addWindow(journal_buf, first+w, vDB.recorded, filters);
+				vDB.recorded.clear();
+			}
+			
+			delete refinfo; // window is done
 		}
-
-		bool jumpN = readerN.SetRegion(region);
-		if(!jumpN) {
-			cerr << "Error: not able to jump successfully to the region's left boundary in normal" << endl;
-			return -1;
+		
+		// windows of the chunk not reached after an error
+		for ( unsigned int w=0; w<windows.size(); ++w ) { delete windows[w]; }
+		windows.clear();
+		if(status < 0) { break; }
+		
+		// checkpoint the windows of the chunk
+		if(journal != NULL) {
+			if(!journal->write(journal_buf.str())) { status = -1; break; }
+			journal_buf.str("");
 		}
+	
+		clock_gettime(CLOCK_MONOTONIC, &bfinish);
+		busy_time += (bfinish.tv_sec - bstart.tv_sec);
+		busy_time += (bfinish.tv_nsec - bstart.tv_nsec) / 1000000000.0;
+	}
+	
+	// windows deferred by any thread: retry with a larger budget and skip
+	// them if they exceed it again
+	int wid = 0;
+	while ( (status == 0) && queue->nextDeferred(wid) ) {
+	
+		clock_gettime(CLOCK_MONOTONIC, &bstart);
+		
+		windows.clear();
+		queue->loadWindows(wid, wid+1, reference, minK, windows);
+		Ref_t * refinfo = windows[0];
 		
-		bool activeT = true;
-		bool activeN = true;
+		double budget = WINDOW_BUDGET * DEFERRED_BUDGET_FACTOR;
+		if(verbose) { cerr << "hdr:\t" << refinfo->hdr << " (deferred)" << endl; }
 		
-		if (ACTIVE_REGION_MODULE) {
-			activeT = isActiveRegion(readerT, refinfo, region, TMR);
-			activeN = isActiveRegion(readerN, refinfo, region, NML);
+		if(assembleWindow(refinfo, g, bufferT, bufferN, readcnt, budget) < 0) { delete refinfo; status = -1; break; }
+		if(budget_exceeded) {
+			cerr << "Skip region " << refinfo->hdr << ": exceeded the time budget of " << budget << " seconds (deferred)" << endl;
+			++num_budget_skip;
 		}
 		
-		if(activeT || activeN){
-			
-			readerT.SetRegion(region); // safe to jump back: errors would have been detected in the previous call to jump
-			readerN.SetRegion(region); // safe to jump back: errors would have been detected in the previous call to jump
-			
-			bool skipT = extractReads(readerT, g, refinfo, region, readcnt, TMR);
-			bool skipN = extractReads(readerN, g, refinfo, region, readcnt, NML);
-			
-			if(!skipT && !skipN) { 
-				numreads_g = processGraph(g, graphref, minK, maxK);
-				//processGraph(g, graphref, minK, maxK);
-				
-			}
-			else { ++num_skip; g.clear(true); }
+		if(pipeline != NULL) {
+			pipeline->collect(wid, vDB.recorded);
+			vDB.recorded.clear();
+			vDB.DB.clear();
 		}
-		else {
-			++num_skip;
-			if(verbose) { cerr << "Skip region: not enough evidence for variation." << endl; }
+		else if(journal != NULL) {
+			Journal_t::addWindow(journal_buf, wid, vDB.recorded, filters);
+			vDB.recorded.clear();
+			if(!journal->write(journal_buf.str())) { delete refinfo; status = -1; break; }
+			journal_buf.str("");
 		}
 		
-#ifdef W_ELAPSED_TIME
-			clock_gettime(CLOCK_MONOTONIC, &wfinish);
-			welapsed = (wfinish.tv_sec - wstart.tv_sec);
-			welapsed += (wfinish.tv_nsec - wstart.tv_nsec) / 1000000000.0;
-			ofile << welapsed << "\t" << refinfo->refchr << ":" << refinfo->refstart << "-" << refinfo->refend << "\t" << numreads_g << endl;
-#endif	
+		delete refinfo;
+		
+		clock_gettime(CLOCK_MONOTONIC, &bfinish);
+		busy_time += (bfinish.tv_sec - bstart.tv_sec);
+		busy_time += (bfinish.tv_nsec - bstart.tv_nsec) / 1000000000.0;
 	}
+	
 #ifdef W_ELAPSED_TIME	
 	ofile.close();
 #endif
 	
-	readerT.Close();
-	readerN.Close();
+	for (unsigned int t = 0; t < extraT.size(); ++t) { delete extraT[t]; }
+	extraT.clear();
 	
 	clock_gettime(CLOCK_MONOTONIC, &finish);
 	elapsed = (finish.tv_sec - start.tv_sec);
 	elapsed += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+	elapsed_time = elapsed;
 	cerr << "Thread " << ID << " elapsed time:" << elapsed << " seconds" << endl;
 		
 	if(verbose) cerr << "=======" << endl;
-	if(verbose) cerr << "total reads: " << readcnt << " pairs: " << paircnt << " total graphs: " << graphcnt << " ref sequences: " << reftable->size() <<  endl;
+	if(verbose) cerr << "total reads: " << readcnt << " pairs: " << paircnt << " total graphs: " << graphcnt << " ref sequences: " << num_windows_done <<  endl;
+	if(verbose) cerr << "alignments loaded: " << bufferT.numLoaded() << " (tumor) " << bufferN.numLoaded() << " (normal) BAM jumps: " << bufferT.numJumps() << " (tumor) " << bufferN.numJumps() << " (normal)" << endl;
 	
-	return 0;
+	return status;
 }
@@ -44,7 +44,6 @@
 #include "api/BamWriter.h"
 #include "api/SamReadGroupDictionary.h"
 #include "api/SamReadGroup.h"
-#include "htslib/faidx.h"
 
 #include "align.hh"
 #include "util.hh"
@@ -60,12 +59,55 @@
 #include "Graph.hh"
 #include "VariantDB.hh"
 #include "ErrorCorrector.hh"
+#include "AlignmentReader.hh"
+#include "WindowQueue.hh"
+#include "RefProvider.hh"
+#include "Journal.hh"
+#include "Pipeline.hh"
+#include "ReadBuffer.hh"
+#include "WindowReads.hh"
 
 using namespace std;
 using namespace HASHMAP;
 using namespace BamTools;
 
 #define bvalue(value) ((value ? "true" : "false"))
+#define DEFERRED_BUDGET_FACTOR 10 // budget multiplier for the windows retried at the end of the run
+
+// AssemblerReaders_t
+// BAM files (with their indexes) read by an assembly thread, kept open
+// by the engine across its runs
+//////////////////////////////////////////////////////////////////////////
+class AssemblerReaders_t
+{
+public:
+
+	AlignmentReader_t readerT;
+	AlignmentReader_t readerN;
+	vector<AlignmentReader_t *> readersX; // other tumors (multi-tumor mode)
+	bool is_open;
+	
+	string sample_name_tumor;
+	string sample_name_normal;
+	vector<string> sample_name_extra;
+
+	AssemblerReaders_t() : is_open(false) { }
+	~AssemblerReaders_t() { close(); }
+	
+	bool isOpen() { return is_open; }
+	
+	void close() {
+		readerT.close();
+		readerN.close();
+		for (unsigned int t = 0; t < readersX.size(); ++t) {
+			readersX[t]->close();
+			delete readersX[t];
+		}
+		readersX.clear();
+		sample_name_extra.clear();
+		is_open = false;
+	}
+};
 
 class Microassembler {
 
@@ -74,6 +116,7 @@ public:
 	int ID;
 	int BUFFER_SIZE;
 	int WINDOW_SIZE;
+	double WINDOW_BUDGET; // max time (in seconds) spent on a window (0 = no limit)
 	
 	// Configuration
 	//////////////////////////////////////////////////////////////////////////
@@ -93,9 +136,11 @@ public:
 	int MAX_DELTA_AS_XS;
 
 	string TUMOR;
+	vector<string> EXTRA_TUMORS; // other tumors of the same patient (multi-tumor mode)
 	string NORMAL;
 	string RG_FILE;
-	string REFFILE;
+	RefProvider_t * reference; // shared by all the threads
+	ReaderOptions_t * reader_opts; // backend of the alignment readers (NULL = bamtools)
 	string READSET;
 
 	//string PREFIX;
@@ -108,6 +153,7 @@ public:
 	double MIN_COV_RATIO;
 	int LOW_COV_THRESHOLD;
 	int MAX_AVG_COV;
+	bool DOWNSAMPLE; // downsample the windows above MAX_AVG_COV instead of skipping them
 	
 	//STR parameters
 	int MAX_UNIT_LEN;
@@ -133,6 +179,7 @@ public:
 	
 	string sample_name_normal;
 	string sample_name_tumor;
+	vector<string> sample_name_extra; // sample names of the other tumors
 	
 	// data structures
 	//////////////////////////////////////////////////////////////////////////
@@ -145,8 +192,35 @@ public:
 	set<string> RG_self;
 	set<string> RG_sibling;
 	
-	map<string, Ref_t *> * reftable; // table of references to analyze
+	WindowQueue_t * queue; // shared queue of windows to analyze
 	VariantDB_t vDB; // variants DB
+	vector<ReadBuffer_t *> extraT; // reads of the other tumors in the current window
+	Journal_t * journal; // journal of completed windows (NULL if disabled)
+	Pipeline_t * pipeline; // reader and collector stages (NULL if the thread reads its own windows)
+	AssemblerReaders_t * readers; // kept open by the engine (NULL if opened and closed by processReads)
+	
+	int NODE; // NUMA node of the thread (0 if not placed)
+	int CPU; // cpu the thread is pinned to (-1 if not pinned)
+	
+	double busy_time; // time spent processing windows (in seconds)
+	double elapsed_time; // thread running time (in seconds)
+	int num_windows_done; // number of windows processed by this thread
+	int num_split; // number of merged regions re-assembled as standard windows
+	int num_resumed; // number of windows completed by a previous run
+	int num_deferred; // number of windows deferred for exceeding the time budget
+	int num_budget_skip; // number of windows skipped for exceeding the time budget
+	int num_downsampled; // number of windows downsampled to MAX_AVG_COV
+	
+	// time budget of the current window
+	struct timespec window_start;
+	double window_budget;
+	bool budget_exceeded;
+	bool graph_failed; // last graph had repeats or cycles for all k
+	bool failed; // processReads stopped on an error
+	
+	WindowReads_t readsT; // reads and evidence collected for the current window
+	WindowReads_t readsN;
+	vector<WindowReads_t> readsX; // reads of the other tumors (multi-tumor mode)
 	
 	int num_snv_only_regions;
 	int num_indel_only_regions;
@@ -164,12 +238,34 @@ public:
 		graphCnt = 0;
 		num_skip = 0;
 		
+		queue = NULL;
+		journal = NULL;
+		pipeline = NULL;
+		readers = NULL;
+		reference = NULL;
+		reader_opts = NULL;
+		NODE = 0;
+		CPU = -1;
+		busy_time = 0;
+		elapsed_time = 0;
+		num_windows_done = 0;
+		num_split = 0;
+		num_resumed = 0;
+		num_deferred = 0;
+		num_budget_skip = 0;
+		num_downsampled = 0;
+		window_budget = 0;
+		budget_exceeded = false;
+		graph_failed = false;
+		failed = false;
+		
 		ACTIVE_REGION_MODULE = true;
 		PRIMARY_ALIGNMENT_ONLY = false;
 		XA_FILTER = false;
 		
 		BUFFER_SIZE = 10*1024;
 		WINDOW_SIZE = 600;
+		WINDOW_BUDGET = 0;
 
 		verbose			= false;
 		VERBOSE         = false;
@@ -195,6 +291,7 @@ public:
 		MIN_COV_RATIO = 0.01;
 		LOW_COV_THRESHOLD = 1;
 		MAX_AVG_COV = 10000;
+		DOWNSAMPLE = true;
 
 		SCAFFOLD_CONTIGS = 0;
 		INSERT_SIZE = 150;
@@ -221,14 +318,21 @@ public:
 	
 	void loadRefs(const string & filename);
 	void loadRG(const string & filename, int member);
-	int processGraph(Graph_t & g, const string & refname, int minK, int maxK);
+	int processGraph(Graph_t & g, Ref_t * refinfo, int minK, int maxK);
 	int run(int argc, char** argv);
-	bool extractReads(BamReader &reader, Graph_t &g, Ref_t *refinfo, BamRegion &region, int &readcnt, int code);
-	bool isActiveRegion(BamReader &reader, Ref_t *refinfo, BamRegion &region, int code);
+	int processWindow(Ref_t * refinfo, Graph_t & g, ReadBuffer_t & bufferT, ReadBuffer_t & bufferN, int & readcnt);
+	int assembleWindow(Ref_t * refinfo, Graph_t & g, ReadBuffer_t & bufferT, ReadBuffer_t & bufferN, int & readcnt, double budget);
+	void startBudget(double budget);
+	bool overBudget();
+	void scanReads(ReadBuffer_t &buffer, Ref_t *refinfo, BamRegion &region, WindowReads_t &scan, int code);
+	bool extractReads(WindowReads_t &scan, Graph_t &g, Ref_t *refinfo, int &readcnt, int code, int tumor = -1);
+	bool isActiveRegion(WindowReads_t &scan, int code);
 	int processReads();
 	void setFilters(Filters * fs) { filters = fs; vDB.setFilters(fs); }
 	void setID(int i) { ID = i; }
 	string retriveSampleName(SamHeader &header);
+	bool openReader(AlignmentReader_t & reader, const string & filename);
+	bool openReaders(AssemblerReaders_t & r);
 };
 
 #endif
@@ -27,7 +27,7 @@
 // add 10x barcode to set of barcodes for this node
 // return false if the insertion was not succesfull
 //////////////////////////////////////////////////////////////
-bool Node_t::addBX(std::string & bx, unsigned int strand, int label) {
+bool Node_t::addBX(const std::string & bx, unsigned int strand, int label) {
 	
 	bool ans = false; 
 	
@@ -59,7 +59,7 @@ void Node_t::addHP(int hp, int label) {
 // hasBX
 // return true if the barcode is already present in the bxset
 //////////////////////////////////////////////////////////////
-bool Node_t::hasBX(std::string & bx, int label) {
+bool Node_t::hasBX(const std::string & bx, int label) {
 
 	bool ans = false;
 	
@@ -497,6 +497,7 @@ void Node_t::updateCovDistr(int cov, const string & qv, unsigned int strand, int
 		
 	if(sample == TMR) { cov_distr = &cov_distr_tmr; }
 	else if(sample == NML) { cov_distr = &cov_distr_nml; }
+	else if(sample >= SMP) { cov_distr = &smpCovDistr(sample-SMP); }
 	else { cerr << "Error: unrecognized sample " << sample << endl; }
 		
  	//string::const_iterator it=qv.begin();
@@ -519,6 +520,20 @@ void Node_t::updateCovDistr(int cov, const string & qv, unsigned int strand, int
 	}
 }
 
+// smpCovDistr
+// coverage distribution of tumor s (multi-tumor mode)
+// the distributions are created on first use
+//////////////////////////////////////////////////////////////
+vector<cov_t> & Node_t::smpCovDistr(unsigned int s) 
+{
+	while (cov_distr_smp.size() <= s) {
+		cov_distr_smp.push_back(vector<cov_t>(cov_distr_tmr.size()));
+		cov_smp_fwd.push_back(0);
+		cov_smp_rev.push_back(0);
+	}
+	return cov_distr_smp[s];
+}
+
 // updateHPCovDistr
 // updated the haplotype coverage distribution along the node string
 //////////////////////////////////////////////////////////////
@@ -591,6 +606,7 @@ void Node_t::revCovDistr()
 	while(i<j){
 		swap(cov_distr_tmr[i], cov_distr_tmr[j]);
 		swap(cov_distr_nml[i], cov_distr_nml[j]);
+		for (unsigned int s = 0; s < cov_distr_smp.size(); ++s) { swap(cov_distr_smp[s][i], cov_distr_smp[s][j]); }
 		++i;--j;
 	}
 }
@@ -658,13 +674,13 @@ int Node_t::readOverlaps(const Node_t & other)
 // hasOverlappingMate
 // return true if the k-mer comes from the same fragment (overlapping mates)
 //////////////////////////////////////////////////////////////
-bool Node_t::hasOverlappingMate(string & read_name, int id)
+bool Node_t::hasOverlappingMate(const string * read_name, int id)
 {	
 	bool ans = false;
 	
 	if(id == 1) {
 		//if (mate2_name.find(read_name) != mate2_name.end()) { ans = true; }
-	    if (binary_search (mate2_name.begin(), mate2_name.end(), read_name)) { ans = true; }		
+	    if (binary_search (mate2_name.begin(), mate2_name.end(), read_name, lessName)) { ans = true; }		
 
 		//for (vector<string>::iterator it2 = mate2_name.begin() ; it2 != mate2_name.end(); ++it2) {
 		//	if ((*it2) == read_name) { ans = true; }
@@ -673,7 +689,7 @@ bool Node_t::hasOverlappingMate(string & read_name, int id)
 	
 	if(id == 2) {
 		//if (mate1_name.find(read_name) != mate1_name.end()) { ans = true; }
-	    if (binary_search (mate1_name.begin(), mate1_name.end(), read_name)) { ans = true; }		
+	    if (binary_search (mate1_name.begin(), mate1_name.end(), read_name, lessName)) { ans = true; }		
 			
 	    //for (vector<string>::iterator it1 = mate1_name.begin() ; it1 != mate1_name.end(); ++it1) {
 		//	if ((*it1) == read_name) { ans = true; }
@@ -685,7 +701,7 @@ bool Node_t::hasOverlappingMate(string & read_name, int id)
 
 // add mate name to the set of mates containing this kmer
 // also store  mate order (1st or 2nd in pair) 
-void Node_t::addMateName(string & read_name, int id) 
+void Node_t::addMateName(const string * read_name, int id) 
 {	
 	//if(id == 1) { mate1_name.insert(read_name); }
 	//if(id == 2) { mate2_name.insert(read_name); }
@@ -707,6 +723,10 @@ float Node_t::getCov(unsigned int strand, int label) {
 		if(strand == FWD) { ans = cov_nml_m_fwd; } 
 		if(strand == REV) { ans = cov_nml_m_rev; } 
 	}
+	if ( (label >= SMP) && ((unsigned int)(label-SMP) < cov_smp_fwd.size()) ) {
+		if(strand == FWD) { ans = cov_smp_fwd[label-SMP]; } 
+		if(strand == REV) { ans = cov_smp_rev[label-SMP]; } 
+	}
 	
 	return ans;
 }
@@ -723,4 +743,9 @@ void Node_t::incCov(unsigned int strand, int label) {
 		if(strand == FWD) { cov_nml_m_fwd++; } 
 		else if(strand == REV) { cov_nml_m_rev++; }
 	}
+	if (label >= SMP) {
+		smpCovDistr(label-SMP);
+		if(strand == FWD) { cov_smp_fwd[label-SMP]++; } 
+		else if(strand == REV) { cov_smp_rev[label-SMP]++; }
+	}
 }
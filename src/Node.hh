@@ -75,6 +75,10 @@ public:
 	vector<cov_t> cov_distr_tmr;
 	vector<cov_t> cov_distr_nml;
 	
+	vector<float> cov_smp_fwd; // coverage forward of each tumor (multi-tumor mode)
+	vector<float> cov_smp_rev; // coverage reverse of each tumor (multi-tumor mode)
+	vector< vector<cov_t> > cov_distr_smp; // coverage distribution of each tumor (multi-tumor mode)
+	
 	vector<Edge_t> edges_m;
 	unordered_set<ReadId_t> reads_m;
 	
@@ -88,8 +92,8 @@ public:
 	
 	//unordered_set<string> mate1_name;
 	//unordered_set<string> mate2_name;
-	vector<string> mate1_name;
-	vector<string> mate2_name;
+	vector<const string *> mate1_name; // interned in the read arena of the graph
+	vector<const string *> mate2_name;
 	
 	vector<ReadStart_t> readstarts_m;
 	ContigLinkMap_t contiglinks_m;
@@ -137,9 +141,10 @@ public:
 			
 			cov_distr_tmr.clear(); vector<cov_t>().swap(cov_distr_tmr);
 			cov_distr_nml.clear(); vector<cov_t>().swap(cov_distr_nml);
+			cov_distr_smp.clear(); vector< vector<cov_t> >().swap(cov_distr_smp);
 			
-			mate1_name.clear(); vector<string>().swap(mate1_name);
-			mate2_name.clear(); vector<string>().swap(mate2_name);
+			mate1_name.clear(); vector<const string *>().swap(mate1_name);
+			mate2_name.clear(); vector<const string *>().swap(mate2_name);
 
 			readstarts_m.clear(); vector<ReadStart_t>().swap(readstarts_m);			
 		}
@@ -175,6 +180,8 @@ public:
 	void updateCovDistr(int cov, const string & qv, unsigned int strand, int sample);
 	void updateHPCovDistr(int hp0_cov, int hp1_cov, int hp2_cov, const string & qv, int sample);
 	void updateCovStatus(char c);
+	vector<cov_t> & smpCovDistr(unsigned int s);
+	int numSamples() { return cov_distr_smp.size(); }
 	
 	void revCovDistr();
 	void computeMinCov();
@@ -203,12 +210,13 @@ public:
 	void sortReadStarts();
 	void addContigLink(Mer_t contigid, ReadId_t rid);
 	int cntReadCode(char code);
-	bool hasOverlappingMate(std::string & read_name, int id);	
-	void addMateName(std::string & read_name, int id);
+	bool hasOverlappingMate(const std::string * read_name, int id);	
+	void addMateName(const std::string * read_name, int id);
+	static bool lessName(const std::string * a, const std::string * b) { return (*a < *b); }
 	
 	void addHP(int hp, int label); 
-	bool addBX(std::string & bx, unsigned int strand, int label);
-	bool hasBX(std::string & bx, int label);
+	bool addBX(const std::string & bx, unsigned int strand, int label);
+	bool hasBX(const std::string & bx, int label);
 	int BXcnt(unsigned int strand, int label);
 	int HPcnt(unsigned int hp_num, int label);
 	
@@ -0,0 +1,135 @@
+#include "Numa.hh"
+
+/****************************************************************************
+** Numa.cc
+**
+** NUMA topology of the host (from sysfs) and placement of the worker
+** threads: each worker is pinned to a core of its node, so the graph, read
+** buffers and BAM readers it allocates are first touched (and placed) on
+** the local memory of the node
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// parse a sysfs cpu/node list (e.g. 0-3,8,10-11)
+//////////////////////////////////////////////////////////////
+set<int> NumaTopology_t::parseList(const string & list) {
+
+	set<int> ids;
+	istringstream iss(list);
+	string token;
+	while (getline(iss, token, ',')) {
+		if(token.empty()) { continue; }
+		size_t x = token.find('-');
+		int first = atoi(token.substr(0, x).c_str());
+		int last = (x == string::npos) ? first : atoi(token.substr(x+1).c_str());
+		for (int i = first; i <= last; ++i) { ids.insert(i); }
+	}
+	return ids;
+}
+
+// read the first line of a file
+//////////////////////////////////////////////////////////////
+bool NumaTopology_t::readLine(const string & filename, string & line) {
+
+	ifstream file(filename.c_str());
+	if (!file.is_open()) { return false; }
+	return (bool)getline(file, line);
+}
+
+// load the nodes and their cpus, restricted to the cpus the process is
+// allowed to run on (nodes without usable cpus are ignored)
+// without NUMA information all the cpus are in a single node
+//////////////////////////////////////////////////////////////
+void NumaTopology_t::load() {
+
+	node_cpus.clear();
+	node_ids.clear();
+
+	set<int> allowed;
+#ifdef __linux__
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	if(sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+		for (int c = 0; c < CPU_SETSIZE; ++c) {
+			if(CPU_ISSET(c, &mask)) { allowed.insert(c); }
+		}
+	}
+#endif
+
+	string line;
+	if(readLine("/sys/devices/system/node/online", line)) {
+		set<int> nodes = parseList(line);
+		for (set<int>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+
+			string cpulist;
+			stringstream filename;
+			filename << "/sys/devices/system/node/node" << (*it) << "/cpulist";
+			if(!readLine(filename.str(), cpulist)) { continue; }
+
+			set<int> cpus = parseList(cpulist);
+			vector<int> usable;
+			for (set<int>::iterator c = cpus.begin(); c != cpus.end(); ++c) {
+				if(allowed.empty() || allowed.count(*c)) { usable.push_back(*c); }
+			}
+			if(usable.empty()) { continue; }
+
+			node_cpus.push_back(usable);
+			node_ids.push_back(*it);
+			if((int)node_cpus.size() == MAX_NUMA_NODES) { break; }
+		}
+	}
+
+	if(node_cpus.empty()) {
+		node_cpus.push_back(vector<int>(allowed.begin(), allowed.end()));
+		node_ids.push_back(0);
+	}
+}
+
+// place thread (0-based) out of num_threads: the threads are split evenly
+// across the nodes and each one gets a different cpu of its node (cpus are
+// shared round-robin if there are more threads than cpus)
+// cpu is -1 if the cpus are unknown
+//////////////////////////////////////////////////////////////
+void NumaTopology_t::assign(int thread, int num_threads, int & node, int & cpu) {
+
+	int N = numNodes();
+	node = ((long)thread * N) / num_threads;
+
+	// rank of the thread among the threads of its node
+	int first = (node * num_threads + N - 1) / N;
+	int rank = thread - first;
+
+	vector<int> & cpus = node_cpus[node];
+	cpu = cpus.empty() ? -1 : cpus[rank % cpus.size()];
+}
+
+// pin the calling thread to a cpu
+// returns false if the thread cannot be pinned
+//////////////////////////////////////////////////////////////
+bool NumaTopology_t::pinThread(int cpu) {
+
+#ifdef __linux__
+	if(cpu < 0 || cpu >= CPU_SETSIZE) { return false; }
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0);
+#else
+	return false;
+#endif
+}
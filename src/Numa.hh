@@ -0,0 +1,61 @@
+#ifndef NUMA_HH
+#define NUMA_HH 1
+
+/****************************************************************************
+** Numa.hh
+**
+** NUMA topology of the host (from sysfs) and placement of the worker
+** threads: each worker is pinned to a core of its node, so the graph, read
+** buffers and BAM readers it allocates are first touched (and placed) on
+** the local memory of the node
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+#define MAX_NUMA_NODES 64 // max number of nodes used for thread placement
+
+class NumaTopology_t
+{
+public:
+
+	vector< vector<int> > node_cpus; // usable cpus of each node
+	vector<int> node_ids; // system id of each node
+
+	void load();
+	int numNodes() { return node_cpus.size(); }
+	void assign(int thread, int num_threads, int & node, int & cpu);
+	static bool pinThread(int cpu);
+
+private:
+
+	static set<int> parseList(const string & list);
+	static bool readLine(const string & filename, string & line);
+};
+
+#endif
@@ -107,7 +107,7 @@ string Path_t::str()
 
 // coverage distribution for nodes
 //////////////////////////////////////////////////////////////
-vector<cov_t> Path_t::covDistr(char sample)
+vector<cov_t> Path_t::covDistr(char sample, int tumor)
 {
 	vector<cov_t> path_coverage;
 	vector<cov_t> node_coverage;
@@ -125,6 +125,7 @@ vector<cov_t> Path_t::covDistr(char sample)
 				
 		if(sample == 'T') { C = n->cov_distr_tmr; }
 		else if(sample == 'N') { C = n->cov_distr_nml; }
+		else if(sample == 'S') { C = n->smpCovDistr(tumor); }
 		else { cerr << "Error: unrecognized sample " << sample << endl; }
 				
 		if (dir == R) {
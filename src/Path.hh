@@ -136,7 +136,7 @@ public:
 	Node_t * pathcontig(int pos);
 	int hasCycle(Node_t * node);
 	bool hasTumorOnlyNode();
-	vector<cov_t> covDistr(char sample);
+	vector<cov_t> covDistr(char sample, int tumor = 0); // sample 'S' is one of the tumors of a multi-tumor run
 	vector<float> readCovNodes();
 };
 
@@ -0,0 +1,271 @@
+#include "Pipeline.hh"
+
+/****************************************************************************
+** Pipeline.cc
+**
+** Three-stage pipeline: reader threads fetch and filter the tumor and
+** normal reads of the upcoming windows, the assembly threads
+** (Microassembler) take the windows whose reads are ready, and a collector
+** thread owns the variants DB (and the journal). The stages are connected
+** by bounded queues, so I/O and assembly overlap with limited memory
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+Pipeline_t::Pipeline_t(WindowQueue_t * queue_, int num_readers_, int num_workers_, bool lrmode)
+	: reference(NULL), reader_opts(NULL), MIN_MAP_QUAL(0), minK(0), maxK(0), db(lrmode), journal(NULL), filters(NULL), read_time(0), num_alignments(0), failed(false),
+	  queue(queue_), num_readers(max(1, num_readers_)), num_workers(max(1, num_workers_)),
+	  ready(PIPELINE_DEPTH * max(1, num_workers_), max(1, num_readers_)),
+	  results(PIPELINE_DEPTH * max(1, num_workers_), max(1, num_workers_))
+{
+	pthread_mutex_init(&stats_lock, NULL);
+}
+
+// start the reader threads and the collector thread
+// (false if a thread could not be created: the pipeline is then stopped)
+//////////////////////////////////////////////////////////////
+bool Pipeline_t::start() {
+
+	readers.resize(num_readers);
+	for (int i = 0; i < num_readers; ++i) {
+		if (pthread_create(&readers[i], NULL, readerThread, (void *)this)) {
+			cerr << "Error: unable to create reader thread" << endl;
+			stopReaders(i);
+			return false;
+		}
+	}
+	if (pthread_create(&collector, NULL, collectorThread, (void *)this)) {
+		cerr << "Error: unable to create collector thread" << endl;
+		stopReaders(num_readers);
+		return false;
+	}
+	return true;
+}
+
+// stop and wait for the reader threads already started
+//////////////////////////////////////////////////////////////
+void Pipeline_t::stopReaders(int num_started) {
+
+	queue->stop();
+	ready.close();
+	for (int i = 0; i < num_started; ++i) { pthread_join(readers[i], NULL); }
+	pthread_mutex_destroy(&stats_lock);
+
+	WindowBatch_t * batch = NULL;
+	while (ready.pop(batch)) { delete batch; }
+}
+
+// wait for the reader threads and the collector thread
+// (after all the assembly threads called workerDone)
+//////////////////////////////////////////////////////////////
+void Pipeline_t::join() {
+
+	for (int i = 0; i < num_readers; ++i) { pthread_join(readers[i], NULL); }
+	pthread_join(collector, NULL);
+	pthread_mutex_destroy(&stats_lock);
+}
+
+void * Pipeline_t::readerThread(void * ptr) {
+	((Pipeline_t *)ptr)->readWindows();
+	return NULL;
+}
+
+void * Pipeline_t::collectorThread(void * ptr) {
+	((Pipeline_t *)ptr)->collectVariants();
+	return NULL;
+}
+
+// open a BAM file with its index
+//////////////////////////////////////////////////////////////
+static bool openBam(AlignmentReader_t & reader, const string & filename, const ReaderOptions_t * opts) {
+
+	if ( !reader.open(filename, opts) ) {
+		cerr << "Could not open BAM file " << filename << endl;
+		return false;
+	}
+
+	if ( !reader.openIndex() ) { // .bam.bai, .bai (or .crai with htslib)
+		cerr << "ERROR: index not found for BAM file " << filename << endl;
+		return false;
+	}
+	return true;
+}
+
+// reader stage: claim chunks of windows from the window queue, fetch the
+// reads of each window and pass them to the assembly threads
+// (the reads that cannot be selected for any window within the region are
+// dropped here: outside the region, low mapping quality or duplicates)
+//////////////////////////////////////////////////////////////
+void Pipeline_t::readWindows() {
+
+	AlignmentReader_t readerT;
+	AlignmentReader_t readerN;
+	if ( !openBam(readerT, TUMOR, reader_opts) || !openBam(readerN, NORMAL, reader_opts) ) {
+		pthread_mutex_lock(&stats_lock);
+		failed = true;
+		pthread_mutex_unlock(&stats_lock);
+		queue->stop(); // the other readers stop after their current chunk
+		ready.producerDone();
+		return;
+	}
+
+	ReadBuffer_t bufferT(readerT); // alignments shared by consecutive windows
+	ReadBuffer_t bufferN(readerN);
+
+	double busy = 0;
+	long loaded = 0;
+	bool stop = false;
+	int first = 0;
+	int last = 0;
+	vector<Ref_t *> windows;
+	while ( !stop && queue->nextChunk(first, last) ) {
+
+		struct timespec bstart, bfinish;
+		clock_gettime(CLOCK_MONOTONIC, &bstart);
+
+		windows.clear();
+		queue->loadWindows(first, last, reference, minK, windows);
+
+		vector<WindowBatch_t *> batches;
+		for ( unsigned int w=0; w<windows.size(); ++w ) {
+
+			Ref_t * refinfo = windows[w];
+			WindowBatch_t * batch = new WindowBatch_t(first+w, refinfo);
+			batches.push_back(batch);
+
+			// windows with only Ns or perfect repeats are not assembled
+			if( (refinfo == NULL) || isNseq(refinfo->rawseq) || isRepeat(refinfo->rawseq, maxK) ) { continue; }
+
+			BamRegion region(refinfo->refid, refinfo->refstart, refinfo->refid, refinfo->refend);
+
+			if(!bufferT.setWindow(region)) {
+				cerr << "Error: not able to jump successfully to the region's left boundary in tumor" << endl;
+				batch->failed = true;
+				continue;
+			}
+			if(!bufferN.setWindow(region)) {
+				cerr << "Error: not able to jump successfully to the region's left boundary in normal" << endl;
+				batch->failed = true;
+				continue;
+			}
+
+			// more sensitive in normal (all mapping qualities)
+			batch->bufferT.snapshot(bufferT, region, MIN_MAP_QUAL);
+			batch->bufferN.snapshot(bufferN, region, 0);
+			loaded += batch->bufferT.numLoaded() + batch->bufferN.numLoaded();
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &bfinish);
+		busy += (bfinish.tv_sec - bstart.tv_sec);
+		busy += (bfinish.tv_nsec - bstart.tv_nsec) / 1000000000.0;
+
+		// hand the windows to the assembly threads (blocks while they are busy)
+		for ( unsigned int b=0; b<batches.size(); ++b ) {
+			if( stop || !ready.push(batches[b]) ) { stop = true; delete batches[b]; }
+		}
+	}
+
+	readerT.close();
+	readerN.close();
+
+	pthread_mutex_lock(&stats_lock);
+	read_time += busy;
+	num_alignments += loaded;
+	pthread_mutex_unlock(&stats_lock);
+
+	ready.producerDone();
+}
+
+// next window with its reads for an assembly thread (owned by the caller)
+// returns NULL when all the windows were read
+//////////////////////////////////////////////////////////////
+WindowBatch_t * Pipeline_t::nextBatch() {
+
+	WindowBatch_t * batch = NULL;
+	if(!ready.pop(batch)) { return NULL; }
+	return batch;
+}
+
+// pass the variants of a completed window to the collector
+//////////////////////////////////////////////////////////////
+void Pipeline_t::collect(int wid, vector<Variant_t> & variants) {
+
+	WindowResult_t * result = new WindowResult_t(wid);
+	result->variants.swap(variants);
+	if(!results.push(result)) { delete result; }
+}
+
+// an assembly thread is done: once all are done the collector drains its
+// queue, and the readers are stopped (in case the threads exited early)
+//////////////////////////////////////////////////////////////
+void Pipeline_t::workerDone() {
+
+	results.producerDone();
+
+	pthread_mutex_lock(&stats_lock);
+	bool last = (--num_workers == 0);
+	pthread_mutex_unlock(&stats_lock);
+
+	if(last) {
+		ready.close();
+		WindowBatch_t * batch = NULL;
+		while (ready.pop(batch)) { delete batch; }
+	}
+}
+
+// collector stage: add the variants of the completed windows to the DB and
+// journal the windows (in groups, when the queue is drained)
+//////////////////////////////////////////////////////////////
+void Pipeline_t::collectVariants() {
+
+	stringstream journal_buf;
+	int pending = 0;
+
+	WindowResult_t * result = NULL;
+	while ( results.pop(result) ) {
+
+		for (unsigned int i = 0; i < result->variants.size(); ++i) {
+			db.addVar(result->variants[i]);
+		}
+
+		if(journal != NULL) {
+			Journal_t::addWindow(journal_buf, result->wid, result->variants, filters);
+			++pending;
+			if( (pending >= JOURNAL_BATCH) || results.empty() ) {
+				if(!journal->write(journal_buf.str())) { journalFailed(); }
+				journal_buf.str("");
+				pending = 0;
+			}
+		}
+
+		delete result;
+	}
+
+	if( (journal != NULL) && (pending > 0) && !journal->write(journal_buf.str()) ) { journalFailed(); }
+}
+
+// the journal could not be written: stop the run (the results of the
+// windows already taken by the assembly threads are still drained)
+//////////////////////////////////////////////////////////////
+void Pipeline_t::journalFailed() {
+
+	journal = NULL;
+	pthread_mutex_lock(&stats_lock);
+	failed = true;
+	pthread_mutex_unlock(&stats_lock);
+	queue->stop();
+}
@@ -0,0 +1,234 @@
+#ifndef PIPELINE_HH
+#define PIPELINE_HH 1
+
+/****************************************************************************
+** Pipeline.hh
+**
+** Three-stage pipeline: reader threads fetch and filter the tumor and
+** normal reads of the upcoming windows, the assembly threads
+** (Microassembler) take the windows whose reads are ready, and a collector
+** thread owns the variants DB (and the journal). The stages are connected
+** by bounded queues, so I/O and assembly overlap with limited memory
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <pthread.h>
+#include <time.h>
+
+#include "api/BamReader.h"
+
+#include "AlignmentReader.hh"
+
+#include "util.hh"
+#include "Ref.hh"
+#include "Variant.hh"
+#include "VariantDB.hh"
+#include "WindowQueue.hh"
+#include "RefProvider.hh"
+#include "ReadBuffer.hh"
+#include "Journal.hh"
+
+using namespace std;
+using namespace BamTools;
+
+#define PIPELINE_DEPTH 4 // windows buffered per assembly thread between the stages
+#define JOURNAL_BATCH 16 // max number of windows journaled at once by the collector
+
+// BoundedQueue_t
+// blocking FIFO queue with limited capacity between two stages: push
+// waits while the queue is full, pop waits while it is empty and returns
+// false once all the producers are done (or the queue is closed) and the
+// queue is drained
+//////////////////////////////////////////////////////////////////////////
+template <class T>
+class BoundedQueue_t
+{
+public:
+
+	double push_wait; // time spent by the producers waiting for a free slot (in seconds)
+	double pop_wait; // time spent by the consumers waiting for an item (in seconds)
+
+	BoundedQueue_t(int capacity_, int num_producers_) : push_wait(0), pop_wait(0), capacity(capacity_), num_producers(num_producers_), closed(false) {
+		pthread_mutex_init(&lock, NULL);
+		pthread_cond_init(&not_empty, NULL);
+		pthread_cond_init(&not_full, NULL);
+	}
+
+	~BoundedQueue_t() {
+		pthread_mutex_destroy(&lock);
+		pthread_cond_destroy(&not_empty);
+		pthread_cond_destroy(&not_full);
+	}
+
+	// returns false if the queue was closed (the item is not queued)
+	bool push(const T & item) {
+		pthread_mutex_lock(&lock);
+		if( !closed && ((int)items.size() >= capacity) ) {
+			double t = now();
+			while ( !closed && ((int)items.size() >= capacity) ) { pthread_cond_wait(&not_full, &lock); }
+			push_wait += now() - t;
+		}
+		bool ok = !closed;
+		if(ok) { items.push_back(item); }
+		pthread_cond_signal(&not_empty);
+		pthread_mutex_unlock(&lock);
+		return ok;
+	}
+
+	bool pop(T & item) {
+		pthread_mutex_lock(&lock);
+		if( items.empty() && (num_producers > 0) && !closed ) {
+			double t = now();
+			while ( items.empty() && (num_producers > 0) && !closed ) { pthread_cond_wait(&not_empty, &lock); }
+			pop_wait += now() - t;
+		}
+		bool ok = !items.empty();
+		if(ok) { item = items.front(); items.pop_front(); }
+		pthread_cond_signal(&not_full);
+		pthread_mutex_unlock(&lock);
+		return ok;
+	}
+
+	bool empty() {
+		pthread_mutex_lock(&lock);
+		bool ans = items.empty();
+		pthread_mutex_unlock(&lock);
+		return ans;
+	}
+
+	// a producer is done: the consumers are released once all are done
+	void producerDone() {
+		pthread_mutex_lock(&lock);
+		--num_producers;
+		pthread_cond_broadcast(&not_empty);
+		pthread_mutex_unlock(&lock);
+	}
+
+	// stop accepting items (the consumers are gone): release the producers
+	void close() {
+		pthread_mutex_lock(&lock);
+		closed = true;
+		pthread_cond_broadcast(&not_full);
+		pthread_cond_broadcast(&not_empty);
+		pthread_mutex_unlock(&lock);
+	}
+
+private:
+
+	deque<T> items;
+	int capacity;
+	int num_producers;
+	bool closed;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+
+	static double now() {
+		struct timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return t.tv_sec + t.tv_nsec / 1000000000.0;
+	}
+};
+
+// WindowBatch_t
+// window with its tumor and normal reads, ready to be assembled
+//////////////////////////////////////////////////////////////////////////
+class WindowBatch_t
+{
+public:
+
+	int wid; // index of the window in the queue
+	Ref_t * refinfo; // NULL if the window is skipped (pre-scan) or completed (resume)
+	bool failed; // the BAM region could not be reached
+	ReadBuffer_t bufferT; // reads of the window (detached from the BAM files)
+	ReadBuffer_t bufferN;
+
+	WindowBatch_t(int wid_, Ref_t * refinfo_) : wid(wid_), refinfo(refinfo_), failed(false) { }
+	~WindowBatch_t() { delete refinfo; }
+};
+
+// WindowResult_t
+// variants reported by an assembly thread for a window
+//////////////////////////////////////////////////////////////////////////
+class WindowResult_t
+{
+public:
+
+	int wid;
+	vector<Variant_t> variants;
+
+	WindowResult_t(int wid_) : wid(wid_) { }
+};
+
+class Pipeline_t
+{
+public:
+
+	// configuration of the reader threads
+	string TUMOR;
+	string NORMAL;
+	RefProvider_t * reference; // shared by all the threads
+	ReaderOptions_t * reader_opts; // backend of the alignment readers (NULL = bamtools)
+	int MIN_MAP_QUAL;
+	int minK;
+	int maxK;
+
+	VariantDB_t db; // variants of all the windows (owned by the collector)
+	Journal_t * journal; // journal of the completed windows (NULL if disabled)
+	Filters * filters;
+
+	double read_time; // time spent by the reader threads fetching reads (in seconds)
+	long num_alignments; // alignments passed to the assembly threads
+	bool failed; // a reader thread could not open the BAM files or the journal could not be written
+
+	Pipeline_t(WindowQueue_t * queue_, int num_readers_, int num_workers_, bool lrmode);
+
+	bool start();
+	WindowBatch_t * nextBatch();
+	void collect(int wid, vector<Variant_t> & variants);
+	void workerDone();
+	void join();
+
+	double readerWait() { return ready.push_wait; }
+	double workerWait() { return ready.pop_wait; }
+
+private:
+
+	WindowQueue_t * queue;
+	int num_readers;
+	int num_workers;
+	vector<pthread_t> readers;
+	pthread_t collector;
+	BoundedQueue_t<WindowBatch_t *> ready; // windows with their reads
+	BoundedQueue_t<WindowResult_t *> results; // variants of the assembled windows
+	pthread_mutex_t stats_lock;
+
+	static void * readerThread(void * ptr);
+	static void * collectorThread(void * ptr);
+	void readWindows();
+	void collectVariants();
+	void journalFailed();
+	void stopReaders(int num_started);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "ReadArena.hh"
+
+/****************************************************************************
+** ReadArena.cc
+**
+** Storage of the reads of a window: 2-bit packed bases, quality values
+** and interned strings
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+static const char BASES[4] = { 'A', 'C', 'G', 'T' };
+
+// 2-bit code of a base (-1 if it cannot be packed)
+static inline int baseCode(char b) {
+	switch(b) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+	}
+	return -1;
+}
+
+// unique copy of a string (valid until the arena is cleared)
+//////////////////////////////////////////////////////////////
+const string * ReadArena_t::intern(const string & str) {
+	return &(*strings.insert(str).first);
+}
+
+// store the trimmed bases and quality values of a read (nothing for junk reads)
+//////////////////////////////////////////////////////////////
+void ReadArena_t::store(ReadInfo_t & info, const string & seq, const string & qv) {
+
+	info.len_m = 0;
+	if (info.isjunk) { return; }
+
+	int len = seq.length() - info.trm5 - info.trm3;
+	if (len <= 0) { return; }
+	info.len_m = len;
+
+	const char * s = seq.data() + info.trm5;
+
+	// quality values (missing values count as the lowest quality)
+	info.qv_m = qvs.length();
+	if ((int)qv.length() > info.trm5) { qvs.append(qv, info.trm5, len); }
+	qvs.resize(info.qv_m + len, 0);
+
+	info.packed_m = true;
+	for (int i = 0; i < len; ++i) {
+		if (baseCode(s[i]) < 0) { info.packed_m = false; break; }
+	}
+
+	if (!info.packed_m) {
+		info.seq_m = raw.length();
+		raw.append(s, len);
+		return;
+	}
+
+	info.seq_m = num_bases;
+	packed.resize((num_bases + len + 31) / 32, 0);
+	for (int i = 0; i < len; ++i) {
+		size_t pos = num_bases + i;
+		packed[pos >> 5] |= ((uint64_t)baseCode(s[i])) << ((pos & 31) << 1);
+	}
+	num_bases += len;
+}
+
+// k bases of a read from offset (in the trimmed read)
+//////////////////////////////////////////////////////////////
+void ReadArena_t::kmer(const ReadInfo_t & info, int offset, int k, string & mer) const {
+
+	if (!info.packed_m) { mer.assign(raw, info.seq_m + offset, k); return; }
+
+	mer.resize(k);
+	size_t pos = info.seq_m + offset;
+	for (int i = 0; i < k; ++i, ++pos) {
+		mer[i] = BASES[(packed[pos >> 5] >> ((pos & 31) << 1)) & 3];
+	}
+}
+
+// release the reads of the window
+//////////////////////////////////////////////////////////////
+void ReadArena_t::clear() {
+
+	vector<uint64_t>().swap(packed);
+	num_bases = 0;
+	string().swap(raw);
+	string().swap(qvs);
+	unordered_set<string>().swap(strings);
+}
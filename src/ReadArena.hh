@@ -0,0 +1,63 @@
+#ifndef READARENA_HH
+#define READARENA_HH 1
+
+/****************************************************************************
+** ReadArena.hh
+**
+** Storage of the reads of a window: the trimmed bases are 2-bit packed,
+** the quality values kept in one byte array and the names, sample labels
+** and barcodes interned, so a ReadInfo_t is only a view in the arena.
+** The k-mers are extracted straight from the packed bases and the whole
+** arena is released at once with the graph
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "ReadInfo.hh"
+
+using namespace std;
+
+class ReadArena_t
+{
+public:
+
+	ReadArena_t() : num_bases(0) { }
+
+	const string * intern(const string & str);
+	void store(ReadInfo_t & info, const string & seq, const string & qv);
+
+	void kmer(const ReadInfo_t & info, int offset, int k, string & mer) const;
+	void sequence(const ReadInfo_t & info, string & seq) const { kmer(info, 0, info.len_m, seq); }
+	const char * quals(const ReadInfo_t & info) const { return qvs.data() + info.qv_m; }
+
+	void clear();
+
+private:
+
+	vector<uint64_t> packed; // 2-bit encoded bases (32 per word)
+	size_t num_bases;
+	string raw; // bases of the reads with other characters (e.g. N in the reference)
+	string qvs; // quality values
+	unordered_set<string> strings; // interned names, sample labels and barcodes
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "ReadBuffer.hh"
+
+/****************************************************************************
+** ReadBuffer.cc
+**
+** Rolling buffer of alignments shared by consecutive (overlapping) windows.
+** The BAM file is scanned forward once: reads that left the window are
+** dropped from the front and only the alignments past the last read
+** fetched are loaded from the file, so each record is decoded only once
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// move the buffer to a new window
+// the file is scanned forward if the window follows the previous one,
+// otherwise the reader jumps to the window's left boundary
+// (a detached buffer only drops the reads that left the window)
+// returns false if the jump to the region's left boundary failed
+//////////////////////////////////////////////////////////////
+bool ReadBuffer_t::setWindow(const BamRegion & region) {
+
+	int gap = region.RightPosition - region.LeftPosition; // max distance to scan through
+
+	if( (reader != NULL) && ((region.LeftRefID != refid) || (region.LeftPosition < left) || (region.LeftPosition > last_pos + gap)) ) {
+		if(!jump(region)) { return false; }
+	}
+
+	left = region.LeftPosition;
+	right = region.RightPosition;
+
+	// drop reads that ended before the window
+	while( !reads.empty() && (reads.front().al.Position < left) && (reads.front().end <= left) ) {
+		reads.pop_front();
+	}
+
+	// load reads up to the first one starting after the window
+	while( !eof && (last_pos < right) ) {
+
+		BufferedRead_t r;
+		if( !reader->getNextAlignmentCore(r.al) || (r.al.RefID != refid) ) { eof = true; break; }
+
+		r.end = r.al.GetEndPosition();
+		last_pos = r.al.Position;
+		reads.push_back(r);
+		++num_loaded;
+	}
+
+	return true;
+}
+
+// jump to the left boundary of the region and reset the buffer
+// (the region is left open so that the following windows are streamed)
+//////////////////////////////////////////////////////////////
+bool ReadBuffer_t::jump(const BamRegion & region) {
+
+	reads.clear();
+	refid = region.LeftRefID;
+	left = region.LeftPosition;
+	last_pos = region.LeftPosition;
+	eof = false;
+	++num_jumps;
+
+	BamRegion open_region(region.LeftRefID, region.LeftPosition);
+	if(!reader->setRegion(open_region)) { eof = true; refid = -1; return false; }
+
+	return true;
+}
+
+// copy the alignments of the current window of source that lie within
+// region and pass the mapping quality and duplicate filters applied to all
+// the reads of a window, decoding their character data
+// the copy is detached from the BAM file: it can be moved to another thread
+// and only serves windows within region
+//////////////////////////////////////////////////////////////
+void ReadBuffer_t::snapshot(const ReadBuffer_t & source, const BamRegion & region, int min_mapq) {
+
+	reader = NULL;
+	reads.clear();
+	refid = region.LeftRefID;
+	left = region.LeftPosition;
+	right = region.RightPosition;
+	last_pos = source.last_pos;
+	eof = true;
+
+	for (deque<BufferedRead_t>::const_iterator it = source.reads.begin(); it != source.reads.end(); ++it) {
+
+		const BufferedRead_t & r = *it;
+		if( !source.inWindow(r) ) { continue; }
+		if( (r.al.Position < left) || (r.end > right) ) { continue; } // partially outside the region
+		if( (r.al.MapQuality < min_mapq) || r.al.IsDuplicate() ) { continue; }
+
+		reads.push_back(r);
+		reads.back().al.BuildCharData();
+		++num_loaded;
+	}
+}
+
+// check if the alignment overlaps the current window
+// (same test used by BamReader for the alignments in a region)
+//////////////////////////////////////////////////////////////
+bool ReadBuffer_t::inWindow(const BufferedRead_t & r) const {
+
+	if(r.al.Position >= left) { return (r.al.Position < right); }
+	return (r.end > left);
+}
@@ -0,0 +1,79 @@
+#ifndef READBUFFER_HH
+#define READBUFFER_HH 1
+
+/****************************************************************************
+** ReadBuffer.hh
+**
+** Rolling buffer of alignments shared by consecutive (overlapping) windows.
+** The BAM file is scanned forward once: reads that left the window are
+** dropped from the front and only the alignments past the last read
+** fetched are loaded from the file, so each record is decoded only once
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <deque>
+
+#include "api/BamReader.h"
+
+#include "AlignmentReader.hh"
+
+using namespace std;
+using namespace BamTools;
+
+// BufferedRead_t
+// alignment in the buffer with its (cached) end position
+//////////////////////////////////////////////////////////////////////////
+class BufferedRead_t
+{
+public:
+	BamAlignment al;
+	int end; // end position (half-open)
+};
+
+class ReadBuffer_t
+{
+public:
+
+	deque<BufferedRead_t> reads; // alignments in BAM order
+
+	ReadBuffer_t(AlignmentReader_t & reader_) : reader(&reader_), refid(-1), left(0), right(0), last_pos(0), eof(true), num_loaded(0), num_jumps(0) { }
+	ReadBuffer_t() : reader(NULL), refid(-1), left(0), right(0), last_pos(0), eof(true), num_loaded(0), num_jumps(0) { } // detached buffer (see snapshot)
+
+	bool setWindow(const BamRegion & region);
+	void snapshot(const ReadBuffer_t & source, const BamRegion & region, int min_mapq);
+	bool inWindow(const BufferedRead_t & r) const;
+
+	int numLoaded() { return num_loaded; }
+	int numJumps() { return num_jumps; }
+
+private:
+
+	AlignmentReader_t * reader; // NULL if detached from the BAM file
+	int refid; // reference id of the current window
+	int left; // current window [left,right)
+	int right;
+	int last_pos; // start position of the last alignment loaded
+	bool eof; // no more alignments on this reference
+	int num_loaded; // alignments loaded from the BAM file
+	int num_jumps; // number of random accesses in the BAM file
+
+	bool jump(const BamRegion & region);
+};
+
+#endif
@@ -44,26 +44,30 @@ typedef int ReadId_t;
 class ReadInfo_t
 {
 public:
-	ReadInfo_t(const int label, const string & set, const string & readname, const string & seq, const string & qv, char code, unsigned int strnd, unsigned int mate_order, const string & bx, const int hp)
-		: label_m(label), set_m(set), readname_m(readname), seq_m(seq), qv_m(qv), code_m(code), mateid_m(-1), strand(strnd), mate_order_m(mate_order), BX(bx), HP(hp), trm5(0), trm3(0), isjunk(false)
+	ReadInfo_t(const int label, const string * set, const string * readname, char code, unsigned int strnd, unsigned int mate_order, const string * bx, const int hp)
+		: label_m(label), set_m(set), readname_m(readname), code_m(code), mateid_m(-1), strand(strnd), mate_order_m(mate_order), BX(bx), HP(hp), trm5(0), trm3(0), isjunk(false), len_m(0), seq_m(0), qv_m(0), packed_m(true)
 		{ }
 
 	int            label_m;
-	string         set_m;
-	string         readname_m;
-	string         seq_m;
-	string         qv_m;
+	const string * set_m; // interned in the read arena
+	const string * readname_m; // interned in the read arena
 	char           code_m;
 	ReadId_t       mateid_m;
 	unsigned short strand; // FWD or REV
 	unsigned short mate_order_m; // is first or second mate? (1=first, 2=mate, 0=unmated)
-	string         BX;
+	const string * BX; // interned in the read arena
 	int 		   HP;
 	Mer_t          contigid_m;
 	unsigned int   readstartidx_m;
 	unsigned short trm5;
 	unsigned short trm3;
 	bool           isjunk;
+
+	// trimmed read in the arena (not stored for junk reads)
+	unsigned int   len_m; // number of bases
+	size_t         seq_m; // index of the first base
+	size_t         qv_m; // index of the first quality value
+	bool           packed_m; // 2-bit encoded bases (only A,C,G,T)
 };
 
 typedef vector<ReadInfo_t> ReadInfoList_t;
@@ -132,6 +132,7 @@ void Ref_t::updateCoverage(const string & cmer, int cov, unsigned int strand, in
 	
 	if(sample == TMR)      { mertable = mertable_tmr; }
 	else if(sample == NML) { mertable = mertable_nml; }
+	else if(sample >= SMP) { mertable = smpMertable(sample-SMP); }
 	else { cerr << "Error: unrecognized sample " << sample << endl; }
 	
 	assert(mertable != NULL);
@@ -148,6 +149,24 @@ void Ref_t::updateCoverage(const string & cmer, int cov, unsigned int strand, in
 	}
 }
 
+// mer table of tumor s (multi-tumor mode)
+// the tables are created on first use with the reference mers
+unordered_map<string,cov_t> * Ref_t::smpMertable(unsigned int s) {
+	indexMers();
+	
+	while (mertable_smp.size() <= s) {
+		mertable_smp.push_back(unordered_map<string,cov_t>());
+		smp_coverage.push_back(vector<cov_t>(rawseq.size()));
+		
+		cov_t c = {0,0,0,0,0,0,0,0,0,0};
+		std::unordered_map<string,cov_t>::iterator it;
+		for (it = mertable_nml->begin(); it != mertable_nml->end(); ++it) {
+			mertable_smp.back().insert(std::pair<string,cov_t>(it->first,c));
+		}
+	}
+	return &mertable_smp[s];
+}
+
 // updated haplotype coverage for input mer
 void Ref_t::updateHPCoverage(const string & cmer, int hp0_cov, int hp1_cov, int hp2_cov, int sample) {
 	indexMers();
@@ -178,6 +197,7 @@ void Ref_t::computeCoverage(int sample) {
 	
 	if(sample == TMR)      { mertable = mertable_tmr; coverage = tumor_coverage; }
 	else if(sample == NML) { mertable = mertable_nml; coverage = normal_coverage; }
+	else if(sample >= SMP) { mertable = smpMertable(sample-SMP); coverage = &smp_coverage[sample-SMP]; }
 	else { cerr << "Error: unrecognized sample " << sample << endl; }
 	
 	assert(mertable != NULL);
@@ -252,15 +272,20 @@ void Ref_t::computeCoverage(int sample) {
 // return k-mer coverage struct at position 
 cov_t Ref_t::getCovStructAt(unsigned pos, int sample) {
 	
+	cov_t c = {0,0,0,0,0,0,0,0,0,0};
+	
 	vector<cov_t> * coverage = NULL;
 	if(sample == NML) { coverage = normal_coverage; }
 	else if(sample == TMR) { coverage = tumor_coverage; }
+	else if(sample >= SMP) { // tumor without reads on the reference k-mers
+		if((unsigned int)(sample-SMP) >= smp_coverage.size()) { return c; }
+		coverage = &smp_coverage[sample-SMP];
+	}
 	else { cerr << "Error: unknown sample " << sample << endl; }
 	
 	assert(coverage != NULL);
 	//if (coverage == NULL) { cerr << "Error: null pointer to coverage vector!" << endl; } 
 	
-	cov_t c = {0,0,0,0,0,0,0,0,0,0};
 	if(coverage->size()>pos) {c = coverage->at(pos); }
 	
 	return c;
@@ -363,6 +388,9 @@ void Ref_t::clear() {
 	if(normal_coverage != NULL) { normal_coverage->clear(); vector<cov_t>().swap(*normal_coverage); delete normal_coverage; normal_coverage = NULL; }
 	if(tumor_coverage != NULL)  { tumor_coverage->clear();  vector<cov_t>().swap(*tumor_coverage);  delete tumor_coverage;  tumor_coverage = NULL;  }
 	
+	mertable_smp.clear(); vector< unordered_map<string,cov_t> >().swap(mertable_smp);
+	smp_coverage.clear(); vector< vector<cov_t> >().swap(smp_coverage);
+	
 	bx_table_tmr.clear(); unordered_map<Mer_t,set<string>>().swap(bx_table_tmr);
 	bx_table_nml.clear(); unordered_map<Mer_t,set<string>>().swap(bx_table_nml);
 }
@@ -35,6 +35,7 @@
 
 #define TMR 4
 #define NML 5
+#define SMP 6 // tumor t of a multi-tumor run has its own colour SMP+t (its reads are also counted as TMR)
 
 using namespace std;
 
@@ -63,6 +64,7 @@ public:
 	string rawseq;
 
 	string refchr;
+	int refid; // reference id in the BAM header
 	int refstart;
 	int refend;
 
@@ -84,10 +86,13 @@ public:
 	vector<cov_t> * normal_coverage; // normal k-mer coverage across the reference
 	vector<cov_t> * tumor_coverage; // tumor k-mer coverage across the reference
 	
+	vector< unordered_map<string,cov_t> > mertable_smp; // mer counts of each tumor (multi-tumor mode)
+	vector< vector<cov_t> > smp_coverage; // k-mer coverage of each tumor across the reference (multi-tumor mode)
+	
 	unordered_map<Mer_t,set<string>> bx_table_tmr; // mer to barcode map for tumor
 	unordered_map<Mer_t,set<string>> bx_table_nml; // mer to barcode map for normal
 	
-	Ref_t(int k) : indexed_m(0) 
+	Ref_t(int k) : refid(-1), indexed_m(0) 
 	{
 		K = k; 
 		mertable_nml = NULL;
@@ -98,10 +103,7 @@ public:
 	
 	~Ref_t() { // destructor
 		//cerr << "Ref_t " << hdr << " destructor called" << endl;
-		if(mertable_nml != NULL)    { mertable_nml->clear(); unordered_map<string,cov_t>().swap(*mertable_nml); mertable_nml = NULL;  }
-		if(mertable_tmr != NULL)    { mertable_tmr->clear(); unordered_map<string,cov_t>().swap(*mertable_tmr); mertable_tmr = NULL;  }
-		if(normal_coverage != NULL) { normal_coverage->clear(); vector<cov_t>().swap(*normal_coverage); normal_coverage = NULL; }
-		if(tumor_coverage != NULL)  { tumor_coverage->clear();  vector<cov_t>().swap(*tumor_coverage); tumor_coverage = NULL;  }		
+		clear();
 	}
 	
 	void setHdr(string hdr_) { hdr = hdr_; }
@@ -117,6 +119,8 @@ public:
 	void updateCoverage(const string & cmer, int cov, unsigned int strand, int sample);
 	void updateHPCoverage(const string & cmer, int hp0_cov, int hp1_cov, int hp2_cov, int sample);
 	void computeCoverage(int sample);
+	unordered_map<string,cov_t> * smpMertable(unsigned int s);
+	int numSamples() { return mertable_smp.size(); }
 	
 	void addBX(const string & bx, Mer_t & mer, int sample);	
 	string getBXsetAt(int start, int end, string & rseq, int sample);
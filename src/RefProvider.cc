@@ -0,0 +1,194 @@
+#include "RefProvider.hh"
+
+/****************************************************************************
+** RefProvider.cc
+**
+** Reference genome shared by all the threads: the FASTA index is loaded
+** once and an uncompressed FASTA is memory-mapped
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+RefProvider_t::RefProvider_t() : fai(NULL), map_base(NULL), map_size(0) {
+
+	// same conversion as toupper + isAmbiguos
+	for (int c = 0; c < 256; ++c) {
+		char b = toupper(c);
+		norm[c] = isAmbiguos(b) ? 'N' : b;
+	}
+	pthread_mutex_init(&fai_lock, NULL);
+}
+
+RefProvider_t::~RefProvider_t() {
+	close();
+	pthread_mutex_destroy(&fai_lock);
+}
+
+// load the FASTA index (built if missing) and map the FASTA if uncompressed
+//////////////////////////////////////////////////////////////
+bool RefProvider_t::open(const string & filename) {
+
+	close();
+
+	fai = fai_load(filename.c_str());
+	if ( !fai ) { cerr << "Could not load fai index of " << filename << endl; return false; }
+
+	// fall back to htslib if the FASTA is compressed or cannot be mapped
+	if ( !mapFasta(filename) || !loadEntries(filename + ".fai") ) {
+		if (map_base != NULL) { munmap(map_base, map_size); map_base = NULL; map_size = 0; }
+		entries.clear();
+	}
+
+	return true;
+}
+
+// release the mapping and the FASTA index
+//////////////////////////////////////////////////////////////
+void RefProvider_t::close() {
+
+	if (map_base != NULL) { munmap(map_base, map_size); map_base = NULL; map_size = 0; }
+	entries.clear();
+	if (fai != NULL) { fai_destroy(fai); fai = NULL; }
+}
+
+// map the FASTA file in memory (false if it is bgzip-compressed)
+//////////////////////////////////////////////////////////////
+bool RefProvider_t::mapFasta(const string & filename) {
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) { return false; }
+
+	struct stat st;
+	if ( (fstat(fd, &st) != 0) || (st.st_size < 2) ) { ::close(fd); return false; }
+
+	void * addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) { return false; }
+
+	map_base = (char *)addr;
+	map_size = st.st_size;
+
+	// gzip magic number
+	if ( ((unsigned char)map_base[0] == 0x1f) && ((unsigned char)map_base[1] == 0x8b) ) { return false; }
+
+	return true;
+}
+
+// read the layout of the sequences from the .fai file
+//////////////////////////////////////////////////////////////
+bool RefProvider_t::loadEntries(const string & fai_file) {
+
+	ifstream in(fai_file.c_str());
+	if ( !in.is_open() ) { return false; }
+
+	string line;
+	vector<string> tokens;
+	while (getline(in, line)) {
+		if (line.empty()) { continue; }
+		istringstream iss(line);
+		string token;
+		tokens.clear();
+		while (getline(iss, token, '\t')) { tokens.push_back(token); }
+		if (tokens.size() < 5) { return false; }
+
+		FaiEntry_t e;
+		e.len = atol(tokens[1].c_str());
+		e.offset = atol(tokens[2].c_str());
+		e.line_bases = atol(tokens[3].c_str());
+		e.line_width = atol(tokens[4].c_str());
+		if ( (e.line_bases <= 0) || (e.line_width < e.line_bases) ) { return false; }
+
+		// last byte of the sequence must be in the file
+		long last = e.offset + ((e.len - 1) / e.line_bases) * e.line_width + (e.len - 1) % e.line_bases;
+		if ( (e.len > 0) && (last >= (long)map_size) ) { return false; }
+
+		entries[tokens[0]] = e;
+	}
+
+	return true;
+}
+
+// length of a reference sequence (-1 if not found)
+//////////////////////////////////////////////////////////////
+int RefProvider_t::seqLength(const string & chr) {
+
+	if (map_base != NULL) {
+		unordered_map<string, FaiEntry_t>::iterator it = entries.find(chr);
+		return (it == entries.end()) ? -1 : (int)it->second.len;
+	}
+	return faidx_seq_len(fai, chr.c_str());
+}
+
+// sequence in [beg,end] (0-based, inclusive, clipped to the sequence like
+// faidx_fetch_seq), optionally in upper case with the IUPAC ambiguous codes
+// changed to N; false if the sequence is not found
+//////////////////////////////////////////////////////////////
+bool RefProvider_t::fetch(const string & chr, int beg, int end, string & seq, bool normalize) {
+
+	seq.clear();
+
+	if (map_base == NULL) {
+		pthread_mutex_lock(&fai_lock);
+		int seq_len = 0;
+		char * s = faidx_fetch_seq(fai, chr.c_str(), beg, end, &seq_len);
+		pthread_mutex_unlock(&fai_lock);
+
+		if ( (s == NULL) || (seq_len < 0) ) { free(s); return false; }
+		seq.assign(s, s + seq_len);
+		free(s);
+
+		if (normalize) {
+			for (unsigned int k = 0; k < seq.length(); ++k) { seq[k] = norm[(unsigned char)seq[k]]; }
+		}
+		return true;
+	}
+
+	unordered_map<string, FaiEntry_t>::iterator it = entries.find(chr);
+	if (it == entries.end()) { return false; }
+	const FaiEntry_t & e = it->second;
+	if (e.len <= 0) { return true; }
+
+	long b = (end < beg) ? end : beg;
+	long z = end;
+	if (b < 0) { b = 0; } else if (b >= e.len) { b = e.len - 1; }
+	if (z < 0) { z = 0; } else if (z >= e.len) { z = e.len - 1; }
+
+	seq.resize(z - b + 1);
+	char * out = &seq[0];
+
+	// copy line by line, skipping the line terminators
+	long pos = b;
+	while (pos <= z) {
+		long col = pos % e.line_bases;
+		long n = min(e.line_bases - col, z - pos + 1);
+		const char * src = map_base + e.offset + (pos / e.line_bases) * e.line_width + col;
+		if (normalize) {
+			for (long k = 0; k < n; ++k) { out[k] = norm[(unsigned char)src[k]]; }
+		}
+		else { memcpy(out, src, n); }
+		out += n;
+		pos += n;
+	}
+
+	return true;
+}
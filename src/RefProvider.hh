@@ -0,0 +1,86 @@
+#ifndef REFPROVIDER_HH
+#define REFPROVIDER_HH 1
+
+/****************************************************************************
+** RefProvider.hh
+**
+** Reference genome shared by all the threads: the FASTA index is loaded
+** once and an uncompressed FASTA is memory-mapped, so the sequence of a
+** window is copied (and normalized) straight from the page cache.
+** bgzip-compressed FASTA files are read through htslib, one thread at a time
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <pthread.h>
+
+#include "htslib/faidx.h"
+
+#include "util.hh"
+
+using namespace std;
+
+// FaiEntry_t
+// line of the .fai index: layout of a sequence in the FASTA file
+//////////////////////////////////////////////////////////////////////////
+class FaiEntry_t
+{
+public:
+
+	long len; // number of bases
+	long offset; // file offset of the first base
+	long line_bases; // bases per line
+	long line_width; // bytes per line (including the newline)
+
+	FaiEntry_t() : len(0), offset(0), line_bases(0), line_width(0) { }
+};
+
+class RefProvider_t
+{
+public:
+
+	RefProvider_t();
+	~RefProvider_t();
+
+	bool open(const string & filename);
+	void close();
+	bool isOpen() { return (fai != NULL); }
+	bool isMapped() { return (map_base != NULL); }
+
+	int seqLength(const string & chr);
+	bool fetch(const string & chr, int beg, int end, string & seq, bool normalize = true);
+
+private:
+
+	faidx_t * fai; // FASTA index (compressed FASTA and sequence lengths)
+	char * map_base; // memory-mapped FASTA (NULL if compressed)
+	size_t map_size;
+	unordered_map<string, FaiEntry_t> entries; // layout of the sequences in the mapped FASTA
+	char norm[256]; // upper case, IUPAC ambiguous codes to N
+	pthread_mutex_t fai_lock; // the htslib reader is not thread safe
+
+	bool loadEntries(const string & fai_file);
+	bool mapFasta(const string & filename);
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include "Server.hh"
+
+/****************************************************************************
+** Server.cc
+**
+** Long-running server mode: listens on a Unix domain socket and answers
+** region requests with VCF records, keeping the BAM readers, the indexes
+** and the reference of the engine open between requests
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <string.h>
+
+// check the format of a region (chr or chr:start-end)
+//////////////////////////////////////////////////////////////
+static bool validRegion(const string & region) {
+
+	size_t x = region.find_first_of(':');
+	if (x == string::npos) { return (region.length() > 0); }
+	if (x == 0) { return false; }
+
+	size_t y = region.find_first_of('-', x);
+	if (y == string::npos) { return false; }
+
+	string start = region.substr(x+1, y-x-1);
+	string end = region.substr(y+1);
+	if (start.empty() || end.empty() || start.length() > 9 || end.length() > 9) { return false; }
+	if (start.find_first_not_of("0123456789") != string::npos) { return false; }
+	if (end.find_first_not_of("0123456789") != string::npos) { return false; }
+
+	return (atoi(start.c_str()) <= atoi(end.c_str()));
+}
+
+// length of a contig of the BAM headers (-1 if unknown)
+//////////////////////////////////////////////////////////////
+static int contigLength(const RefVector & refs, const string & name) {
+
+	for (unsigned int i = 0; i < refs.size(); ++i) {
+		if (refs[i].RefName == name) { return refs[i].RefLength; }
+	}
+	return -1;
+}
+
+// listen on the socket and answer the requests (one at a time) until a
+// shutdown request (0 on success, -1 if the socket cannot be created)
+//////////////////////////////////////////////////////////////
+int LancetServer_t::run() {
+
+	struct sockaddr_un addr;
+	if (socket_path.length() >= sizeof(addr.sun_path)) {
+		cerr << "ERROR: socket path too long: " << socket_path << endl;
+		return -1;
+	}
+
+	// remove the socket of a previous server
+	struct stat st;
+	if (stat(socket_path.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			cerr << "ERROR: " << socket_path << " exists and is not a socket" << endl;
+			return -1;
+		}
+		unlink(socket_path.c_str());
+	}
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		cerr << "ERROR: could not create the socket (" << strerror(errno) << ")" << endl;
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path)-1);
+
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+		cerr << "ERROR: could not listen on " << socket_path << " (" << strerror(errno) << ")" << endl;
+		close(sock);
+		return -1;
+	}
+
+	cerr << "Listening on " << socket_path << endl;
+
+	bool running = true;
+	while (running) {
+		int fd = accept(sock, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR) { continue; }
+			cerr << "ERROR: accept failed (" << strerror(errno) << ")" << endl;
+			break;
+		}
+		// a client that stops sending cannot block the server
+		struct timeval tv;
+		tv.tv_sec = REQUEST_TIMEOUT; tv.tv_usec = 0;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+		running = handle(fd);
+		close(fd);
+	}
+
+	close(sock);
+	unlink(socket_path.c_str());
+	cerr << "Server stopped after " << num_requests << " requests" << endl;
+
+	return 0;
+}
+
+// read the lines of a request up to an empty line or the end of the stream
+//////////////////////////////////////////////////////////////
+bool LancetServer_t::readRequest(int fd, vector<string> & lines) {
+
+	string line;
+	char buf[4096];
+
+	while (true) {
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n < 0) { lines.clear(); return true; } // timeout: drop the request
+		if (n == 0) { break; }
+
+		for (ssize_t i = 0; i < n; ++i) {
+			if (buf[i] != '\n') { line += buf[i]; continue; }
+
+			// trim whitespace (and the CR of CRLF line endings)
+			size_t b = line.find_first_not_of(" \t\r");
+			size_t e = line.find_last_not_of(" \t\r");
+			line = (b == string::npos) ? "" : line.substr(b, e-b+1);
+
+			if (line.empty()) { return true; }
+			lines.push_back(line);
+			line.clear();
+			if (lines.size() > MAX_REQUEST_LINES) { return false; }
+		}
+	}
+
+	// last line without newline
+	size_t b = line.find_first_not_of(" \t\r");
+	if (b != string::npos) {
+		size_t e = line.find_last_not_of(" \t\r");
+		lines.push_back(line.substr(b, e-b+1));
+	}
+	return (lines.size() <= MAX_REQUEST_LINES);
+}
+
+// write the whole buffer (the client may have closed the connection)
+//////////////////////////////////////////////////////////////
+bool LancetServer_t::writeAll(int fd, const string & data) {
+
+	size_t sent = 0;
+	while (sent < data.length()) {
+		ssize_t n = send(fd, data.data() + sent, data.length() - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) { return false; }
+		sent += n;
+	}
+	return true;
+}
+
+// answer one request (false after a shutdown request)
+//////////////////////////////////////////////////////////////
+bool LancetServer_t::handle(int fd) {
+
+	vector<string> regions;
+	if (!readRequest(fd, regions)) {
+		writeAll(fd, "##error=too many regions in the request (max " + itos(MAX_REQUEST_LINES) + ")\n");
+		return true;
+	}
+	if (regions.empty()) { return true; }
+
+	if (regions.size() == 1 && regions[0] == "shutdown") {
+		writeAll(fd, "##shutdown\n");
+		return false;
+	}
+
+	for (unsigned int r = 0; r < regions.size(); ++r) {
+		if (!validRegion(regions[r])) {
+			writeAll(fd, "##error=invalid region " + regions[r] + " (expected chr:start-end)\n");
+			return true;
+		}
+
+		// the region must lie on a contig of the BAM headers
+		size_t x = regions[r].find_first_of(':');
+		string chr = regions[r].substr(0, x);
+		int len = contigLength(engine->getReferences(), chr);
+		if (len < 0) {
+			writeAll(fd, "##error=unknown contig " + chr + "\n");
+			return true;
+		}
+		if ( (x != string::npos) && (atoi(regions[r].substr(regions[r].find_first_of('-', x)+1).c_str()) > len) ) {
+			writeAll(fd, "##error=invalid region " + regions[r] + " (end past the length " + itos(len) + " of " + chr + ")\n");
+			return true;
+		}
+	}
+
+	++num_requests;
+	cerr << "Request " << num_requests << ": " << regions.size() << " region(s)" << endl;
+
+	struct timespec start, finish;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	LancetResult_t result;
+	if (engine->run(regions, "", result) < 0) {
+		writeAll(fd, "##error=variant calling failed\n");
+		return true;
+	}
+
+	stringstream vcf;
+	engine->printVCF(result, VERSION, vcf);
+	writeAll(fd, vcf.str());
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	double elapsed = (finish.tv_sec - start.tv_sec);
+	elapsed += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+	cerr << "Request " << num_requests << ": " << result.db.getNumVariants() << " variants (" << elapsed << " seconds)" << endl;
+
+	return true;
+}
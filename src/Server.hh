@@ -0,0 +1,67 @@
+#ifndef SERVER_HH
+#define SERVER_HH 1
+
+/****************************************************************************
+** Server.hh
+**
+** Long-running server mode: listens on a Unix domain socket and answers
+** region requests with VCF records, keeping the BAM readers, the indexes
+** and the reference of the engine open between requests
+**
+** Protocol: the client sends one region per line (chr:start-end or chr),
+** an empty line (or the end of the stream) closes the request, and the
+** server replies with the VCF of the regions and closes the connection.
+** The request "shutdown" stops the server. A request that is not completed
+** within REQUEST_TIMEOUT seconds is dropped.
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LancetEngine.hh"
+
+using namespace std;
+
+#define MAX_REQUEST_LINES 10000 // max number of regions in one request
+#define REQUEST_TIMEOUT 30 // seconds to wait for the lines of a request
+
+class LancetServer_t
+{
+public:
+
+	string VERSION;
+
+	LancetServer_t(LancetEngine_t * engine_, const string & path) : engine(engine_), socket_path(path), num_requests(0) { }
+
+	int run();
+
+private:
+
+	LancetEngine_t * engine;
+	string socket_path;
+	int num_requests;
+
+	bool handle(int fd);
+	bool readRequest(int fd, vector<string> & lines);
+	bool writeAll(int fd, const string & data);
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "ShardMerge.hh"
+
+/****************************************************************************
+** ShardMerge.cc
+**
+** Merge the VCF files produced by the shards of a run (--shard i/N) into
+** a single VCF. The variants of all shards are combined and selected with
+** the same rules used to merge the variants of the assembly threads
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// merge the shard VCF files and print the merged VCF to stdout
+// all the shards of the run must be present exactly once
+//////////////////////////////////////////////////////////////
+int ShardMerge_t::run(const vector<string> & files) {
+
+	if(files.empty()) {
+		cerr << "Usage: lancet merge <shard VCF> [<shard VCF> ...] > merged.vcf" << endl;
+		return 1;
+	}
+
+	VariantDB_t db;
+	for (unsigned int i = 0; i < files.size(); ++i) {
+		loadShard(files[i], db);
+	}
+
+	string missing;
+	for (int s = 0; s < num_shards; ++s) {
+		if(!loaded[s]) { missing += (missing.empty() ? "" : ",") + itos(s+1); }
+	}
+	if(!missing.empty()) {
+		cerr << "Error: missing shards " << missing << " of " << num_shards << endl;
+		exit(1);
+	}
+
+	cerr << "Merged " << num_shards << " shards: " << db.getNumVariants() << " variants" << endl;
+
+	/***** get current time and date *****/
+	time_t rawtime;
+	time (&rawtime);
+	char* DATE = ctime (&rawtime);
+	/***************************************/
+
+	db.setFilters(&filters);
+	db.setCommandLine(COMMAND_LINE);
+	db.selectVar();
+	db.printToVCF(VERSION, reference, DATE, filters, sample_name_N, sample_name_T);
+
+	return 0;
+}
+
+// add the variants of a shard to the DB
+//////////////////////////////////////////////////////////////
+void ShardMerge_t::loadShard(const string & filename, VariantDB_t & db) {
+
+	ifstream vcf(filename);
+	if (!vcf.is_open()) {
+		cerr << "Couldn't open " << filename << endl;
+		exit(1);
+	}
+
+	int shard = 0;
+	int shards = 0;
+	bool lrmode = false;
+	string fline, ref, nameN, nameT;
+
+	string line;
+	while ( getline(vcf, line) ) {
+
+		if(line.compare(0, 15, "##lancetShard=<") == 0) {
+			shard = headerValue(line, "ID");
+			shards = headerValue(line, "Shards");
+			lrmode = (headerValue(line, "LinkedReads") != 0);
+		}
+		else if(line.compare(0, 22, "##lancetShardFilters=<") == 0) { fline = line; }
+		else if(line.compare(0, 12, "##reference=") == 0) { ref = line.substr(12); }
+		else if(line.compare(0, 6, "#CHROM") == 0) {
+			vector<string> col;
+			istringstream iss(line);
+			string field;
+			while ( getline(iss, field, '\t') ) { col.push_back(field); }
+			if(col.size() >= 11) { nameN = col[9]; nameT = col[10]; }
+			break;
+		}
+	}
+
+	if( (shard < 1) || (shards < 1) || (shard > shards) || fline.empty() ) {
+		cerr << "Error: " << filename << " is not a lancet shard VCF (run with --shard i/N)" << endl;
+		exit(1);
+	}
+
+	// the first shard sets the parameters of the run
+	if(num_shards == 0) {
+		num_shards = shards;
+		loaded.assign(num_shards, false);
+		LR_MODE = lrmode;
+		filters_line = fline;
+		reference = ref;
+		sample_name_N = nameN;
+		sample_name_T = nameT;
+		parseFilters(fline);
+		db.setLRmode(LR_MODE);
+	}
+	else if( (shards != num_shards) || (lrmode != LR_MODE) || (fline != filters_line) || (ref != reference) ||
+			 (nameN != sample_name_N) || (nameT != sample_name_T) ) {
+		cerr << "Error: " << filename << " does not belong to the same run of the previous shards" << endl;
+		exit(1);
+	}
+
+	if(loaded[shard-1]) {
+		cerr << "Error: shard " << shard << "/" << num_shards << " found more than once (" << filename << ")" << endl;
+		exit(1);
+	}
+	loaded[shard-1] = true;
+
+	int num_variants = 0;
+	while ( getline(vcf, line) ) {
+
+		if(line.empty()) { continue; }
+
+		Variant_t v;
+		if(!v.parseVCF(line, LR_MODE)) {
+			cerr << "Error: malformed variant in " << filename << ": " << line << endl;
+			exit(1);
+		}
+		db.addVar(v);
+		++num_variants;
+	}
+	vcf.close();
+
+	cerr << "Shard " << shard << "/" << num_shards << ": " << num_variants << " variants from " << filename << endl;
+}
+
+// integer value of key in a header line with format ##name=<key=value,...>
+//////////////////////////////////////////////////////////////
+int ShardMerge_t::headerValue(const string & line, const string & key) {
+
+	size_t p = line.find("<" + key + "=");
+	if(p == string::npos) { p = line.find("," + key + "="); }
+	if(p == string::npos) { return 0; }
+
+	return atoi(line.c_str() + p + key.length() + 2);
+}
+
+// filter thresholds printed by VariantDB_t::printShardHeader
+//////////////////////////////////////////////////////////////
+void ShardMerge_t::parseFilters(const string & line) {
+
+	size_t b = line.find('<');
+	size_t e = line.rfind('>');
+	istringstream iss(line.substr(b+1, e-b-1));
+
+	string field;
+	while ( getline(iss, field, ',') ) {
+		size_t eq = field.find('=');
+		if(eq == string::npos) { continue; }
+		string key = field.substr(0, eq);
+		double value = atof(field.c_str() + eq + 1);
+
+		if(key == "minPhredFisherSTR") { filters.minPhredFisherSTR = value; }
+		else if(key == "minPhredFisher") { filters.minPhredFisher = value; }
+		else if(key == "maxVafNormal") { filters.maxVafNormal = value; }
+		else if(key == "minVafTumor") { filters.minVafTumor = value; }
+		else if(key == "minCovNormal") { filters.minCovNormal = value; }
+		else if(key == "maxCovNormal") { filters.maxCovNormal = value; }
+		else if(key == "minCovTumor") { filters.minCovTumor = value; }
+		else if(key == "maxCovTumor") { filters.maxCovTumor = value; }
+		else if(key == "minAltCntTumor") { filters.minAltCntTumor = value; }
+		else if(key == "maxAltCntNormal") { filters.maxAltCntNormal = value; }
+		else if(key == "minStrandBias") { filters.minStrandBias = value; }
+	}
+}
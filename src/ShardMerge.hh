@@ -0,0 +1,68 @@
+#ifndef SHARDMERGE_HH
+#define SHARDMERGE_HH 1
+
+/****************************************************************************
+** ShardMerge.hh
+**
+** Merge the VCF files produced by the shards of a run (--shard i/N) into
+** a single VCF. The variants of all shards are combined and selected with
+** the same rules used to merge the variants of the assembly threads
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include "util.hh"
+#include "Variant.hh"
+#include "VariantDB.hh"
+
+using namespace std;
+
+class ShardMerge_t
+{
+public:
+
+	string VERSION;
+	string COMMAND_LINE;
+
+	ShardMerge_t() : LR_MODE(false), num_shards(0) { }
+
+	int run(const vector<string> & files);
+
+private:
+
+	Filters filters;
+	string filters_line; // filter thresholds as printed by the first shard
+	bool LR_MODE;
+	int num_shards;
+	string reference;
+	string sample_name_N;
+	string sample_name_T;
+	vector<bool> loaded; // shards loaded so far
+
+	void loadShard(const string & filename, VariantDB_t & db);
+	void parseFilters(const string & line);
+	int headerValue(const string & line, const string & key);
+};
+
+#endif
@@ -73,6 +73,13 @@ public:
 	vector<cov_t> ref_cov_N;
 	vector<cov_t> ref_cov_T;
 	
+	// each tumor of a multi-tumor run (the tumor coverage above is their sum)
+	vector< vector<cov_t> > alt_cov_S;
+	vector< vector<cov_t> > ref_cov_S;
+	vector<cov_t> min_alt_cov_S;
+	vector<cov_t> min_ref_cov_S;
+	vector<cov_t> mean_ref_cov_S;
+	
 	char prev_bp_ref; // base-pair preceding the mutation in reference
 	char prev_bp_alt; // base-pair preceding the mutation in alternative
 
@@ -117,6 +124,24 @@ public:
 
 		// tumor reference coverage
 		computeStats(ref_cov_T, min_ref_cov_T, min_non0_ref_cov_T, mean_ref_cov_T, mean_non0_ref_cov_T);		
+		
+		// each tumor
+		cov_t min_non0, mean, mean_non0;
+		for (unsigned int s = 0; s < alt_cov_S.size(); ++s) {
+			computeStats(alt_cov_S[s], min_alt_cov_S[s], min_non0, mean, mean_non0);
+			computeStats(ref_cov_S[s], min_ref_cov_S[s], min_non0, mean_ref_cov_S[s], mean_non0);
+		}
+	}
+	
+	// start the coverage of each tumor (multi-tumor mode)
+	void setSmpCov(const vector<cov_t> & alt_cov, const vector<cov_t> & ref_cov) {
+		alt_cov_S.assign(alt_cov.size(), vector<cov_t>());
+		ref_cov_S.assign(ref_cov.size(), vector<cov_t>());
+		addAltCovSmp(alt_cov);
+		addRefCovSmp(ref_cov);
+		min_alt_cov_S = alt_cov;
+		min_ref_cov_S = ref_cov;
+		mean_ref_cov_S = ref_cov;
 	}
 	
 	// compute coverage stats
@@ -229,6 +254,8 @@ public:
 	void addAltCovTmr(cov_t c) { alt_cov_T.push_back(c); }
 	void addRefCovNml(cov_t c) { ref_cov_N.push_back(c); }
 	void addRefCovTmr(cov_t c) { ref_cov_T.push_back(c); }
+	void addAltCovSmp(const vector<cov_t> & c) { for (unsigned int s = 0; s < alt_cov_S.size(); ++s) { alt_cov_S[s].push_back(c[s]); } }
+	void addRefCovSmp(const vector<cov_t> & c) { for (unsigned int s = 0; s < ref_cov_S.size(); ++s) { ref_cov_S[s].push_back(c[s]); } }
 
 	int getAvgCovNfwd() { if(code == 'x') { return mean_alt_cov_N.minqv_fwd; } else { return mean_alt_cov_N.fwd; } }
 	int getAvgCovNrev() { if(code == 'x') { return mean_alt_cov_N.minqv_rev; } else { return mean_alt_cov_N.rev; } }
@@ -271,6 +298,13 @@ public:
 
 	int getAvgRefCovTfwd() { return mean_ref_cov_T.fwd; }
 	int getAvgRefCovTrev() { return mean_ref_cov_T.rev; }
+	
+	int getMinCovSfwd(int s) { if(code == 'x') { return min_alt_cov_S[s].minqv_fwd; } else { return min_alt_cov_S[s].fwd; } }
+	int getMinCovSrev(int s) { if(code == 'x') { return min_alt_cov_S[s].minqv_rev; } else { return min_alt_cov_S[s].rev; } }
+	int getMinRefCovSfwd(int s) { return min_ref_cov_S[s].fwd; }
+	int getMinRefCovSrev(int s) { return min_ref_cov_S[s].rev; }
+	int getAvgRefCovSfwd(int s) { return mean_ref_cov_S[s].fwd; }
+	int getAvgRefCovSrev(int s) { return mean_ref_cov_S[s].rev; }
 
 	int getAvgNon0RefCovNfwd() { return mean_non0_ref_cov_N.fwd; }
 	int getAvgNon0RefCovNrev() { return mean_non0_ref_cov_N.rev; }
@@ -36,7 +36,9 @@ void Variant_t::printSizeOfElements() {
 	
 }
 
-string Variant_t::printVCF(Filters * fs) {
+// in shard mode the variants without support are kept and the fields used
+// to merge the shards (see VariantDB_t::addVar) are added to the INFO column
+string Variant_t::printVCF(Filters * fs, bool shard) {
 	//CHROM  POS     ID      REF     ALT     QUAL    FILTER  INFO    FORMAT  Pat4-FF-Normal-DNA      Pat4-FF-Tumor-DNA
 	string ID = ".";
 	string FILTER = "";
@@ -65,7 +67,7 @@ string Variant_t::printVCF(Filters * fs) {
 	else if(flag == 'S') { status = "SHARED"; }
 	else if(flag == 'L') { status = "LOH"; }
 	else if(flag == 'N') { status = "NORMAL"; }
-	else if(flag == 'E') { status = "NONE"; return ""; } // do not print varaints without support
+	else if(flag == 'E') { status = "NONE"; if(!shard) { return ""; } } // do not print varaints without support
 		
 	string INFO = status + ";FETS=" + dtos(fet_score);
 	if(type=='I') { INFO += ";TYPE=ins"; }
@@ -82,6 +84,8 @@ string Variant_t::printVCF(Filters * fs) {
 	if(!str.empty()) { INFO += ";MS=" + str; } // add STR info
 	//if(strcmp(str,"")!=0) { string str_string(str);  INFO += ";MS=" + str_string; } // add STR info
 	
+	if(shard) { INFO += ";SVC=" + itos(similar_variants_count) + ";SK=" + itos(isSomatic); }
+	
 	double QUAL = fet_score;	
 	// apply filters
 	
@@ -223,6 +227,47 @@ string Variant_t::printVCF(Filters * fs) {
 }
 
 
+// multi-tumor mode: QUAL, FILTER, INFO and the normal sample come from the
+// joint graph of the normal and the pooled tumors, followed by the genotype
+// and coverage of each tumor in that graph
+string Variant_t::printMultiVCF(Filters * fs) {
+	
+	string line = printVCF(fs);
+	if(line.empty()) { return line; }
+	if(line[line.length()-1] == '\n') { line.erase(line.length()-1); }
+	
+	vector<string> col;
+	istringstream iss(line);
+	string field;
+	while ( getline(iss, field, '\t') ) { col.push_back(field); }
+	col.resize(10); // drop the pooled tumor sample
+	
+	string carriers = "";
+	for (unsigned int t = 0; t < tumors.size(); ++t) {
+		col.push_back(printTumorVCF(t));
+		if( (tumors[t][2] + tumors[t][3]) > 0 ) { carriers += (carriers.empty() ? "" : ",") + itos(t+1); }
+	}
+	if(!carriers.empty()) { col[7] += ";TUMORS=" + carriers; }
+	
+	line = col[0];
+	for (unsigned int c = 1; c < col.size(); ++c) { line += "\t" + col[c]; }
+	return line + "\n";
+}
+
+// genotype and coverage of one tumor of a multi-tumor run
+// (same fields as the TUMOR sample of printVCF)
+string Variant_t::printTumorVCF(unsigned int t) {
+	
+	const array<unsigned short,4> & c = tumors[t];
+	int tot_ref_cov = c[0] + c[1];
+	int tot_alt_cov = c[2] + c[3];
+	
+	return genotype(tot_ref_cov,tot_alt_cov) + ":" + 
+		itos(tot_ref_cov) + "," + itos(tot_alt_cov) + ":" + 
+		itos(c[0]) + "," + itos(c[1]) + ":" + 
+		itos(c[2]) + "," + itos(c[3]) + ":" + 
+		itos(tot_ref_cov+tot_alt_cov);
+}
 
 string Variant_t::printVcfWithoutFilters() {
 	//CHROM  POS     ID      REF     ALT     QUAL    FILTER  INFO    FORMAT  Pat4-FF-Normal-DNA      Pat4-FF-Tumor-DNA
@@ -402,6 +447,91 @@ string Variant_t::printVcfWithoutFilters() {
 
 
 
+// parse a variant printed by printVCF in shard mode
+// returns false if the line is not a valid variant record
+//////////////////////////////////////////////////////////////
+bool Variant_t::parseVCF(const string & line, bool mode) {
+
+	LR_MODE = mode;
+
+	vector<string> col;
+	istringstream iss(line);
+	string field;
+	while ( getline(iss, field, '\t') ) { col.push_back(field); }
+	if(col.size() < 11) { return false; }
+
+	chr = col[0];
+	pos = atoi(col[1].c_str());
+	ref = col[3];
+	alt = col[4];
+	if(chr.empty() || pos <= 0 || ref.empty() || alt.empty()) { return false; }
+	prev_bp_ref = prev_bp_alt = ref[0];
+
+	// INFO
+	bool svc_found = false;
+	istringstream info(col[7]);
+	while ( getline(info, field, ';') ) {
+		size_t eq = field.find('=');
+		string key = field.substr(0, eq);
+		string value = (eq == string::npos) ? "" : field.substr(eq+1);
+
+		if(key == "TYPE") {
+			if(value == "ins") { type = 'I'; }
+			else if(value == "del") { type = 'D'; }
+			else if(value == "snv") { type = 'S'; }
+			else if(value == "complex") { type = 'C'; }
+		}
+		else if(key == "LEN") { len = atoi(value.c_str()); }
+		else if(key == "KMERSIZE") { kmer = atoi(value.c_str()); }
+		else if(key == "MS") { str = value; }
+		else if(key == "SVC") { similar_variants_count = atoi(value.c_str()); svc_found = true; }
+		else if(key == "SK") { isSomatic = (value == "1"); }
+	}
+	if(type == '?' || !svc_found) { return false; }
+
+	// FORMAT
+	vector<string> keys;
+	istringstream fmt(col[8]);
+	while ( getline(fmt, field, ':') ) { keys.push_back(field); }
+
+	for (int s = 0; s < 2; ++s) {
+
+		bool normal = (s == 0);
+		istringstream sample(col[9+s]);
+		for (unsigned int k = 0; k < keys.size() && getline(sample, field, ':'); ++k) {
+
+			if(keys[k] == "BX") {
+				size_t comma = field.find(',');
+				string bx_ref = field.substr(0, comma);
+				string bx_alt = (comma == string::npos) ? "" : field.substr(comma+1);
+				if(normal) { bxset_ref_N = bx_ref; bxset_alt_N = bx_alt; }
+				else { bxset_ref_T = bx_ref; bxset_alt_T = bx_alt; }
+				continue;
+			}
+
+			vector<int> v;
+			istringstream values(field);
+			string n;
+			while ( getline(values, n, ',') ) { v.push_back(atoi(n.c_str())); }
+
+			if(keys[k] == "SR" && v.size() == 2) {
+				if(normal) { ref_cov_normal_fwd = v[0]; ref_cov_normal_rev = v[1]; }
+				else { ref_cov_tumor_fwd = v[0]; ref_cov_tumor_rev = v[1]; }
+			}
+			else if(keys[k] == "SA" && v.size() == 2) {
+				if(normal) { alt_cov_normal_fwd = v[0]; alt_cov_normal_rev = v[1]; }
+				else { alt_cov_tumor_fwd = v[0]; alt_cov_tumor_rev = v[1]; }
+			}
+			else if( (keys[k] == "HPR" || keys[k] == "HPA") && v.size() == 3) {
+				array<unsigned short,3> & HP = (keys[k] == "HPR") ? (normal ? HPRN : HPRT) : (normal ? HPAN : HPAT);
+				HP[0] = v[0]; HP[1] = v[1]; HP[2] = v[2];
+			}
+		}
+	}
+
+	return true;
+}
+
 // compute genotype info in VCF format (GT field)
 //////////////////////////////////////////////////////////////
 string Variant_t::genotype(int R, int A) {
@@ -27,6 +27,7 @@
 *************************** /COPYRIGHT **************************************/
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <limits>
 #include <algorithm>
@@ -103,6 +104,8 @@ public:
 	string bxset_alt_N;
 	string bxset_alt_T;
 	
+	vector< array<unsigned short,4> > tumors; // ref fwd, ref rev, alt fwd, alt rev of each tumor (multi-tumor mode)
+	
 	char prev_bp_ref; // base-pair preceding the mutation in reference
 	char prev_bp_alt; // base-pair preceding the mutation in alternative
 	
@@ -185,7 +188,17 @@ public:
 		//reGenotype();
 	}
 	
-	string printVCF(Filters * fs);
+	// empty variant (filled by parseVCF)
+	Variant_t() : LR_MODE(false), isSomatic(false), kmer(0), similar_variants_count(1), pos(0), type('?'), len(0), status('?'),
+		ref_cov_normal_fwd(0), ref_cov_normal_rev(0), ref_cov_tumor_fwd(0), ref_cov_tumor_rev(0),
+		alt_cov_normal_fwd(0), alt_cov_normal_rev(0), alt_cov_tumor_fwd(0), alt_cov_tumor_rev(0),
+		HPRN({{0,0,0}}), HPRT({{0,0,0}}), HPAN({{0,0,0}}), HPAT({{0,0,0}}), prev_bp_ref('N'), prev_bp_alt('N')
+		{ }
+	
+	string printVCF(Filters * fs, bool shard = false);
+	string printMultiVCF(Filters * fs);
+	string printTumorVCF(unsigned int t);
+	bool parseVCF(const string & line, bool mode);
 	string printVcfWithoutFilters();
 	string genotype(int R, int A);
 	char bestState(int Rn, int An, int Rt, int At);
@@ -27,6 +27,9 @@
 // add variant to DB and update counts per position
 void VariantDB_t::addVar(const Variant_t & v) {
 	
+	++num_added;
+	if(record) { recorded.push_back(v); }
+	
 	string key = itos(v.isSomatic) + sha256(v.getSignature());
 	// string key = sha256(v.getSignature());
     map<string,Variant_t>::iterator it_v = DB.find(key);	
@@ -56,7 +59,8 @@ void VariantDB_t::addVar(const Variant_t & v) {
 		// update count
 		// unsigned short svc = it_v->second.similar_variants_count;
 		it_v->second.similar_variants_count ++;
-		if(old_tot_cov < new_tot_cov) {
+		// (ties broken on the coverage of each tumor in multi-tumor mode)
+		if( (old_tot_cov < new_tot_cov) || ((old_tot_cov == new_tot_cov) && (it_v->second.tumors < v.tumors)) ) {
 			/*
 			// if somatic status not match and less than cover_ratio, give up update variant.
 			cerr << "old_tot_cov * cover_ratio: " << old_tot_cov * cover_ratio << endl;
@@ -94,6 +98,8 @@ void VariantDB_t::addVar(const Variant_t & v) {
 			it_v->second.HPAN = v.HPAN;
 			it_v->second.HPAT = v.HPAT;
 			
+			it_v->second.tumors = v.tumors;
+			
 			if(LR_MODE) {
 				it_v->second.bxset_ref_N = v.bxset_ref_N;
 				it_v->second.bxset_ref_T = v.bxset_ref_T;
@@ -209,7 +215,7 @@ void VariantDB_t::selectVar() {
 }
 
 
-void VariantDB_t::printHeader(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T) {
+void VariantDB_t::printHeader(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T, ostream & out) {
 	
     stringstream hdr;
 	
@@ -229,6 +235,15 @@ void VariantDB_t::printHeader(const string version, const string reference, char
 			"##INFO=<ID=LEN,Number=1,Type=Integer,Description=\"Variant size in base pairs\">\n"
 			"##INFO=<ID=TYPE,Number=1,Type=String,Description=\"Variant type (snv, del, ins, complex)\">\n";
 	
+	if(shard > 0) {
+		hdr << "##INFO=<ID=SVC,Number=1,Type=Integer,Description=\"Number of windows reporting the variant (shard output)\">\n"
+			   "##INFO=<ID=SK,Number=1,Type=Integer,Description=\"Somatic flag assigned during the assembly (shard output)\">\n";
+	}
+	
+	if(num_tumors > 1) {
+		hdr << "##INFO=<ID=TUMORS,Number=.,Type=Integer,Description=\"Tumor samples (1-based, in sample order) with reads supporting the variant\">\n";
+	}
+	
 	if(LR_MODE)	{
 		hdr << "##INFO=<ID=HPS,Number=1,Type=Float,Description=\"Haplotype score for the T/N pair: phred-scaled p-value of the Fisher's exact test of the total counts of the two haplotype in the tumor-normal pair\">\n"
 			   "##INFO=<ID=HPSN,Number=1,Type=Float,Description=\"Normal haplotype score: phred-scaled p-value of the Fisher's exact test for ref/alt haplotype counts in the normal\">\n"
@@ -264,17 +279,19 @@ void VariantDB_t::printHeader(const string version, const string reference, char
 			   "##FORMAT=<ID=HPA,Number=.,Type=Integer,Description=\"Haplotype counts for alt: # of reads supporting alternative allele in haplotype 1, 2, and 0 respectively (0 = unassigned)\">\n";
 	}
 	
+	if(shard > 0) { printShardHeader(hdr, fs); }
+	
 	hdr << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" << sample_name_N << "\t" << sample_name_T << "\n";
 	
-	cout << hdr.str();
+	out << hdr.str();
 }
 
 // print variant in VCF format
-void VariantDB_t::printToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T) {
+void VariantDB_t::printToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T, ostream & out) {
 	
 	cerr << "Export variants to VCF file" << endl;
 	
-	printHeader(version,reference,date,fs,sample_name_N,sample_name_T);
+	printHeader(version,reference,date,fs,sample_name_N,sample_name_T,out);
 	
 	// dump map content to vector for custom sorting
 	vector< pair<string,Variant_t> > myVec(DB.begin(), DB.end());
@@ -292,7 +309,47 @@ void VariantDB_t::printToVCF(const string version, const string reference, char
 		//string pos = (it->second).getPosition();
 	    //unordered_map<string,int>::iterator itp = nCNT.find(pos);
 		//if (itp == nCNT.end()) { // print variant if no muations in the normal at locus
-			cout << it->second.printVCF(filters);
+			out << it->second.printVCF(filters, (shard > 0));
 		//}
 	}	
 }
+
+// print the variants of several tumors against the same normal in a
+// multi-sample VCF (see Variant_t::printMultiVCF)
+void VariantDB_t::printMultiToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, vector<string> &sample_names_T, ostream & out) {
+	
+	cerr << "Export variants to VCF file" << endl;
+	
+	unsigned int N = sample_names_T.size();
+	
+	string samples = sample_names_T[0];
+	for (unsigned int t = 1; t < N; ++t) { samples += "\t" + sample_names_T[t]; }
+	num_tumors = N;
+	printHeader(version,reference,date,fs,sample_name_N,samples,out);
+	
+	// dump map content to vector for custom sorting
+	vector< pair<string,Variant_t> > myVec(DB.begin(), DB.end());
+	// sort based on chromosome location
+	sort(myVec.begin(),myVec.end(),byPos());
+
+	vector< pair<string,Variant_t> >::iterator it;
+	for (it=myVec.begin(); it!=myVec.end(); ++it) {
+		out << it->second.printMultiVCF(filters);
+	}
+}
+
+// shard id and filter thresholds needed by lancet merge
+void VariantDB_t::printShardHeader(stringstream & hdr, Filters &fs) {
+
+	stringstream fss;
+	fss.precision(17);
+	fss << "minPhredFisherSTR=" << fs.minPhredFisherSTR << ",minPhredFisher=" << fs.minPhredFisher <<
+		",maxVafNormal=" << fs.maxVafNormal << ",minVafTumor=" << fs.minVafTumor <<
+		",minCovNormal=" << fs.minCovNormal << ",maxCovNormal=" << fs.maxCovNormal <<
+		",minCovTumor=" << fs.minCovTumor << ",maxCovTumor=" << fs.maxCovTumor <<
+		",minAltCntTumor=" << fs.minAltCntTumor << ",maxAltCntNormal=" << fs.maxAltCntNormal <<
+		",minStrandBias=" << fs.minStrandBias;
+
+	hdr << "##lancetShard=<ID=" << shard << ",Shards=" << num_shards << ",LinkedReads=" << LR_MODE << ">\n"
+		   "##lancetShardFilters=<" << fss.str() << ">\n";
+}
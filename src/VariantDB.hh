@@ -64,17 +64,28 @@ public:
 
 	Filters * filters; // filter thresholds
 
-	VariantDB_t(bool lrmode = false) { LR_MODE = lrmode; }
+	int shard; // shard printed by this run (1-based, 0 if not sharded)
+	int num_shards;
+	
+	bool record; // keep a copy of the variants added (for the journal)
+	vector<Variant_t> recorded;
+	unsigned long num_added; // number of variants added (including duplicates)
+	int num_tumors; // number of tumor samples printed (multi-tumor mode)
+
+	VariantDB_t(bool lrmode = false) { LR_MODE = lrmode; shard = 0; num_shards = 0; record = false; num_added = 0; num_tumors = 1; }
 
 	int getNumVariants() {return DB.size(); }
 	
 	void setLRmode (bool lrmode) { LR_MODE = lrmode; }
 	void setFilters (Filters * fs) { filters = fs; }
 	void setCommandLine(string cl) { command_line = cl; }
+	void setShard(int s, int n) { shard = s; num_shards = n; }
 	void addVar(const Variant_t & v);
 	void selectVar();
-	void printHeader(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T);
-	void printToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T);
+	void printHeader(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T, ostream & out = cout);
+	void printShardHeader(stringstream & hdr, Filters &fs);
+	void printToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, string &sample_name_T, ostream & out = cout);
+	void printMultiToVCF(const string version, const string reference, char * date, Filters &fs, string &sample_name_N, vector<string> &sample_names_T, ostream & out = cout);
 };
 
 #endif
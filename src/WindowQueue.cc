@@ -0,0 +1,569 @@
+#include "WindowQueue.hh"
+
+/****************************************************************************
+** WindowQueue.cc
+**
+** Shared queue of windows to analyze. Worker threads claim chunks of
+** consecutive windows through an atomic cursor, so idle threads keep
+** picking up pending work until the whole queue is drained
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+// addRegion : add a region to the queue (windows are generated on demand)
+// returns the number of windows in the region
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::addRegion(const string & chr, int refid, int start, int len) {
+
+	Block_t block(chr, refid, start, len, window_size);
+	block.num_windows = countWindows(len, window_size);
+	block.first_window = num_windows;
+
+	if(block.num_windows > 0) {
+		blocks.push_back(block);
+		num_windows += block.num_windows;
+	}
+
+	return block.num_windows;
+}
+
+// number of overlapping windows (one every WINDOW_STEP bp) in a region
+// of length len, the last window is truncated at the end of the region
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::countWindows(int len, int wsize) {
+
+	if(len <= 0) { return 0; }
+
+	// windows up to the first one reaching the end of the region
+	int last = 0;
+	if(len > wsize) { last = (len - wsize + WINDOW_STEP - 1) / WINDOW_STEP; }
+
+	// window starts must lie within the region
+	int max_last = (len - 1) / WINDOW_STEP;
+	if(last > max_last) { last = max_last; }
+
+	return last + 1;
+}
+
+// length of the window starting at offset in a region of length len
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::windowLength(int len, int offset, int wsize) {
+
+	if( (offset + wsize) >= len ) { return (len - offset - 1); }
+	return wsize;
+}
+
+// recompute the index of the first window of each region
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::indexBlocks() {
+
+	num_windows = 0;
+	for (unsigned int i = 0; i < blocks.size(); ++i) {
+		blocks[i].first_window = num_windows;
+		num_windows += blocks[i].num_windows;
+	}
+}
+
+// sort regions in genomic order (keeps load order for ties)
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::sortByPosition() {
+	stable_sort(blocks.begin(), blocks.end(), byRefPos());
+	indexBlocks();
+}
+
+// selectShard : keep only the windows of shard (1-based) out of num_shards
+// the windows in genomic order are split into num_shards consecutive ranges
+// with the same number of windows (or the same estimated cost, if
+// available): every window belongs to exactly one shard
+// and is built exactly as in the unsharded run, so the union of the shards
+// covers the input once (variants in the overlap of two shards are
+// deduplicated by lancet merge)
+// returns the number of windows in the shard
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::selectShard(int shard, int num_shards) {
+
+	long first = ((long)num_windows * (shard-1)) / num_shards;
+	long last = ((long)num_windows * shard) / num_shards;
+
+	if(!cost.empty()) {
+		double total = 0;
+		for (int w = 0; w < num_windows; ++w) { total += cost[w]; }
+
+		// first window past the cumulative cost of the previous shards
+		double sum = 0;
+		first = last = num_windows;
+		for (int w = 0; w < num_windows; ++w) {
+			if( (first == num_windows) && (sum >= total * (shard-1) / num_shards) ) { first = w; }
+			if( (shard < num_shards) && (sum >= total * shard / num_shards) ) { last = w; break; }
+			sum += cost[w];
+		}
+		if(shard == 1) { first = 0; }
+		if(last < first) { last = first; }
+
+		vector<double> selected_cost(cost.begin() + first, cost.begin() + last);
+		cost.swap(selected_cost);
+	}
+
+	vector<Block_t> selected;
+	for (unsigned int b = 0; b < blocks.size(); ++b) {
+
+		Block_t & block = blocks[b];
+		int i = first - block.first_window;
+		int j = last - block.first_window;
+		if(i < 0) { i = 0; }
+		if(j > block.num_windows) { j = block.num_windows; }
+		if(i >= j) { continue; }
+
+		// cut the region at the first window of the range: the windows
+		// keep their coordinates and length
+		int offset = i * WINDOW_STEP;
+		Block_t piece(block.chr, block.refid, block.start + offset, block.len - offset, block.wsize);
+		piece.num_windows = j - i;
+		selected.push_back(piece);
+	}
+
+	blocks.swap(selected);
+	active.clear();
+	indexBlocks();
+
+	return num_windows;
+}
+
+// pruneWindows : drop the windows without alignments in the BAM indexes,
+// or with less than min_bytes estimated compressed bytes of alignments,
+// before any read is decoded (the runs of windows left in each region keep
+// their coordinates and length)
+// returns the number of windows pruned
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::pruneWindows(CostModel_t & model, double min_bytes) {
+
+	int total = num_windows;
+	vector<double> kept_cost;
+	vector<Block_t> kept;
+
+	for (unsigned int b = 0; b < blocks.size(); ++b) {
+
+		Block_t & block = blocks[b];
+		int k = 0;
+		while (k < block.num_windows) {
+
+			// run of windows with alignments [i,k)
+			int i = k;
+			while (k < block.num_windows) {
+				int offset = k * WINDOW_STEP;
+				int len = windowLength(block.len, offset, block.wsize);
+				if(!model.windowHasAlignments(block.refid, block.start + offset, len)) { break; }
+				if( (min_bytes > 0) && (model.windowBytes(block.refid, block.start + offset, len) < min_bytes) ) { break; }
+				++k;
+			}
+
+			if(k > i) {
+				// cut the region right after the last window of the run
+				int offset = i * WINDOW_STEP;
+				int len = block.len - offset;
+				if(k < block.num_windows) { len = (k-1-i) * WINDOW_STEP + block.wsize + 1; }
+
+				Block_t piece(block.chr, block.refid, block.start + offset, len, block.wsize);
+				piece.num_windows = k - i;
+				kept.push_back(piece);
+
+				if(!cost.empty()) { kept_cost.insert(kept_cost.end(), cost.begin() + block.first_window + i, cost.begin() + block.first_window + k); }
+			}
+
+			if(k < block.num_windows) { ++k; } // pruned window
+		}
+	}
+
+	blocks.swap(kept);
+	cost.swap(kept_cost);
+	active.clear();
+	indexBlocks();
+
+	return total - num_windows;
+}
+
+// signature of the list of windows (identifies the windows of a run)
+//////////////////////////////////////////////////////////////
+string WindowQueue_t::signature() {
+
+	stringstream ss;
+	ss << window_size << ":" << WINDOW_STEP;
+	for (unsigned int b = 0; b < blocks.size(); ++b) {
+		Block_t & block = blocks[b];
+		ss << "|" << block.chr << ":" << block.start << ":" << block.len << ":" << block.wsize << ":" << block.num_windows;
+	}
+
+	return sha256(ss.str());
+}
+
+// estimate the cost of each window
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::estimateCosts(CostModel_t & model) {
+
+	cost.assign(num_windows, 0);
+	for (unsigned int b = 0; b < blocks.size(); ++b) {
+		Block_t & block = blocks[b];
+		for (int k = 0; k < block.num_windows; ++k) {
+			int offset = k * WINDOW_STEP;
+			cost[block.first_window + k] = model.windowCost(block.chr, block.refid, block.start + offset, windowLength(block.len, offset, block.wsize));
+		}
+	}
+}
+
+// set the chunk size: consecutive windows share most of their reads, so
+// keep them together, but leave enough chunks to balance the threads
+// if the window costs are known, the most expensive chunks are claimed first
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::setChunkSize(int num_threads) {
+
+	if(num_threads < 1) { num_threads = 1; }
+
+	chunk_size = num_windows / (4*num_threads);
+	if(chunk_size > MAX_CHUNK_SIZE) { chunk_size = MAX_CHUNK_SIZE; }
+	if(chunk_size < 1) { chunk_size = 1; }
+
+	num_chunks = (num_windows + chunk_size - 1) / chunk_size;
+
+	chunk_order.clear();
+	if(!cost.empty()) {
+		vector< pair<double,int> > chunks;
+		for (int c = 0; c < num_chunks; ++c) {
+			double chunk_cost = 0;
+			for (int w = c*chunk_size; w < min((c+1)*chunk_size, num_windows); ++w) {
+				if(needsWork(w)) { chunk_cost += cost[w]; }
+			}
+			chunks.push_back(make_pair(-chunk_cost, c));
+		}
+		stable_sort(chunks.begin(), chunks.end(), byFirst());
+		for (int c = 0; c < num_chunks; ++c) { chunk_order.push_back(chunks[c].second); }
+	}
+}
+
+// split the chunks across n NUMA nodes: each node gets a contiguous range
+// of the genome (claimed in the same order as before within the range),
+// so the threads of a node share the reads and reference of their range
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::setNodes(int n) {
+
+	if(n < 1) { n = 1; }
+	if(n > MAX_NUMA_NODES) { n = MAX_NUMA_NODES; }
+	num_nodes = n;
+	if(num_nodes == 1) { node_begin.clear(); return; }
+
+	if(chunk_order.empty()) {
+		for (int c = 0; c < num_chunks; ++c) { chunk_order.push_back(c); }
+	}
+
+	vector< pair<double,int> > chunks;
+	for (int i = 0; i < num_chunks; ++i) {
+		int c = chunk_order[i];
+		chunks.push_back(make_pair(((long)c * num_nodes) / num_chunks, c));
+	}
+	stable_sort(chunks.begin(), chunks.end(), byFirst());
+
+	node_begin.assign(num_nodes + 1, num_chunks);
+	for (int i = num_chunks - 1; i >= 0; --i) {
+		chunk_order[i] = chunks[i].second;
+		node_begin[(int)chunks[i].first] = i;
+	}
+	for (int k = num_nodes - 1; k >= 0; --k) {
+		if(node_begin[k] > node_begin[k+1]) { node_begin[k] = node_begin[k+1]; } // node without chunks
+	}
+	for (int k = 0; k < num_nodes; ++k) { node_cursor[k] = node_begin[k]; }
+}
+
+// claim the next chunk of windows [first,last)
+// with NUMA nodes, the chunks of the given node are claimed first, then
+// the remaining chunks of the other nodes
+// returns false when there are no more windows to process
+//////////////////////////////////////////////////////////////
+bool WindowQueue_t::nextChunk(int & first, int & last, int node) {
+
+	if(stopped.load()) { return false; }
+
+	int c = -1;
+	if(num_nodes > 1) {
+		for (int k = 0; k < num_nodes; ++k) {
+			int n = (node + k) % num_nodes;
+			if(node_cursor[n].load() >= node_begin[n+1]) { continue; }
+			int i = node_cursor[n].fetch_add(1);
+			if(i < node_begin[n+1]) { c = chunk_order[i]; break; }
+		}
+		if(c < 0) { return false; }
+	}
+	else {
+		c = cursor.fetch_add(1);
+		if(c >= num_chunks) { return false; }
+		if(!chunk_order.empty()) { c = chunk_order[c]; }
+	}
+
+	first = c * chunk_size;
+	last = first + chunk_size;
+	if(last > num_windows) { last = num_windows; }
+
+	return true;
+}
+
+// defer a window to the end of the run
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::defer(int w) {
+
+	pthread_mutex_lock(&deferred_lock);
+	deferred.push_back(w);
+	pthread_mutex_unlock(&deferred_lock);
+}
+
+// claim the next deferred window
+// (threads check the deferred windows after the queue is drained, a thread
+// always checks them after deferring its own windows)
+// returns false if there are no deferred windows left
+//////////////////////////////////////////////////////////////
+bool WindowQueue_t::nextDeferred(int & w) {
+
+	pthread_mutex_lock(&deferred_lock);
+	bool found = !deferred.empty() && !stopped.load();
+	if(found) {
+		w = deferred.front();
+		deferred.erase(deferred.begin());
+	}
+	pthread_mutex_unlock(&deferred_lock);
+
+	return found;
+}
+
+// loadWindows : build the windows [first,last) of a claimed chunk
+// the reference sequence is fetched once for each region spanned by the chunk
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::loadWindows(int first, int last, RefProvider_t * reference, int K, vector<Ref_t *> & refs) {
+
+	// find the region containing the first window
+	unsigned int b = 0;
+	unsigned int lo = 0;
+	unsigned int hi = blocks.size();
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if(blocks[mid].first_window <= first) { b = mid; lo = mid+1; }
+		else { hi = mid; }
+	}
+
+	int w = first;
+	while (w < last && b < blocks.size()) {
+
+		Block_t & block = blocks[b];
+
+		// windows of this chunk falling in the current region
+		int i = w - block.first_window;
+		int j = last - block.first_window;
+		if(j > block.num_windows) { j = block.num_windows; }
+
+		// fetch the reference sequence spanned by the windows to process in [i,j) at once
+		int a = i;
+		int z = j;
+		while ( (a < z) && !needsWork(block.first_window + a) ) { ++a; }
+		while ( (z > a) && !needsWork(block.first_window + z - 1) ) { --z; }
+		
+		int span_start = a * WINDOW_STEP;
+		int span_end = span_start;
+		if(z > a) { span_end = (z-1) * WINDOW_STEP + windowLength(block.len, (z-1) * WINDOW_STEP, block.wsize); }
+
+		// (in upper case, with the IUPAC ambiguos codes changed to Ns)
+		string s;
+		if(span_end > span_start) {
+			int p_beg = block.start - 1 + span_start; // 0-based coordinates
+			int p_end = block.start - 1 + span_end - 1;
+			if ( !reference->fetch(block.chr, p_beg, p_end, s) ) {
+				cerr << "Failed to fetch sequence in " << block.chr << ":" << (p_beg+1) << "-" << (p_end+1) << endl;
+			}
+		}
+
+		for (int k = i; k < j; ++k) {
+
+			// no evidence of variation in the pre-scan or already completed
+			if(!needsWork(block.first_window + k)) { refs.push_back(NULL); continue; }
+
+			int offset = k * WINDOW_STEP;
+			int LEN = windowLength(block.len, offset, block.wsize);
+			string ss;
+			if((unsigned int)(offset - span_start) < s.length()) { ss = s.substr(offset - span_start, LEN); }
+
+			Ref_t * ref = makeWindow(block.chr, block.refid, block.start + offset, LEN, ss, K);
+			refs.push_back(ref);
+		}
+
+		w = block.first_window + j;
+		++b;
+	}
+}
+
+// make a new reference window of length LEN starting at start
+//////////////////////////////////////////////////////////////
+Ref_t * WindowQueue_t::makeWindow(const string & chr, int refid, int start, int LEN, const string & seq, int K) {
+
+	Ref_t * ref = new Ref_t(K);
+
+	ref->refchr   = chr;
+	ref->refid    = refid;
+	ref->refstart = start;
+	ref->refend   = ref->refstart + LEN;
+
+	string hdr = ref->refchr;
+	hdr += ":";
+	hdr += itos(ref->refstart);
+	hdr += "-";
+	hdr += itos(ref->refend);
+
+	ref->setHdr(hdr);
+	ref->setSeq(seq);
+	ref->setRawSeq(seq);
+
+	ref->hdr = hdr;
+
+	return ref;
+}
+
+// splitWindow : split a (merged) window into the standard overlapping windows
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::splitWindow(Ref_t * region, int K, vector<Ref_t *> & refs) {
+
+	int len = region->rawseq.length() + 1;
+	int n = countWindows(len, window_size);
+
+	for (int k = 0; k < n; ++k) {
+		int offset = k * WINDOW_STEP;
+		int LEN = windowLength(len, offset, window_size);
+		refs.push_back(makeWindow(region->refchr, region->refid, region->refstart + offset, LEN, region->rawseq.substr(offset, LEN), K));
+	}
+}
+
+// markActive : mark the windows of region b that contain a locus with
+// evidence of mutation (loci can lie up to overhang bp past the window end)
+// returns the number of active windows in the region
+//////////////////////////////////////////////////////////////
+int WindowQueue_t::markActive(int b, const vector<int> & hot, int overhang, bool all) {
+
+	if(active.empty()) { active.assign(num_windows, false); }
+
+	Block_t & block = blocks[b];
+	int num_active = 0;
+	for (int k = 0; k < block.num_windows; ++k) {
+
+		int offset = k * WINDOW_STEP;
+		int L = block.start + offset;
+		int R = L + windowLength(block.len, offset, block.wsize);
+
+		vector<int>::const_iterator it = lower_bound(hot.begin(), hot.end(), L);
+		bool flag = all || ( (it != hot.end()) && ((*it) <= R + overhang) );
+
+		active[block.first_window + k] = flag;
+		if(flag) { ++num_active; }
+	}
+
+	return num_active;
+}
+
+// mergeActive : replace runs of consecutive active windows with larger
+// assembly regions centred on the loci with evidence of mutation
+// (hot[b] are the sorted loci with evidence in region b)
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::mergeActive(const vector< vector<int> > & hot, int max_len) {
+
+	vector<Block_t> merged;
+
+	for (unsigned int b = 0; b < blocks.size(); ++b) {
+
+		Block_t & block = blocks[b];
+		int k = 0;
+		while (k < block.num_windows) {
+
+			if(!isActive(block.first_window + k)) { ++k; continue; }
+
+			// run of active windows [k0,k)
+			int k0 = k;
+			while ( (k < block.num_windows) && isActive(block.first_window + k) ) { ++k; }
+
+			int L = block.start + k0 * WINDOW_STEP;
+			int R = block.start + (k-1) * WINDOW_STEP + windowLength(block.len, (k-1) * WINDOW_STEP, block.wsize);
+
+			// centre the region on the cluster of loci with evidence
+			vector<int>::const_iterator lo = lower_bound(hot[b].begin(), hot[b].end(), L);
+			vector<int>::const_iterator hi = upper_bound(hot[b].begin(), hot[b].end(), R);
+			if(lo != hi) {
+				int first_locus = *lo;
+				int last_locus = *(hi-1);
+				int half = window_size / 2;
+				int mid = (first_locus + last_locus) / 2;
+
+				int nL = first_locus - half;
+				int nR = last_locus + half;
+				if(nR - nL < window_size) { nL = mid - half; nR = nL + window_size; }
+				if(nL < L) { nL = L; }
+				if(nR > R) { nR = R; }
+				L = nL;
+				R = nR;
+			}
+
+			addMerged(merged, block, L, R, max_len);
+		}
+	}
+
+	blocks.swap(merged);
+	active.clear();
+	cost.clear();
+	indexBlocks();
+}
+
+// add region [L,R] to the merged regions, split in pieces of at most max_len
+// overlapping like the standard windows if it is too long
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::addMerged(vector<Block_t> & merged, const Block_t & block, int L, int R, int max_len) {
+
+	if(R <= L) { return; }
+
+	int overlap = window_size - WINDOW_STEP;
+	if(max_len <= overlap) { max_len = overlap + WINDOW_STEP; }
+
+	int start = L;
+	while (true) {
+		int end = start + max_len;
+		if(end > R) { end = R; }
+
+		// one window covering the whole region
+		Block_t piece(block.chr, block.refid, start, end - start + 1, end - start + 1);
+		piece.num_windows = 1;
+		merged.push_back(piece);
+
+		if(end >= R) { break; }
+		start = end - overlap;
+	}
+}
+
+// mark one window as done and report progress across all threads
+//////////////////////////////////////////////////////////////
+void WindowQueue_t::windowDone(int ID, int num_variants) {
+
+	int N = num_windows;
+	int cnt = ++done;
+
+	int progress = (int)floor(100*(double(cnt)/(double)N));
+	int old_progress = last_progress.load();
+	while (progress > old_progress) {
+		if(last_progress.compare_exchange_weak(old_progress, progress)) {
+			cerr << "Thread " << ID << ": " << progress << "\% of windows done, with " << num_variants << " variants collected so far by this thread." << endl;
+			break;
+		}
+	}
+}
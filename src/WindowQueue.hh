@@ -0,0 +1,155 @@
+#ifndef WINDOWQUEUE_HH
+#define WINDOWQUEUE_HH 1
+
+/****************************************************************************
+** WindowQueue.hh
+**
+** Shared queue of windows to analyze. Worker threads claim chunks of
+** consecutive windows through an atomic cursor, so idle threads keep
+** picking up pending work until the whole queue is drained.
+** Only the region boundaries are kept in memory: the reference sequence
+** of each window is loaded when its chunk is claimed
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <pthread.h>
+
+#include "util.hh"
+#include "sha256.hh"
+#include "Ref.hh"
+#include "CostModel.hh"
+#include "RefProvider.hh"
+#include "Numa.hh"
+
+using namespace std;
+
+#define MAX_CHUNK_SIZE 16 // max number of consecutive windows claimed at once
+#define WINDOW_STEP 100 // distance (in bp) between the start of consecutive windows
+#define MAX_MERGED_WINDOWS 4 // max size of a merged assembly region (in window sizes)
+
+// Block_t
+// genomic region that is split into overlapping windows on demand
+//////////////////////////////////////////////////////////////////////////
+class Block_t
+{
+public:
+
+	string chr;
+	int refid; // reference id in the BAM header
+	int start; // 1-based start position of the region
+	int len; // length of the reference sequence of the region
+	int wsize; // size of the windows of the region (in bp)
+	int num_windows; // number of windows in the region
+	int first_window; // index of the first window of the region in the queue
+
+	Block_t(const string & chr_, int refid_, int start_, int len_, int wsize_)
+		: chr(chr_), refid(refid_), start(start_), len(len_), wsize(wsize_), num_windows(0), first_window(0) { }
+};
+
+// order regions by reference id and start position, so that each thread
+// sweeps forward through the BAM files instead of seeking back and forth
+struct byRefPos
+{
+	bool operator()(const Block_t & first, const Block_t & second) const {
+
+		// regions on chromosomes missing from the BAM header go last
+		unsigned int id1 = first.refid;
+		unsigned int id2 = second.refid;
+
+		if (id1 != id2) { return (id1 < id2); }
+		return (first.start < second.start);
+	}
+};
+
+// order pairs by the first element only (ties keep their order)
+struct byFirst
+{
+	bool operator()(const pair<double,int> & first, const pair<double,int> & second) const {
+		return (first.first < second.first);
+	}
+};
+
+class WindowQueue_t
+{
+public:
+
+	vector<Block_t> blocks; // regions to analyze
+	vector<bool> active; // windows that can be active (empty if not pre-scanned)
+	vector<bool> completed; // windows completed by a previous run (empty if not resumed)
+	vector<double> cost; // estimated cost of each window (empty if not estimated)
+
+	WindowQueue_t(int wsize) : window_size(wsize), num_windows(0), chunk_size(1), num_chunks(0), num_nodes(1), cursor(0), done(0), last_progress(0), stopped(false) { pthread_mutex_init(&deferred_lock, NULL); }
+	~WindowQueue_t() { pthread_mutex_destroy(&deferred_lock); }
+
+	int addRegion(const string & chr, int refid, int start, int len);
+	int size() { return num_windows; }
+	int numDone() { return done.load(); }
+
+	void sortByPosition();
+	int selectShard(int shard, int num_shards);
+	int pruneWindows(CostModel_t & model, double min_bytes);
+	void estimateCosts(CostModel_t & model);
+	void setChunkSize(int num_threads);
+	int getChunkSize() { return chunk_size; }
+	void setNodes(int n);
+	bool nextChunk(int & first, int & last, int node = 0);
+	void stop() { stopped = true; } // no more windows are handed out (a thread failed)
+	void defer(int w);
+	bool nextDeferred(int & w);
+	void loadWindows(int first, int last, RefProvider_t * reference, int K, vector<Ref_t *> & refs);
+	int markActive(int b, const vector<int> & hot, int overhang, bool all);
+	void mergeActive(const vector< vector<int> > & hot, int max_len);
+	void splitWindow(Ref_t * region, int K, vector<Ref_t *> & refs);
+	bool isActive(int w) { return active.empty() || active[w]; }
+	bool isCompleted(int w) { return !completed.empty() && completed[w]; }
+	void markCompleted(int w) { if(completed.empty()) { completed.assign(num_windows, false); } completed[w] = true; }
+	bool needsWork(int w) { return isActive(w) && !isCompleted(w); }
+	string signature();
+	void windowDone(int ID, int num_variants);
+
+private:
+
+	int window_size; // size of the windows (in bp)
+	int num_windows; // number of windows across all regions
+	int chunk_size; // number of consecutive windows per claim
+	int num_chunks;
+	vector<int> chunk_order; // order in which the chunks are claimed (empty: genomic order)
+	int num_nodes; // number of NUMA nodes the chunks are split across
+	vector<int> node_begin; // first position in chunk_order of the chunks of each node
+	atomic<int> cursor; // index of the next unclaimed chunk
+	atomic<int> node_cursor[MAX_NUMA_NODES]; // position of the next unclaimed chunk of each node
+	atomic<int> done; // number of windows processed so far
+	atomic<int> last_progress; // last progress percentage reported
+	atomic<bool> stopped; // the run is aborted
+	vector<int> deferred; // windows to retry at the end of the run
+	pthread_mutex_t deferred_lock;
+
+	int countWindows(int len, int wsize);
+	int windowLength(int len, int offset, int wsize);
+	void indexBlocks();
+	void addMerged(vector<Block_t> & merged, const Block_t & block, int L, int R, int max_len);
+	Ref_t * makeWindow(const string & chr, int refid, int start, int LEN, const string & seq, int K);
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef WINDOWREADS_HH
+#define WINDOWREADS_HH 1
+
+/****************************************************************************
+** WindowReads.hh
+**
+** Result of a single scan of the alignments of a window for one sample:
+** evidence of variation (mismatches, indels and soft-clips by locus) and
+** the filtered reads to be loaded in the graph if the window is active.
+** Above the maximum coverage the reads are downsampled while scanning:
+** only the reads with the lowest keys (hash of the read name) that fit in
+** the budget of bases are kept, so the sample is deterministic, independent
+** of the order of the files and keeps the two mates of a pair together
+**
+*****************************************************************************/
+
+/************************** COPYRIGHT ***************************************
+**
+** New York Genome Center
+**
+** SOFTWARE COPYRIGHT NOTICE AGREEMENT
+** This software and its documentation are copyright (2016) by the New York
+** Genome Center. All rights are reserved. This software is supplied without
+** any warranty or guaranteed support whatsoever. The New York Genome Center
+** cannot be responsible for its use, misuse, or functionality.
+**
+** Version: 1.0.0
+** Author: Giuseppe Narzisi
+**
+*************************** /COPYRIGHT **************************************/
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "api/BamAlignment.h"
+
+using namespace std;
+using namespace BamTools;
+
+// SelectedRead_t
+// alignment that passed the filters (owned by the read buffer)
+//////////////////////////////////////////////////////////////////////////
+class SelectedRead_t
+{
+public:
+	SelectedRead_t(BamAlignment * al_, int mate_, int strand_, bool mapped_, const string & bx_, int hp_, uint64_t key_, int order_, int len_)
+		: al(al_), mate(mate_), strand(strand_), mapped(mapped_), bx(bx_), hp(hp_), key(key_), order(order_), len(len_)
+		{ }
+
+	BamAlignment * al;
+	int mate;
+	int strand;
+	bool mapped;
+	string bx; // linked-read barcode
+	int hp; // 10x Haplotype number of the molecule that generated the read
+	uint64_t key; // downsampling key (same for both mates)
+	int order; // position in the scan
+	int len; // number of bases
+
+	// downsampling key of a read: FNV-1a hash of the name, with a final mix of the bits
+	static uint64_t nameKey(const string & name) {
+		uint64_t h = 14695981039346656037ULL;
+		for (size_t i = 0; i < name.length(); ++i) { h = (h ^ (unsigned char)name[i]) * 1099511628211ULL; }
+		h ^= h >> 33; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33;
+		return h;
+	}
+
+	static bool byKey(const SelectedRead_t & a, const SelectedRead_t & b) { return (a.key < b.key) || ((a.key == b.key) && (a.order < b.order)); }
+	static bool byOrder(const SelectedRead_t & a, const SelectedRead_t & b) { return a.order < b.order; }
+};
+
+class WindowReads_t
+{
+public:
+
+	// evidence of variation
+	map<int,int> mapX; // table with counts of all mismatches at a given locus
+	map<int,int> mapI; // table with counts of all insertions at a given locus
+	map<int,int> mapD; // table with counts of all deletion at a given locus
+	map<int,int> mapSC; // table with counts of all softclipped sequences starting at a given locus
+
+	// reads selected for the assembly
+	vector<SelectedRead_t> reads;
+	bool skip; // too much coverage
+	long totalreadbp;
+	long maxreadbp; // budget of bases of the selected reads (0 = no downsampling)
+	bool downsampled; // reads dropped to stay in the budget
+	uint64_t cutoff; // reads with this key or higher are dropped (once downsampled)
+	int num_downsampled;
+
+	// filter statistics
+	int num_unmapped;
+	int num_XA_read;
+	int num_XT_R_read;
+	int num_XT_M_read;
+	int num_high_softclip_read;
+	int num_high_XM_read;
+	int num_equal_AS_XS_read;
+	int tot_reads_window;
+
+	WindowReads_t() { clear(); }
+
+	// add a selected read: over the budget the reads are kept in a heap
+	// (highest key on top) and all the reads of the highest key are dropped,
+	// which lowers the cutoff for the next reads. The kept reads are the
+	// groups of lowest keys that fit in the budget, whatever the order of the
+	// scan, and the two mates of a pair (same key) are kept or dropped together
+	void add(const SelectedRead_t & r) {
+		if ( downsampled && (r.key >= cutoff) ) { ++num_downsampled; return; }
+
+		reads.push_back(r);
+		totalreadbp += r.len;
+
+		if (downsampled) { push_heap(reads.begin(), reads.end(), SelectedRead_t::byKey); }
+		else if ( (maxreadbp > 0) && (totalreadbp > maxreadbp) ) { make_heap(reads.begin(), reads.end(), SelectedRead_t::byKey); downsampled = true; }
+
+		while ( downsampled && (totalreadbp > maxreadbp) && !reads.empty() ) {
+			cutoff = reads.front().key;
+			while ( !reads.empty() && (reads.front().key == cutoff) ) {
+				pop_heap(reads.begin(), reads.end(), SelectedRead_t::byKey);
+				totalreadbp -= reads.back().len;
+				reads.pop_back();
+				++num_downsampled;
+			}
+		}
+	}
+
+	// end of the scan: the kept reads go back in scan order
+	void finish() {
+		if (downsampled) { sort(reads.begin(), reads.end(), SelectedRead_t::byOrder); }
+	}
+
+	void clear() {
+		mapX.clear(); mapI.clear(); mapD.clear(); mapSC.clear();
+		reads.clear();
+		skip = false;
+		totalreadbp = 0;
+		maxreadbp = 0;
+		downsampled = false;
+		cutoff = 0;
+		num_downsampled = 0;
+		num_unmapped = 0;
+		num_XA_read = 0;
+		num_XT_R_read = 0;
+		num_XT_M_read = 0;
+		num_high_softclip_read = 0;
+		num_high_XM_read = 0;
+		num_equal_AS_XS_read = 0;
+		tot_reads_window = 0;
+	}
+};
+
+#endif
@@ -413,11 +413,11 @@ bool seqAboveQual(string qv, int Q)
 
 
 // check for presence of MD tag in alignments, returns false if missing.
-bool checkPresenceOfMDtag(BamReader &reader) {
+bool checkPresenceOfMDtag(AlignmentReader_t &reader) {
 	BamAlignment al;
 	bool ans = true;
 	
-	if(reader.GetNextAlignment(al)) {
+	if(reader.getNextAlignment(al)) {
 		//cerr << "Name: " << al.Name << endl; 
 		ans = al.HasTag("MD"); // get string of mismatching positions
 	}
@@ -482,6 +482,44 @@ void parseMD(string & md, map<int,int> & M, int start, string & qual, int min_qv
 	//cerr << num << "\t" << md << "\t" << rpos << "?" << qual.length() << endl;
 }
 
+// collect evidence of mutations from the alignment (CIGAR and MD)
+// add mismatches, insertions, deletions and soft-clips locations to the maps
+// (positions are never smaller than the alignment start position)
+//////////////////////////////////////////////////////////////////////////
+void collectEvidence(BamAlignment &al, map<int,int> & mapX, map<int,int> & mapI, map<int,int> & mapD, map<int,int> & mapSC, int min_qv) {
+	
+	string md = "";
+	int alstart = al.Position;
+	
+	// parse MD string
+	// String for mismatching positions. Regex : [0-9]+(([A-Z]|\^[A-Z]+)[0-9]+)*10
+	bool flag = al.GetTag("MD", md); // get string of mismatching positions
+	if(flag==true) { parseMD(md, mapX, alstart, al.Qualities, min_qv); }
+
+	// example: 31M1I17M1D37M
+	int pos = alstart; // initialize position to start of alignment
+	for (vector<CigarOp>::iterator it = (al.CigarData).begin() ; it != (al.CigarData).end(); ++it) {
+		char T = (*it).Type;
+		
+		// update position (except for insertions)
+		if(T!='I') { pos += (*it).Length; }
+		
+		if(T=='X') { ++mapX[pos]; }
+		if(T=='I') { ++mapI[pos]; }
+		if(T=='D') { ++mapD[pos]; }
+	}
+	
+	vector< int > clipSizes;
+	vector< int > readPositions; 
+	vector< int > genomePositions;
+	
+	if(al.GetSoftClips(clipSizes, readPositions, genomePositions)) {
+		for (vector<int>::iterator it = genomePositions.begin() ; it != genomePositions.end(); ++it) {
+			++mapSC[(*it)];
+		}
+	}
+}
+
 // extract tag from the SAM alignment using the appropiate number type
 float extract_sam_tag(const string &TAG, BamAlignment &al) {
 	
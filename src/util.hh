@@ -32,6 +32,8 @@
 
 #include "api/BamReader.h"
 
+#include "AlignmentReader.hh"
+
 using namespace BamTools;
 
 #ifdef UNICODE //Test to see if we're using wchar_ts or not.
@@ -86,8 +88,9 @@ bool isRepeat(const std::string & seq, int K);
 bool isAlmostRepeat(const std::string & seq, int K, int max);
 bool kMismatch(size_t s, size_t e, const std::string & t, size_t start, int max);
 bool seqAboveQual(std::string qv, int Q);
-bool checkPresenceOfMDtag(BamReader &reader);
+bool checkPresenceOfMDtag(AlignmentReader_t &reader);
 void parseMD(std::string & md, std::map<int,int> & map, int start, std::string & qual, int min_qv);
+void collectEvidence(BamAlignment &al, std::map<int,int> & mapX, std::map<int,int> & mapI, std::map<int,int> & mapD, std::map<int,int> & mapSC, int min_qv);
 float extract_sam_tag(const std::string &TAG, BamAlignment &al);
 bool findTandems(const std::string & seq, const std::string & tag, int max_unit_len, int min_report_units, int min_report_len, int dist_from_str, int pos, int & len, std::string & motif);
 